@@ -0,0 +1,249 @@
+/**
+ * @file KittyBot.h
+ *
+ * @brief Bots for Kitty Crush in other processes, through shared memory
+ *
+ * "KittyCrush --bot <file>" hosts the games in a shared file (put it in /dev/shm). Two lock-free queues, with one
+ * writer and one reader each, live in the file : the bot pushes requests (new game, move, undo, redo, hint) and the
+ * game answers every request, in order, with the state of the board. Neither side takes a lock or makes a system call
+ * while it plays, so a round trip costs a few cache line transfers.
+ *
+ *		CBot Bot;
+ *		if (BotOpen (&Bot, "/dev/shm/kitty") != 0) return 1;		// No game hosted in the file
+ *		CBotRequest Request = { KBotNew, 0, 1, 0, 0, 0, 42 };		// Level 1, seed 42
+ *		BotSend (&Bot, &Request);
+ *		const CBotState * State = BotWait (&Bot);					// NULL if the game has stopped
+ *		... read State -> Cells, then choose a move
+ *		BotRelease (&Bot);
+ *		BotClose (&Bot);
+ *
+ * A bot may push several requests before reading the answers, up to KBotSlots. One bot at a time per file.
+ * C99 or C++ with gcc or clang, on Linux or macOS. With -std=c99 or -std=c11, include it before the system headers,
+ * or define _POSIX_C_SOURCE : the strict modes hide open, kill and sysconf.
+ */
+
+#ifndef KITTY_BOT_H
+#define KITTY_BOT_H
+
+#if defined (__STRICT_ANSI__) && ! defined (_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#if defined (__APPLE__) && ! defined (_DARWIN_C_SOURCE)
+#define _DARWIN_C_SOURCE	/* _SC_NPROCESSORS_ONLN */
+#endif
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define KBotVersion 1
+#define KBotSlots 16		/* Requests or states in flight in each queue, a power of two */
+#define KBotMaxCells 2048
+#define KBotSpins 1024		/* Busy waits before yielding the core, when the game runs on another one */
+
+/** @brief Actions of the requests */
+enum { KBotNew, KBotMove, KBotUndo, KBotRedo, KBotHint, KBotQuit };
+
+/** @brief What the game did with a request (Step of a state) */
+enum { KBotStarted, KBotPlayed, KBotRejected, KBotUndone, KBotRedone, KBotNothingToUndo, KBotNothingToRedo, KBotHinted,
+	   KBotNoHint };
+
+/** @brief Why the game is over (End of a state) */
+enum { KBotNotOver, KBotNoMovesLeft, KBotBlocked, KBotNoCandiesLeft };
+
+/** @brief A request of the bot */
+typedef struct
+{
+	uint8_t Action;
+	char Direction;		/* KBotMove : 'z' up, 's' down, 'a' left, 'e' right ('7', '9', '1', '3' with the diagonal rules) */
+	uint8_t Level;		/* KBotNew : from 1 to 4 */
+	uint8_t Reserved;
+	uint16_t Row;		/* KBotMove : the cell to move, from 0 */
+	uint16_t Column;
+	uint32_t Seed;		/* KBotNew : the same seed always gives the same grid */
+} CBotRequest;
+
+/** @brief The answer of the game to a request */
+typedef struct
+{
+	uint32_t Game;		/* Number of the game, from 1 */
+	uint32_t Score;
+	uint32_t Points;	/* Earned by the request */
+	uint16_t Size;		/* 0 before the first game */
+	uint16_t NbMoves;
+	uint16_t MaxTimes;
+	uint16_t NbCandies;
+	uint16_t HintRow;	/* KBotHinted : a move that scores */
+	uint16_t HintColumn;
+	char HintDirection;
+	uint8_t Step;
+	uint8_t End;
+	uint8_t Reshuffled;	/* No move was scoring any more : the grid has been reshuffled */
+	uint8_t Cells [KBotMaxCells];	/* Size * Size cells, row after row, 0 for an empty one */
+} CBotState;
+
+/** @brief Positions of a queue, each on its own cache line */
+typedef struct
+{
+	uint64_t Head;		/* Items pushed, written by the producer */
+	uint8_t HeadLine [56];
+	uint64_t Tail;		/* Items released, written by the consumer */
+	uint8_t TailLine [56];
+} CBotQueue;
+
+/** @brief The shared file */
+typedef struct
+{
+	char Magic [4];		/* "KCBT", written last by the game */
+	uint32_t Version;
+	uint32_t NbSlots;
+	uint32_t StateBytes;
+	int32_t Host;		/* Process of the game */
+	uint8_t HeaderLine [44];
+	CBotQueue Requests;
+	CBotQueue States;
+	CBotRequest RequestSlots [KBotSlots];
+	CBotState StateSlots [KBotSlots];
+} CBotChannel;
+
+/** @brief The bot side of a channel */
+typedef struct
+{
+	CBotChannel * Channel;
+	uint64_t StatesHead;	/* Last Head of the states read : the shared one is read again only when they are all read */
+	uint64_t RequestsTail;	/* Last Tail of the requests read : the shared one is read again only when the queue looks full */
+	unsigned Spins;			/* Busy waits before yielding the core, none on a single core */
+} CBot;
+
+/** @brief Lets the other core of a busy wait run */
+static inline void BotPause (void)
+{
+#if defined (__x86_64__) || defined (__i386__)
+	__builtin_ia32_pause ();
+#elif defined (__aarch64__)
+	__asm__ __volatile__ ("yield");
+#endif
+}
+
+/** @brief For the producer of a queue : whether there is room for one more item, in slot Head % KBotSlots */
+static inline int BotCanPush (CBotQueue * Queue, uint64_t * CachedTail)
+{
+	const uint64_t Head = __atomic_load_n (&Queue -> Head, __ATOMIC_RELAXED);
+	if (Head - *CachedTail < KBotSlots) return 1;
+	*CachedTail = __atomic_load_n (&Queue -> Tail, __ATOMIC_ACQUIRE);
+	return Head - *CachedTail < KBotSlots;
+}
+
+/** @brief For the producer : publishes the item written in slot Head % KBotSlots */
+static inline void BotPush (CBotQueue * Queue)
+{
+	__atomic_store_n (&Queue -> Head, __atomic_load_n (&Queue -> Head, __ATOMIC_RELAXED) + 1, __ATOMIC_RELEASE);
+}
+
+/** @brief For the consumer of a queue : whether an item is waiting, in slot Tail % KBotSlots */
+static inline int BotCanPop (CBotQueue * Queue, uint64_t * CachedHead)
+{
+	const uint64_t Tail = __atomic_load_n (&Queue -> Tail, __ATOMIC_RELAXED);
+	if (Tail != *CachedHead) return 1;
+	*CachedHead = __atomic_load_n (&Queue -> Head, __ATOMIC_ACQUIRE);
+	return Tail != *CachedHead;
+}
+
+/** @brief For the consumer : gives the slot of the item back to the producer */
+static inline void BotPop (CBotQueue * Queue)
+{
+	__atomic_store_n (&Queue -> Tail, __atomic_load_n (&Queue -> Tail, __ATOMIC_RELAXED) + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ *@brief Attaches the bot to the game hosted in a file
+ *@return 0, or -1 if no game is hosted in the file
+ * The states left unread by a previous bot are dropped
+ */
+static inline int BotOpen (CBot * Bot, const char * Path)
+{
+	struct stat Status;
+	void * Map = MAP_FAILED;
+	const int Fd = open (Path, O_RDWR | O_CLOEXEC);
+	if (Fd < 0) return -1;
+	if (fstat (Fd, &Status) == 0 && Status.st_size >= (off_t) sizeof (CBotChannel))
+		Map = mmap (NULL, sizeof (CBotChannel), PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+	close (Fd);
+	if (Map == MAP_FAILED) return -1;
+
+	Bot -> Channel = (CBotChannel *) Map;
+	if (memcmp (Bot -> Channel -> Magic, "KCBT", 4) != 0 || Bot -> Channel -> Version != KBotVersion
+		|| Bot -> Channel -> NbSlots != KBotSlots || Bot -> Channel -> StateBytes != sizeof (CBotState))
+	{
+		munmap (Map, sizeof (CBotChannel));
+		return -1;
+	}
+	__atomic_thread_fence (__ATOMIC_ACQUIRE);
+
+	Bot -> StatesHead = __atomic_load_n (&Bot -> Channel -> States.Head, __ATOMIC_ACQUIRE);
+	__atomic_store_n (&Bot -> Channel -> States.Tail, Bot -> StatesHead, __ATOMIC_RELEASE);
+	Bot -> RequestsTail = __atomic_load_n (&Bot -> Channel -> Requests.Tail, __ATOMIC_ACQUIRE);
+	Bot -> Spins = sysconf (_SC_NPROCESSORS_ONLN) > 1 ? KBotSpins : 0;
+	return 0;
+}
+
+/** @brief Detaches the bot */
+static inline void BotClose (CBot * Bot)
+{
+	munmap (Bot -> Channel, sizeof (CBotChannel));
+	Bot -> Channel = NULL;
+}
+
+/** @brief Pushes a request, 0 if KBotSlots requests are already waiting */
+static inline int BotSend (CBot * Bot, const CBotRequest * Request)
+{
+	CBotQueue * Queue = &Bot -> Channel -> Requests;
+	if (! BotCanPush (Queue, &Bot -> RequestsTail)) return 0;
+	Bot -> Channel -> RequestSlots [Queue -> Head % KBotSlots] = *Request;
+	BotPush (Queue);
+	return 1;
+}
+
+/** @brief The answer to the oldest request not yet released, NULL if it has not come yet */
+static inline const CBotState * BotPoll (CBot * Bot)
+{
+	CBotQueue * Queue = &Bot -> Channel -> States;
+	return BotCanPop (Queue, &Bot -> StatesHead) ? &Bot -> Channel -> StateSlots [Queue -> Tail % KBotSlots] : NULL;
+}
+
+/** @brief Gives back the state returned by BotPoll or BotWait : it must not be read any more */
+static inline void BotRelease (CBot * Bot)
+{
+	BotPop (&Bot -> Channel -> States);
+}
+
+/**
+ *@brief Waits for the answer to the oldest request not yet released, NULL if the game has stopped
+ * Busy at first : the answer usually comes within microseconds. Then the core is yielded, in case the game shares it
+ */
+static inline const CBotState * BotWait (CBot * Bot)
+{
+	const CBotState * State;
+	unsigned Spins = 0;
+	while ((State = BotPoll (Bot)) == NULL)
+	{
+		if (++Spins < Bot -> Spins)
+		{
+			BotPause ();
+			continue;
+		}
+		if (Spins % 4096 == 0 && (memcmp (Bot -> Channel -> Magic, "KCBT", 4) != 0
+			|| (kill (Bot -> Channel -> Host, 0) != 0 && errno == ESRCH)))
+			return NULL;
+		sched_yield ();
+	}
+	return State;
+}
+
+#endif /* KITTY_BOT_H */
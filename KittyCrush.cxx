@@ -16,8 +16,8 @@
 #include <string>
 #include <vector>
 #include <iomanip> // setw ()
-#include <cstdlib> // Fonction rand () : génère un nombre aléatoire
-#include <ctime> // Nécessaire pour rand ()
+#include <cstdlib> // system (), strtoul ()
+#include <ctime> // time () : graine de la génération aléatoire
 #include <cctype> // Fonction tolower ()
 #include <unistd.h> // Fonction sleep ()
 #ifdef _WIN32
@@ -26,9 +26,85 @@
 #include <limits> // cin.ignore ()
 #include <math.h>
 #include <array>
+#include <chrono> // Mesure des temps pour le mode --bench
+#include <cstdint> // Entiers de taille fixe
+#include <cstring> // strerror (), memmove ()
+#include <memory> // unique_ptr
+#include <algorithm> // sort ()
+#include <deque> // Historique des coups
+#include <thread> // Générateur de jeu de données sur tous les cœurs
+#include <cstddef> // offsetof ()
+#include <atomic> // Générateur de puzzles : puzzles acceptés par tous les threads
+#include <iterator> // istreambuf_iterator : fichiers texte lus d'un bloc
+#ifdef __linux__
+#include <sys/epoll.h> // Mode serveur : boucle d'événements
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/resource.h> // Limite du nombre de fichiers ouverts
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <csignal>
+#include <sys/wait.h> // Balayage : une tranche par processus fils
+#include <sys/prctl.h>
+#endif
+#ifndef _WIN32
+#include <fcntl.h> // Fichiers partagés entre processus : open (), verrous fcntl ()
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <poll.h> // Contre la montre : attente de l'entrée ou du prochain pas
+#include <termios.h>
+#include "KittyBot.h" // Bots dans d'autres processus : files de requêtes et d'états en mémoire partagée
+#endif
 
 using namespace std;
 
+/* Compte les allocations du thread courant, le mode --check-alloc vérifie qu'un coup n'en fait aucune.
+   Les deux fonctions ne doivent pas être intégrées à l'appelant, sinon GCC croit que free () libère un bloc de new.
+   Toutes les formes de new et de delete passent par elles : avec -fsanitize=address, un bloc de malloc () libéré par
+   le delete d'origine serait une erreur */
+namespace KittyCrush { thread_local unsigned long NbAllocations (0); }
+
+#ifdef __GNUC__
+__attribute__ ((noinline))
+#endif
+void * operator new (size_t Size)
+{
+	++KittyCrush::NbAllocations;
+	if (void * Block = malloc (Size != 0 ? Size : 1))
+		return Block;
+	throw bad_alloc ();
+}
+
+#ifdef __GNUC__
+__attribute__ ((noinline))
+#endif
+void operator delete (void * Block) noexcept
+{
+	free (Block);
+}
+
+void operator delete (void * Block, size_t) noexcept
+{
+	operator delete (Block);
+}
+
+void * operator new [] (size_t Size)
+{
+	return operator new (Size);
+}
+
+void operator delete [] (void * Block) noexcept
+{
+	operator delete (Block);
+}
+
+void operator delete [] (void * Block, size_t) noexcept
+{
+	operator delete (Block);
+}
+
 /** @brief Namespace containing all the necessary functions for the game to run */
 namespace KittyCrush
 {
@@ -72,6 +148,33 @@ namespace KittyCrush
 	/** @brief Character to separate binary segments */
     const char Separator = 'O'; // Séparateur dans la sauvegarde
 
+	/** @brief Parameters of a level */
+	struct CLevel
+	{
+		unsigned Size;			// Taille de la grille (à la fois lignes et colonnes)
+		unsigned MaxTimes;		// Nombre maximal de coups autorisés
+		unsigned NbCandies;		// Combien de numéros différents sont présents dans la grille
+	};
+
+	/** @brief The four levels : easy, medium, hard and expert */
+	const array <CLevel, 4> KLevels {{ {6, 6, 4}, {8, 9, 4}, {6, 8, 5}, {8, 11, 5} }};
+
+	/** @brief Small xorshift random generator : a game built from a given seed is always the same */
+	struct CRandom
+	{
+		uint32_t State;
+
+		explicit CRandom (uint32_t Seed) : State (Seed != 0 ? Seed : 0x9E3779B9u) {}
+
+		uint32_t operator () ()
+		{
+			State ^= State << 13;
+			State ^= State >> 17;
+			State ^= State << 5;
+			return State;
+		}
+	};
+
     const string KReset = "0";
 	/** @brief Alias to the black color */
     const string KNoir = "30";
@@ -89,6 +192,8 @@ namespace KittyCrush
     const string KCyan = "36";
 	/** @brief Alias to the black character background */
     const string KNoirBG = "40";
+	/** @brief Alias to the yellow character background */
+    const string KJauneBG = "43";
 	/** @brief Alias to the cyan character background */
 	const string KCyanBG = "46";
 
@@ -112,6 +217,15 @@ namespace KittyCrush
 
 	} // ClearBuf ()
 
+	/**
+    *@brief Time elapsed since Start, in nanoseconds
+    *@param Start the starting point
+    */
+	double ElapsedNs (const chrono::steady_clock::time_point & Start)
+	{
+		return chrono::duration <double, nano> (chrono::steady_clock::now () - Start).count ();
+
+	} // ElapsedNs ()
 
 
 	/* 	UTILISATION : Affiche le message désigné par Invite puis l'utilisateur entrera quelque chose qui sera stocké dans Saisie
@@ -168,15 +282,55 @@ namespace KittyCrush
 	} // MenuPrompt ()
 
 
+	/*	RESSOURCES
+
+		Les fichiers texte du jeu (écran titre, crédits) sont lus une seule fois, chacun d'un bloc, au premier besoin. Les
+		écrans les affichent ensuite depuis la mémoire, en une seule écriture, et savoir s'il en manque ne rouvre aucun
+		fichier. */
+
+	/** @brief A text file of the game, kept in memory */
+	struct CAsset
+	{
+		const char * Path;
+		bool Found;
+		string Text;		// Se termine toujours par une fin de ligne
+	};
+
+	enum CAssetId {KTitleAsset, KCreditsAsset};
+
+	/** @brief The assets of the game, read from the disk on the first call only */
+	const array <CAsset, 2> & Assets ()
+	{
+		static const array <CAsset, 2> Loaded = [] {
+			array <CAsset, 2> Files {{ {"TitleScreen.txt", false, ""}, {"Credits.txt", false, ""} }};
+			for (CAsset & File : Files)
+			{
+				ifstream Stream (File.Path);
+				File.Found = Stream.good ();
+				File.Text.assign (istreambuf_iterator <char> (Stream), istreambuf_iterator <char> ());
+				if (! File.Text.empty () && File.Text.back () != '\n') File.Text += '\n';
+			}
+			return Files;
+		} ();
+		return Loaded;
+
+	} // Assets ()
+
+	/** @brief Writes an asset to the screen at once */
+	void WriteAsset (CAssetId Id)
+	{
+		const string & Text (Assets () [Id].Text);
+		cout.write (Text.data (), Text.size ());
+		cout.flush ();
+
+	} // WriteAsset ()
+
 	/**
     *@brief Check all fics in your current directory
     */
 	bool AllFilesAreValid () // Vérifie si tous les fichiers nécessaires au jeu sont présents
 	{
-		//ifstream Save
-		ifstream Title ("TitleScreen.txt") ;
-		ifstream Credit ("Credits.txt") ;
-		return (Title && Credit);
+		return Assets () [KTitleAsset].Found && Assets () [KCreditsAsset].Found;
 
 	} // AllFilesAreValid ()
 
@@ -188,14 +342,9 @@ namespace KittyCrush
 	void DisplayTitleScreen () // Affiche l'écran titre
 	{
 		ClearScreen ();
-		ifstream Title ("TitleScreen.txt");
 
-		if (Title) // TitleScreen.txt existe et est accessible
-		{
-		    string Line;
-		    while (getline (Title, Line))
-		        cout << Line << endl;
-		}
+		if (Assets () [KTitleAsset].Found) // TitleScreen.txt existe et est accessible
+			WriteAsset (KTitleAsset);
 		else
 		{
 		    cout << '\t' << "Kitty Crush by" << endl
@@ -204,6 +353,30 @@ namespace KittyCrush
 
 	} // DisplayTitleScreen ()
 
+	/** @brief How long the title screen stays, unless a key is pressed */
+	const unsigned KSplashMs = 3000;
+
+	/**
+    *@brief Leaves the title screen after KSplashMs, or as soon as the player presses Enter.
+    * When the input is not a terminal (scripted runs), the menu comes at once
+    */
+	void WaitSplash ()
+	{
+		#ifdef _WIN32
+			WaitForSingleObject (GetStdHandle (STD_INPUT_HANDLE), KSplashMs);
+		#else
+			if (! isatty (0)) return;
+
+			pollfd In {0, POLLIN, 0};
+			if (poll (&In, 1, KSplashMs) > 0)
+			{
+				string B;
+				getline (cin, B);	// La touche qui a passé l'écran titre ne doit pas compter comme un choix du menu
+			}
+		#endif
+
+	} // WaitSplash ()
+
 	/**
     *@brief Displays main menu
     *@param ErrorMsg is the message displayed in case of error
@@ -216,7 +389,9 @@ namespace KittyCrush
 			 << "2 : Charger Partie" << endl
 			 << "3 : Options" << endl
 		     << "4 : Credits" << endl
-		     << "5 : Quitter" << endl << endl;
+		     << "5 : Meilleurs Scores" << endl
+		     << "6 : Contre la montre" << endl
+		     << "7 : Quitter" << endl << endl;
 
 	    if (ErrorMsg.size () != 0)
 	        cout << ErrorMsg << endl;
@@ -232,14 +407,9 @@ namespace KittyCrush
 	void DisplayCredits () // Affiche les crédits
 	{
 		ClearScreen ();
-		ifstream Credit ("Credits.txt");
 
-		if (Credit)
-		{
-		    string Line;
-		    while (getline (Credit, Line))
-		        cout << Line << endl;
-		}
+		if (Assets () [KCreditsAsset].Found)
+			WriteAsset (KCreditsAsset);
 		else
 		    cerr << "Erreur : Fichier Credits.txt manquant" << endl;
 
@@ -326,12 +496,31 @@ namespace KittyCrush
 
 	} // ChangeMvtKeysMenu ()
 
+	/* Limites de l'historique des coups */
+	unsigned UndoDepth (20);
+	unsigned UndoMemoryKb (1024);
+
+	/**
+    *@brief Options : Change the depth and the memory of the undo history
+    */
+	void ChangeUndoLimitsMenu ()
+	{
+		ClearScreen ();
+
+		cout << "Actuellement : " << UndoDepth << " coups annulables, " << UndoMemoryKb << " Ko au maximum" << endl << endl;
+
+		SaisieCin (UndoDepth, "Saisie invalide", "Nombre de coups annulables : ");
+		SaisieCin (UndoMemoryKb, "Saisie invalide", "Mémoire maximale de l'historique (en Ko) : ");
+
+	} // ChangeUndoLimitsMenu ()
+
 	/**
     *@brief Display movements keys
     */
 	void DisplayMovementKeys ()
 	{
-		cout << KeyUp << " : haut, " << KeyDown << " : bas, " << KeyLeft << " : gauche, " << KeyRight << " : droite" << endl;
+		cout << KeyUp << " : haut, " << KeyDown << " : bas, " << KeyLeft << " : gauche, " << KeyRight << " : droite" << endl
+			 << "u : annuler le dernier coup, r : le rejouer, i : demander un indice" << endl;
 
 	} // DisplayMovementKeys ()
 
@@ -341,7 +530,7 @@ namespace KittyCrush
     */
 	void DisplayOptions (array <unsigned, 2> & Choices)
 	{
-		const unsigned ValeurChoixMax (4);
+		const unsigned ValeurChoixMax (5);
 		unsigned Choix;
 
 		do {
@@ -351,7 +540,8 @@ namespace KittyCrush
 			 << "1 : Changer touches de déplacement" << endl
 			 << "2 : Choisir mode de saisie (détaillé ou en une seule ligne)" << endl
 			 << "3 : Choix entre saisir ligne puis colonne ou colonne puis ligne lors d'une commande" << endl
-			 << "4 : Retour au menu principal" << endl << endl;
+			 << "4 : Nombre de coups annulables" << endl
+			 << "5 : Retour au menu principal" << endl << endl;
 
 			MenuPrompt (Choix, ValeurChoixMax);
 
@@ -366,6 +556,9 @@ namespace KittyCrush
 				case 3:
 					DisplayLineColumnFirst (Choices);
 					break ;
+				case 4:
+					ChangeUndoLimitsMenu ();
+					break ;
 			}
 
 		} while (Choix != ValeurChoixMax); // Si Choix vaut la dernière option, on quitte
@@ -498,6 +691,15 @@ namespace KittyCrush
     } // MakeAMove ()
 
 
+	/*	MOTEUR DE RÉFÉRENCE
+
+		Les fonctions d'origine de détection et de suppression des suites, gardées telles quelles : le jeu ne les appelle
+		plus, il passe par les noyaux qui suivent. Elles servent de référence au mode --check-engines, qui vérifie que ces
+		noyaux donnent toujours les mêmes grilles et les mêmes scores. Ne pas les modifier ni les optimiser. */
+
+	namespace Reference
+	{
+
 	/**
     *@brief At least three numbers in a column
     *@param Grid in the Grid
@@ -632,37 +834,6 @@ namespace KittyCrush
 
     } // RemovalInRow ()
 
-
-    /**
-    *@brief Initialize the Grid
-    *@param Grid the grid to initialize
-    *@param Size how many column and row
-    *@param NbCandies the maximum number that you can find in this grid
-    * Initialize a random grid with chosen parameters
-    */
-	void InitGrid (CMat & Grid, unsigned Size, unsigned NbCandies)
-    {
-        srand (time (NULL)); 	// Initialise la génération aléatoire (en fonction du temps système)
-		Grid = CMat (Size);		// Dimensionne la grille pour qu'elle contienne "Size" lignes
-
-		CPosition Pos;
-		unsigned HowMany; // osef, c'est juste pour utiliser la fonction de test
-
-		/* Génère la grille jusqu'à ce qu'il n'y ait plus de suites dès le début */
-		do {
-			for (CMat::iterator GridIter (Grid.begin ()); GridIter < Grid.end (); ++GridIter)
-			{
-				*GridIter = CVLine (Size); // Dimensionne les lignes (même procédé que pour la grille)
-
-				/* Chaque case prend une valeur aléatoire entre 1 et NbCandies */
-				for (CVLine::iterator LineIter (GridIter -> begin ()); LineIter < GridIter -> end (); ++LineIter)
-					*LineIter = (rand () % NbCandies) + 1;
-			}
-
-		} while (AtLeastThreeInAColumn (Grid, Pos, HowMany) || AtLeastThreeInARow (Grid, Pos, HowMany));
-
-    } // InitGrid ()
-
 	/*	Détecte et supprime les suites de nombres identiques */
     /**
     *@brief Arrange Grid
@@ -696,173 +867,2854 @@ namespace KittyCrush
 
 	} // ArrangeGrid ()
 
-    /**
-    *@brief Test if a string is binary
-    *@param Str the string to test
-    */
-	bool IsBinary(string Str)
-	/* On teste si une string est binaire, si oui renvoie true */
-    {
-        for (unsigned i (0) ; i < Str.size() ; ++ i)
-        {
-           if ( ! (Str [i] == '0' || Str [i] == '1') )
-               return false ;
-        }
-        return true ;
+	} // namespace Reference
 
-    } // IsBinary ()
 
-    /**
-    *@brief Decimal to binary
-    *@param Nbr the number to convert
-    * Convert a number to a X number binary string
-    */
-	string DecToBin (unsigned Nbr)
-	/* Conversion du décimal vers binaire, on rentre un nombre entier
-       positif, et on le convertis en une string de NbZero caractères */
-    {
-            string Binary ( NbZero, '0') ; // Le nombre de zeros, initialisé à 0
-            unsigned Pos (0), Local (Nbr) ;
-            if (Nbr > RealMax) return "Size_Error" ; // On ne peut pas dépasser le max
-            for (unsigned i (NbMax) ; i >= 1 ; i /= 2 )
-            {
-                if ( Local >= i )
-                {
-                    Binary[Pos] = '1' ;
-                    Local -= i ;
-                }
-                Pos += 1 ;
-            }
-            return Binary ;
+	/*	ALLOCATION DES GRILLES
 
-    } // DecToBin ()
+		Une partie ne devrait allouer de la mémoire qu'à son premier tour : les grilles sont redimensionnées en place et les
+		copies temporaires sont prises dans une réserve propre à chaque thread au lieu d'être recréées à chaque fois. */
 
-    /**
-    *@brief Binary to decimal
-    *@param Str the string to convert
-    */
-    unsigned BinToDec (string Str) // Pour le décryptage
-    /* On prend une string binaire et on la transforme en un unsigned */
-    {
-        unsigned NbDec (0), Squared (1) ; // Squared (au carré en anglais) va être multiplié pour faire 1,2,4,8,16
-        if (IsBinary (Str))
-        {
-            for (unsigned i (Str.size() ) ; i-- > 0;)
-            {
-                if (Str[i] == '1')
-                    NbDec += Squared ;
-                if (i != Str.size() )
-                    Squared *=2 ;
-            }
-            return NbDec ;
-        }
-        else
-            return 0 ; // Renvoie 0 si la string qu'on demande n'est pas binaire.
+	/** @brief Per-thread free lists of grids and lines, for temporary copies and grids that change size */
+	class CGridPool
+	{
+		vector <CMat> Free;
+		vector <CVLine> FreeLines;
 
-    } // BinToDec ()
+	  public:
+		/** @brief Gives the grid Size lines of Size empty cells, lines removed or added go through the free list */
+		void Resize (CMat & Grid, unsigned Size)
+		{
+			for (; Grid.size () > Size; Grid.pop_back ())
+				FreeLines.push_back (move (Grid.back ()));
 
-    /**
-    *@brief Existing save
-    Test if the save file exists
-    */
-    bool ExistingSave () // Le dossier de sauvegarde existe-t-il ?
-    {
-        ifstream SaveFile ("./save.txt") ;
-        return SaveFile.good ();
+			for (; Grid.size () < Size; FreeLines.pop_back ())
+			{
+				if (FreeLines.empty ()) FreeLines.push_back (CVLine ());
+				Grid.push_back (move (FreeLines.back ()));
+			}
 
-    } // ExistingSave ()
+			for (CVLine & Line : Grid)
+				Line.assign (Size, KImpossible);
+		}
 
+		/** @brief Gives a grid of Size x Size empty cells, taken from the free list when possible */
+		void Acquire (CMat & Grid, unsigned Size)
+		{
+			if (! Free.empty ())
+			{
+				Grid.swap (Free.back ());
+				Free.pop_back ();
+			}
+			Resize (Grid, Size);
+		}
 
-	/** @brief used to crpyt data to save */
-	const CVStr KeyTab {"0001101101","0101100010", "1000010101", "0000000110" }; // Le tableau des clés qui serviront a coder les données
-    /**
-    *@brief Do a exclusive or in a binary string
-    *@param Bin the string to code
-    *@param Key the key to do a XOR with
-    */
-    string CodeXor (string Bin, string Key) // Un ou exclusif sur les string
-    {
-        if ( (Bin.size() == Key.size()) && IsBinary(Key) )
-        {
-            string Code (Key.size(), '0') ;
-            for (unsigned i(0) ; i < Code.size() ; ++i)
-            {
-                if ( ( ( Bin[i] == '0' ) && ( Key[i] == '1' ) ) || ( ( Bin[i] == '1' ) && ( Key[i] == '0' ) ) )
-                Code[i] = '1' ;
-            }
-            return Code ;
-        }
-        else
-            return "Error_XOR" ;
+		/** @brief Gives the memory of the grid back to the free list */
+		void Release (CMat & Grid)
+		{
+			Free.push_back (CMat ());
+			Free.back ().swap (Grid);
+		}
+	};
 
-    } // CodeXor ()
+	/** @brief The grid pool of the current thread */
+	CGridPool & GridPool ()
+	{
+		static thread_local CGridPool Pool;
+		return Pool;
 
-    /**
-    *@brief Crypt a number
-    *@param Data the number to crypt
-    *@param Key the key to crypt with
-    *@param KeyTab a vector who contains the keys
+	} // GridPool ()
+
+	/**
+    *@brief Gives the grid Size lines of Size empty cells, reusing its memory (no allocation once it has been that large)
+    *@param Grid the grid
+    *@param Size how many column and row
     */
-    string Crypt (unsigned Data, unsigned Key, const CVStr & KeyTab )
-    /* Un compilé des fonctions précédentes pour crypter de mannière simple
-       Data la donnée a crypter, Key la clé actuelle qui va changer à chaque tour
-       et KeyTab le tableau de clés déterminé préalablement */
-    {
-        if (Key > KeyTab.size() - 1)
-            return "Error:Bad_Key" ;
-        string Code ;
-        string BinData ( DecToBin(Data) ) ;
-        string KeyBin ;
-        if ( BinData == "Size_Error")
-            return "Size_Error" ;
-        Code = CodeXor(BinData, KeyTab [Key]) ;
-        return Code ;
+	void SizeGrid (CMat & Grid, unsigned Size)
+	{
+		GridPool ().Resize (Grid, Size);
 
-    } // Crypt ()
+	} // SizeGrid ()
 
-    /**
-    *@brief Uncrypt
-    *@param StrData the string to uncrypt
-    *@param Key the key to do the uncrpyt
-    *@param KeyTab a vector who contains the keys
-    */
-    unsigned Decrypt (string StrData, unsigned Key, const CVStr & KeyTab) // Décrypte une string binaire en unsigned, le processus inverse du cryptage.
-    {
-        if (IsBinary(StrData) )
-        {
-            string CodeCrypt (CodeXor (StrData, KeyTab[Key]) ) ;
-            unsigned CodeDecrypt (BinToDec (CodeCrypt) ) ;
-            return CodeDecrypt ;
-        }
-        else return 1024 ; // Valeur qu'on utilisera jamais, forcément supérieure à NbCandies, elle renverra forcément erreur dans le programme de chargement
 
-    } // Decrypt ()
+	/*	NOYAUX SPÉCIALISÉS
 
-    /**
-    *@brief Save the game in save.txt
-    *@param Grid the game grid
-    *@param Turn parameter of the game
-    *@param Score parameter of the game
-    *@param BestScore parameter of the game
-    *@param Size parameter of the game
-    *@param KeyTab vector who contains every keys
-    *@param MaxTimes parameter of the game
-    */
-    void Save (const CMat & Grid, unsigned Turn, unsigned Score, unsigned BestScore, unsigned Size, const CVStr & KeyTab, unsigned MaxTimes )
-    {
-        /* La sauvegarde, elle crée un fichier save.txt contenant toutes les données nécéssaires au jeu, et les crypte */
-        ofstream SaveFile ("./save.txt", ios::trunc) ;
-        unsigned Key ((Turn % KeyTab.size() + 1) - 1 ) ;
-        SaveFile << DecToBin(Key) << Separator ; // CRYPTAGE Key (1)
-        string CryptScore = Crypt(Score, Key, KeyTab) ;
-        string CryptBestScore = Crypt(BestScore, Key, KeyTab) ;
-        SaveFile << CryptScore << Separator << CryptBestScore << Separator ; // CRYPTAGE Score (2) BestScore(3)
-        string CryptSize = Crypt(Size, Key, KeyTab) ; // CRYPTAGE Taille (4)
-        SaveFile << CryptSize << Separator ;
-		string CryptTurn = Crypt(Turn, Key, KeyTab) ; // CRYPTAGE Tour (5)
-		SaveFile << CryptTurn << Separator ;
-		string CryptMaxTimes = Crypt (MaxTimes, Key, KeyTab) ; // CRYPTAGE Niveau (6)
-		SaveFile << CryptMaxTimes << Separator ;
+		Les quatre niveaux n'utilisent que des grilles 6x6 et 8x8. Les noyaux ci-dessous sont écrits une seule fois sous forme
+		de templates sur un type de grille : avec CFixedBoard les dimensions sont des constantes de compilation et les boucles
+		sont entièrement déroulées, avec CDynBoard on retrouve le chemin générique pour les tailles personnalisées. */
+
+	/** @brief A move : the selected cell and the direction (one of the movement keys) it is swapped towards */
+	struct CMove
+	{
+		CPosition Pos;
+		char Direction;
+	};
+
+	/** @brief Alias to a vector of moves */
+	typedef vector <CMove> CVMove;
+
+	/** @brief Index of the lowest bit set in Mask (Mask must not be 0) */
+	inline unsigned LowestBit (unsigned Mask)
+	{
+		#ifdef __GNUC__
+			return __builtin_ctz (Mask);
+		#else
+			unsigned Bit (0);
+			while (! (Mask & 1)) { Mask >>= 1; ++Bit; }
+			return Bit;
+		#endif
+
+	} // LowestBit ()
+
+	/**	@brief Bit K of the mask is set when cells K and K + 1 of the line are identical and not empty
+	 *	Cells of the line are KStride apart, the recursion unrolls the KCount - 1 comparisons at compile time */
+	template <unsigned KStride, unsigned KCount, unsigned K = 0, bool KEnd = (K + 1 >= KCount)>
+	struct CEqualMask
+	{
+		static unsigned Get (const unsigned * Line)
+		{
+			return (unsigned (Line [K * KStride] == Line [(K + 1) * KStride] && Line [K * KStride] != KImpossible) << K)
+				 | CEqualMask <KStride, KCount, K + 1>::Get (Line);
+		}
+	};
+
+	template <unsigned KStride, unsigned KCount, unsigned K>
+	struct CEqualMask <KStride, KCount, K, true>
+	{
+		static unsigned Get (const unsigned *) { return 0; }
+	};
+
+	/** @brief Grid whose dimensions are known at compile time, stored row after row in a single array */
+	template <unsigned KHeight, unsigned KWidth>
+	struct CFixedBoard
+	{
+		array <unsigned, KHeight * KWidth> Cells;
+
+		static constexpr unsigned Height () { return KHeight; }
+		static constexpr unsigned Width () { return KWidth; }
+
+		unsigned & operator () (unsigned i, unsigned j) { return Cells [i * KWidth + j]; }
+		unsigned operator () (unsigned i, unsigned j) const { return Cells [i * KWidth + j]; }
+
+		/** @brief Equality mask of line i (see CEqualMask) */
+		unsigned RowMask (unsigned i) const { return CEqualMask <1, KWidth>::Get (&Cells [i * KWidth]); }
+
+		/** @brief Equality mask of column j (see CEqualMask) */
+		unsigned ColumnMask (unsigned j) const { return CEqualMask <KWidth, KHeight>::Get (&Cells [j]); }
+
+		/** @brief Copies a grid of the same dimensions into the board */
+		void FromMat (const CMat & Grid)
+		{
+			for (unsigned i (0); i < KHeight; ++i)
+				for (unsigned j (0); j < KWidth; ++j)
+					Cells [i * KWidth + j] = Grid [i][j];
+		}
+
+		/** @brief Copies the board back into a grid of the same dimensions */
+		void ToMat (CMat & Grid) const
+		{
+			for (unsigned i (0); i < KHeight; ++i)
+				for (unsigned j (0); j < KWidth; ++j)
+					Grid [i][j] = Cells [i * KWidth + j];
+		}
+	};
+
+	/** @brief View on a CMat of any size, used by the generic path of the kernels */
+	struct CDynBoard
+	{
+		CMat & Grid;
+
+		unsigned Height () const { return Grid.size (); }
+		unsigned Width () const { return Grid [0].size (); }
+
+		unsigned & operator () (unsigned i, unsigned j) { return Grid [i][j]; }
+		unsigned operator () (unsigned i, unsigned j) const { return Grid [i][j]; }
+	};
+
+	/**
+    *@brief Same as AtLeastThreeInARow, on any kind of board
+    *@param Board the board to scan
+    *@param Pos the position of the first cell of the run found
+    *@param HowMany the length of the run found
+    * KMinRun is the minimum length of a run (3 in the original rules)
+    */
+	template <unsigned KMinRun = 3, typename TBoard>
+	bool FindRunInRow (const TBoard & Board, CPosition & Pos, unsigned & HowMany)
+	{
+		for (unsigned i (0); i < Board.Height (); ++i)
+		{
+			unsigned NbPrec (Board (i, 0));
+			Pos = make_pair (i, 0);
+			HowMany = 1;
+
+			for (unsigned j (1); j < Board.Width (); ++j)
+			{
+				if (Board (i, j) == NbPrec && NbPrec != KImpossible)
+					++HowMany;
+				else
+				{
+					if (HowMany >= KMinRun) return true;
+					HowMany = 1;
+					Pos = make_pair (i, j);
+					NbPrec = Board (i, j);
+				}
+			}
+			if (HowMany >= KMinRun) return true;
+		}
+		return false;
+
+	} // FindRunInRow ()
+
+	/**
+    *@brief Same as AtLeastThreeInAColumn, on any kind of board
+    *@param Board the board to scan
+    *@param Pos the position of the first cell of the run found
+    *@param HowMany the length of the run found
+    * KMinRun is the minimum length of a run (3 in the original rules)
+    */
+	template <unsigned KMinRun = 3, typename TBoard>
+	bool FindRunInColumn (const TBoard & Board, CPosition & Pos, unsigned & HowMany)
+	{
+		for (unsigned j (0); j < Board.Width (); ++j)
+		{
+			unsigned NbPrec (Board (0, j));
+			Pos = make_pair (0, j);
+			HowMany = 1;
+
+			for (unsigned i (1); i < Board.Height (); ++i)
+			{
+				if (Board (i, j) == NbPrec && NbPrec != KImpossible)
+					++HowMany;
+				else
+				{
+					if (HowMany >= KMinRun) return true;
+					HowMany = 1;
+					Pos = make_pair (i, j);
+					NbPrec = Board (i, j);
+				}
+			}
+			if (HowMany >= KMinRun) return true;
+		}
+		return false;
+
+	} // FindRunInColumn ()
+
+	/**
+    *@brief Finds the first run of a line or column given by its equality mask
+    *@param Mask the equality mask of the line
+    *@param Start the index of the first cell of the run
+    *@param HowMany the length of the run
+    */
+	template <unsigned KMinRun = 3>
+	inline bool FirstRunInMask (unsigned Mask, unsigned & Start, unsigned & HowMany)
+	{
+		/* KMinRun cases identiques commencent en k si les bits k à k + KMinRun - 2 sont à 1 (k et k + 1 pour une suite de trois) :
+		   le premier trouvé est le début de la suite */
+		unsigned Starts (Mask);
+		for (unsigned Shift (1); Shift + 1 < KMinRun; ++Shift)
+			Starts &= Mask >> Shift;
+		if (! Starts) return false;
+
+		Start = LowestBit (Starts);
+		HowMany = LowestBit (~(Mask >> Start)) + 1;
+		return true;
+
+	} // FirstRunInMask ()
+
+	/**
+    *@brief Fixed-size FindRunInRow : each line is tested at once with its equality mask
+    */
+	template <unsigned KMinRun = 3, unsigned KHeight, unsigned KWidth>
+	bool FindRunInRow (const CFixedBoard <KHeight, KWidth> & Board, CPosition & Pos, unsigned & HowMany)
+	{
+		unsigned Start;
+		for (unsigned i (0); i < KHeight; ++i)
+			if (FirstRunInMask <KMinRun> (Board.RowMask (i), Start, HowMany))
+			{
+				Pos = make_pair (i, Start);
+				return true;
+			}
+		return false;
+
+	} // FindRunInRow ()
+
+	/**
+    *@brief Fixed-size FindRunInColumn : each column is tested at once with its equality mask
+    */
+	template <unsigned KMinRun = 3, unsigned KHeight, unsigned KWidth>
+	bool FindRunInColumn (const CFixedBoard <KHeight, KWidth> & Board, CPosition & Pos, unsigned & HowMany)
+	{
+		unsigned Start;
+		for (unsigned j (0); j < KWidth; ++j)
+			if (FirstRunInMask <KMinRun> (Board.ColumnMask (j), Start, HowMany))
+			{
+				Pos = make_pair (Start, j);
+				return true;
+			}
+		return false;
+
+	} // FindRunInColumn ()
+
+	/**
+    *@brief Same as RemovalInRow, on any kind of board
+    *@param Board the board
+    *@param Pos the position of the first cell of the run
+    *@param HowMany the length of the run
+    */
+	template <typename TBoard>
+	void ClearRunInRow (TBoard & Board, const CPosition & Pos, unsigned HowMany)
+	{
+		/* Les cases de la suite sont écrasées par celles du dessus, la ligne du haut devient vide */
+		for (unsigned j (Pos.second); j < Pos.second + HowMany; ++j)
+		{
+			for (unsigned i (Pos.first); i > 0; --i)
+				Board (i, j) = Board (i - 1, j);
+
+			Board (0, j) = KImpossible;
+		}
+
+	} // ClearRunInRow ()
+
+	/**
+    *@brief Same as RemovalInColumn, on any kind of board
+    *@param Board the board
+    *@param Pos the position of the first cell of the run
+    *@param HowMany the length of the run
+    */
+	template <typename TBoard>
+	void ClearRunInColumn (TBoard & Board, const CPosition & Pos, unsigned HowMany)
+	{
+		/* Même parcours que RemovalInColumn, dans le même ordre, pour que les deux chemins donnent exactement la même grille */
+		for (unsigned i (Pos.first); i < Pos.first + HowMany; ++i)
+			Board (i, Pos.second) = KImpossible;
+
+		for (unsigned i (0); i < Pos.first; ++i)
+		{
+			Board (i + HowMany, Pos.second) = Board (i, Pos.second);
+			Board (i, Pos.second) = KImpossible;
+		}
+
+	} // ClearRunInColumn ()
+
+	/*	RÈGLES DU JEU
+
+		Une variante de règles (CRules) réunit quatre politiques, passées en paramètres de modèle aux noyaux : la longueur
+		minimale d'une suite, les directions d'échange permises, le sens de la gravité et le calcul des points. Chaque variante
+		instancie ses propres noyaux ; les règles y sont des constantes, aucune boucle ne les teste.
+		CClassicRules sont les règles d'origine, avec la suppression en colonne telle qu'elle a toujours été. */
+
+	/** @brief Keys of the diagonal swaps, laid out like a numeric keypad */
+	const char KeyUpLeft ('7'), KeyUpRight ('9'), KeyDownLeft ('1'), KeyDownRight ('3');
+
+	/**
+    *@brief Step from a cell to its neighbour in a direction
+    *@return false if Direction is not a direction key
+    */
+	inline bool StepOf (char Direction, int & Di, int & Dj)
+	{
+		Di = Direction == KeyUp || Direction == KeyUpLeft || Direction == KeyUpRight ? -1
+		   : Direction == KeyDown || Direction == KeyDownLeft || Direction == KeyDownRight ? 1 : 0;
+		Dj = Direction == KeyLeft || Direction == KeyUpLeft || Direction == KeyDownLeft ? -1
+		   : Direction == KeyRight || Direction == KeyUpRight || Direction == KeyDownRight ? 1 : 0;
+		return Di != 0 || Dj != 0;
+
+	} // StepOf ()
+
+	/** @brief Swaps with the four neighbours ; the moves listed go towards the right and the bottom */
+	struct COrthogonalSwaps
+	{
+		static const unsigned KNbForward = 2;
+		static char Forward (unsigned k) { return k == 0 ? KeyRight : KeyDown; }
+		static bool IsAllowed (int Di, int Dj) { return Di * Di + Dj * Dj == 1; }
+	};
+
+	/** @brief Swaps with the eight neighbours */
+	struct CDiagonalSwaps
+	{
+		static const unsigned KNbForward = 4;
+		static char Forward (unsigned k) { return k == 0 ? KeyRight : k == 1 ? KeyDown : k == 2 ? KeyDownRight : KeyDownLeft; }
+		static bool IsAllowed (int Di, int Dj) { return (Di != 0 || Dj != 0) && Di * Di <= 1 && Dj * Dj <= 1; }
+	};
+
+	/** @brief The cells above a removed run fall down (original rules) */
+	struct CGravityDown
+	{
+		template <typename TBoard>
+		static void ClearRow (TBoard & Board, const CPosition & Pos, unsigned HowMany) { ClearRunInRow (Board, Pos, HowMany); }
+		template <typename TBoard>
+		static void ClearColumn (TBoard & Board, const CPosition & Pos, unsigned HowMany) { ClearRunInColumn (Board, Pos, HowMany); }
+	};
+
+	/** @brief The cells below a removed run rise, the bottom becomes empty */
+	struct CGravityUp
+	{
+		template <typename TBoard>
+		static void ClearRow (TBoard & Board, const CPosition & Pos, unsigned HowMany)
+		{
+			for (unsigned j (Pos.second); j < Pos.second + HowMany; ++j)
+			{
+				for (unsigned i (Pos.first); i + 1 < Board.Height (); ++i)
+					Board (i, j) = Board (i + 1, j);
+				Board (Board.Height () - 1, j) = KImpossible;
+			}
+		}
+
+		template <typename TBoard>
+		static void ClearColumn (TBoard & Board, const CPosition & Pos, unsigned HowMany)
+		{
+			unsigned i (Pos.first);
+			for (; i + HowMany < Board.Height (); ++i)
+				Board (i, Pos.second) = Board (i + HowMany, Pos.second);
+			for (; i < Board.Height (); ++i)
+				Board (i, Pos.second) = KImpossible;
+		}
+	};
+
+	/** @brief A removed run leaves empty cells, nothing moves */
+	struct CNoGravity
+	{
+		template <typename TBoard>
+		static void ClearRow (TBoard & Board, const CPosition & Pos, unsigned HowMany)
+		{
+			for (unsigned j (Pos.second); j < Pos.second + HowMany; ++j)
+				Board (Pos.first, j) = KImpossible;
+		}
+
+		template <typename TBoard>
+		static void ClearColumn (TBoard & Board, const CPosition & Pos, unsigned HowMany)
+		{
+			for (unsigned i (Pos.first); i < Pos.first + HowMany; ++i)
+				Board (i, Pos.second) = KImpossible;
+		}
+	};
+
+	/** @brief A run of n is worth 1 + 2 + ... + n, the total of a move is multiplied by its number of removals (original rules) */
+	struct CTriangleScoring
+	{
+		static unsigned Points (unsigned HowMany) { return HowMany * (HowMany + 1) / 2; }
+		static unsigned Total (unsigned Points, unsigned NbRemovals) { return Points * NbRemovals; }
+	};
+
+	/** @brief 10 points per cell removed, 20 more for each removal after the first of a move */
+	struct CFlatScoring
+	{
+		static unsigned Points (unsigned HowMany) { return 10 * HowMany; }
+		static unsigned Total (unsigned Points, unsigned NbRemovals) { return NbRemovals == 0 ? 0 : Points + 20 * (NbRemovals - 1); }
+	};
+
+	template <unsigned KMinRunLength, typename TSwaps, typename TGravity, typename TScoring>
+	struct CRules
+	{
+		static const unsigned KMinRun = KMinRunLength;
+		typedef TSwaps Swaps;
+		typedef TGravity Gravity;
+		typedef TScoring Scoring;
+	};
+
+	typedef CRules <3, COrthogonalSwaps, CGravityDown, CTriangleScoring> CClassicRules;
+
+	/**
+    *@brief Same as ArrangeGrid, on any kind of board
+    *@param Board the board to arrange
+    *@param Score the score to increase
+    *@param PointsEarned points already earned by the move, before the runs of the board (its shapes)
+    *@param ComboMeter removals already made by the move
+    * TRules gives the minimum length of a run, the gravity and the scoring
+    */
+	template <typename TRules = CClassicRules, typename TBoard>
+	void ArrangeBoard (TBoard & Board, unsigned & Score, unsigned PointsEarned = 0, unsigned ComboMeter = 0)
+	{
+		CPosition Pos;
+		unsigned HowMany;
+
+		while (FindRunInRow <TRules::KMinRun> (Board, Pos, HowMany))
+		{
+			TRules::Gravity::ClearRow (Board, Pos, HowMany);
+			++ComboMeter;
+			PointsEarned += TRules::Scoring::Points (HowMany);
+		}
+
+		while (FindRunInColumn <TRules::KMinRun> (Board, Pos, HowMany))
+		{
+			TRules::Gravity::ClearColumn (Board, Pos, HowMany);
+			++ComboMeter;
+			PointsEarned += TRules::Scoring::Points (HowMany);
+		}
+
+		Score += TRules::Scoring::Total (PointsEarned, ComboMeter);
+
+	} // ArrangeBoard ()
+
+	/**
+    *@brief Check if the cell belongs to a run of at least three identical numbers
+    *@param Board the board
+    *@param i line of the cell
+    *@param j column of the cell
+    */
+	template <typename TBoard>
+	bool IsInRun (const TBoard & Board, unsigned i, unsigned j)
+	{
+		const unsigned Value (Board (i, j));
+		if (Value == KImpossible) return false;
+
+		unsigned HowMany (1);
+		for (unsigned k (j); k-- > 0 && Board (i, k) == Value;) ++HowMany;
+		for (unsigned k (j + 1); k < Board.Width () && Board (i, k) == Value; ++k) ++HowMany;
+		if (HowMany >= 3) return true;
+
+		HowMany = 1;
+		for (unsigned k (i); k-- > 0 && Board (k, j) == Value;) ++HowMany;
+		for (unsigned k (i + 1); k < Board.Height () && Board (k, j) == Value; ++k) ++HowMany;
+		return HowMany >= 3;
+
+	} // IsInRun ()
+
+	/**
+    *@brief Move generation : lists every swap that creates at least one run
+    *@param Board the board, restored in its original state on return
+    *@param Moves filled with the scoring moves (towards the right or the bottom only, to avoid duplicates)
+    */
+	template <typename TBoard>
+	void ListBoardScoringMoves (TBoard & Board, CVMove & Moves)
+	{
+		Moves.clear ();
+
+		for (unsigned i (0); i < Board.Height (); ++i)
+		{
+			for (unsigned j (0); j < Board.Width (); ++j)
+			{
+				if (Board (i, j) == KImpossible) continue;
+
+				/* On échange avec la case de droite puis celle du dessous, on teste, et on remet en place */
+				if (j + 1 < Board.Width () && Board (i, j + 1) != KImpossible && Board (i, j + 1) != Board (i, j))
+				{
+					swap (Board (i, j), Board (i, j + 1));
+					if (IsInRun (Board, i, j) || IsInRun (Board, i, j + 1))
+						Moves.push_back (CMove {make_pair (i, j), KeyRight});
+					swap (Board (i, j), Board (i, j + 1));
+				}
+				if (i + 1 < Board.Height () && Board (i + 1, j) != KImpossible && Board (i + 1, j) != Board (i, j))
+				{
+					swap (Board (i, j), Board (i + 1, j));
+					if (IsInRun (Board, i, j) || IsInRun (Board, i + 1, j))
+						Moves.push_back (CMove {make_pair (i, j), KeyDown});
+					swap (Board (i, j), Board (i + 1, j));
+				}
+			}
+		}
+
+	} // ListBoardScoringMoves ()
+
+	/**
+    *@brief Fills the board with random numbers between 1 and KNbCandies until it has no run
+    *@param Board the board to fill
+    *@param Rand the random generator
+    */
+	template <unsigned KNbCandies, typename TBoard>
+	void FillBoard (TBoard & Board, CRandom & Rand)
+	{
+		CPosition Pos;
+		unsigned HowMany;
+
+		do {
+			for (unsigned i (0); i < Board.Height (); ++i)
+				for (unsigned j (0); j < Board.Width (); ++j)
+					Board (i, j) = (Rand () % KNbCandies) + 1;
+
+		} while (FindRunInColumn (Board, Pos, HowMany) || FindRunInRow (Board, Pos, HowMany));
+
+	} // FillBoard ()
+
+	/**
+    *@brief Fixed-size version of InitGrid (Grid must already have the right dimensions)
+    *@param Grid the grid to initialize
+    *@param Rand the random generator
+    */
+	template <unsigned KHeight, unsigned KWidth, unsigned KNbCandies>
+	void InitFixedGrid (CMat & Grid, CRandom & Rand)
+	{
+		CFixedBoard <KHeight, KWidth> Board;
+		FillBoard <KNbCandies> (Board, Rand);
+		Board.ToMat (Grid);
+
+	} // InitFixedGrid ()
+
+	/**
+    *@brief Fixed-size version of ArrangeGrid
+    *@param Grid the grid to arrange, of dimensions KHeight x KWidth
+    *@param Score the score to increase
+    *@param PointsEarned, ComboMeter points and removals already made by the move
+    */
+	template <typename TRules, unsigned KHeight, unsigned KWidth>
+	void ArrangeFixedGrid (CMat & Grid, unsigned & Score, unsigned PointsEarned = 0, unsigned ComboMeter = 0)
+	{
+		CFixedBoard <KHeight, KWidth> Board;
+		Board.FromMat (Grid);
+		ArrangeBoard <TRules> (Board, Score, PointsEarned, ComboMeter);
+		Board.ToMat (Grid);
+
+	} // ArrangeFixedGrid ()
+
+	/**
+    *@brief Fixed-size version of the move generation
+    *@param Grid the grid, of dimensions KHeight x KWidth
+    *@param Moves filled with the scoring moves
+    */
+	template <unsigned KHeight, unsigned KWidth>
+	void ListFixedScoringMoves (const CMat & Grid, CVMove & Moves)
+	{
+		CFixedBoard <KHeight, KWidth> Board;
+		Board.FromMat (Grid);
+		ListBoardScoringMoves (Board, Moves);
+
+	} // ListFixedScoringMoves ()
+
+	/**
+    *@brief Lists every scoring move of the grid, with the specialized kernel when the size is one of the levels'
+    *@param Grid the grid
+    *@param Moves filled with the scoring moves
+    */
+	void ListScoringMoves (const CMat & Grid, CVMove & Moves)
+	{
+		if (Grid.size () == 6 && Grid [0].size () == 6)
+			ListFixedScoringMoves <6, 6> (Grid, Moves);
+		else if (Grid.size () == 8 && Grid [0].size () == 8)
+			ListFixedScoringMoves <8, 8> (Grid, Moves);
+		else
+		{
+			CMat Copy;
+			GridPool ().Acquire (Copy, Grid.size ());
+			for (unsigned i (0); i < Grid.size (); ++i)
+				Copy [i] = Grid [i];
+
+			CDynBoard Board {Copy};
+			ListBoardScoringMoves (Board, Moves);
+			GridPool ().Release (Copy);
+		}
+
+	} // ListScoringMoves ()
+
+	/*	GRILLES BLOQUÉES
+
+		Les cases vidées ne sont jamais remplies : une grille peut ne plus offrir aucun coup qui rapporte des points. Pour
+		chaque numéro, un masque par ligne indique les cases qui le contiennent. Un coup rapporte des points si deux cases d'un
+		alignement de trois contiennent le numéro et qu'une voisine de la troisième, hors de l'alignement, le contient aussi :
+		les masques testent ces motifs pour toutes les cases d'une ligne à la fois. Une grille qui contient encore une suite
+		n'est jamais bloquée : n'importe quel échange la fait disparaître et marque. */
+
+	/** @brief Bit j is set when cell j of the line holds the number looked for */
+	typedef uint64_t CLineMask;
+
+	/**
+    *@brief Checks whether the grid already holds a run of three, in a row or a column
+    *@param Grid the grid
+    */
+	bool HasRun (const CMat & Grid)
+	{
+		const unsigned Height (Grid.size ());
+		const unsigned Width (Height ? Grid [0].size () : 0);
+		for (unsigned i (0); i < Height; ++i)
+			for (unsigned j (0); j < Width; ++j)
+			{
+				const unsigned Cell (Grid [i][j]);
+				if (Cell == KImpossible) continue;
+				if (j + 2 < Width && Grid [i][j + 1] == Cell && Grid [i][j + 2] == Cell) return true;
+				if (i + 2 < Height && Grid [i + 1][j] == Cell && Grid [i + 2][j] == Cell) return true;
+			}
+		return false;
+
+	} // HasRun ()
+
+	/**
+    *@brief Checks whether at least one swap scores, with the pattern masks : any swap does while a run is left
+    *@param Grid the grid
+    */
+	bool HasScoringMove (const CMat & Grid)
+	{
+		if (HasRun (Grid)) return true;
+
+		const unsigned Height (Grid.size ());
+		const unsigned Width (Height ? Grid [0].size () : 0);
+		if (Width > 64)
+		{
+			CVMove Moves;
+			ListScoringMoves (Grid, Moves);
+			return ! Moves.empty ();
+		}
+
+		/* Masks [v * Height + i] : cases de la ligne i qui contiennent v, NotEmpty [i] : cases non vides de la ligne i */
+		static thread_local vector <CLineMask> Masks;
+		static thread_local vector <CLineMask> NotEmpty;
+		unsigned MaxValue (0);
+		for (const CVLine & Line : Grid)
+			for (unsigned Cell : Line)
+				MaxValue = max (MaxValue, Cell);
+
+		Masks.assign ((MaxValue + 1) * Height, 0);
+		NotEmpty.assign (Height, 0);
+		for (unsigned i (0); i < Height; ++i)
+			for (unsigned j (0); j < Width; ++j)
+				if (Grid [i][j] != KImpossible)
+				{
+					Masks [Grid [i][j] * Height + i] |= CLineMask (1) << j;
+					NotEmpty [i] |= CLineMask (1) << j;
+				}
+
+		for (unsigned Value (1); Value <= MaxValue; ++Value)
+		{
+			const CLineMask * Rows (&Masks [Value * Height]);
+			auto Row = [&] (unsigned i) { return i < Height ? Rows [i] : CLineMask (0); }; // 0 hors de la grille
+			auto Sides = [&] (unsigned i) { return (Row (i) << 1) | (Row (i) >> 1); };	// Voisines à gauche et à droite
+			auto Target = [&] (unsigned i) { return NotEmpty [i] & ~Rows [i]; };		// Cases avec lesquelles échanger
+
+			for (unsigned i (0); i < Height; ++i)
+			{
+				const CLineMask R (Rows [i]);
+				if (! R && ! Row (i + 1)) continue;
+				const CLineMask UpDown (Row (i - 1) | Row (i + 1));
+
+				/* Alignement horizontal : bit j pour les cases j, j + 1, j + 2 */
+				const CLineMask Pair (R & (R >> 1));
+				if ((R & (R >> 2) & (Target (i) >> 1) & (UpDown >> 1))
+					|| (Pair & (Target (i) >> 2) & ((UpDown >> 2) | (R >> 3)))
+					|| (Pair & (Target (i) << 1) & ((UpDown << 1) | (R << 2))))
+					return true;
+
+				/* Alignement vertical : lignes i, i + 1, i + 2, toutes les colonnes à la fois */
+				if (i + 2 >= Height) continue;
+				const CLineMask R1 (Rows [i + 1]), R2 (Rows [i + 2]);
+				if ((R & R2 & Target (i + 1) & Sides (i + 1))
+					|| (R & R1 & Target (i + 2) & (Sides (i + 2) | Row (i + 3)))
+					|| (R1 & R2 & Target (i) & (Sides (i) | Row (i - 1))))
+					return true;
+			}
+		}
+		return false;
+
+	} // HasScoringMove ()
+
+	/**
+    *@brief Reshuffles the numbers of the grid in a single pass : no run, and at least one scoring move
+    *@param Grid the grid, whose empty cells stay in place
+    *@param Rand the random generator
+    *@return false if no such grid exists with these numbers (the grid is then left unchanged)
+    */
+	bool ReshuffleGrid (CMat & Grid, CRandom & Rand)
+	{
+		static thread_local vector <CPosition> Cells;	// Cases non vides
+		static thread_local vector <unsigned> Values;	// Leur valeur avant le mélange
+		static thread_local vector <unsigned> Counts;	// Nombre de chaque numéro restant à placer
+		Cells.clear ();
+		Values.clear ();
+
+		unsigned MaxValue (0);
+		for (unsigned i (0); i < Grid.size (); ++i)
+			for (unsigned j (0); j < Grid [i].size (); ++j)
+				if (Grid [i][j] != KImpossible)
+				{
+					Cells.push_back (make_pair (i, j));
+					Values.push_back (Grid [i][j]);
+					MaxValue = max (MaxValue, Grid [i][j]);
+				}
+
+		Counts.assign (MaxValue + 1, 0);
+		for (unsigned Value : Values) ++Counts [Value];
+
+		/* Le motif du coup gagnant : deux fois le numéro le plus fréquent alignés, un autre numéro, puis le plus fréquent
+		   à côté de ce dernier. Il faut au moins trois exemplaires d'un numéro et un deuxième numéro */
+		unsigned Most (0), Other (0);
+		for (unsigned Value (1); Value <= MaxValue; ++Value)
+		{
+			if (Counts [Value] > Counts [Most])
+			{
+				Other = Counts [Most] ? Most : Other;
+				Most = Value;
+			}
+			else if (Counts [Value] > Counts [Other])
+				Other = Value;
+		}
+		if (Cells.size () < 4 || Counts [Most] < 3 || Counts [Other] == 0) return false;
+
+		CDynBoard Board {Grid};
+		auto IsCell = [&] (int i, int j) { return i >= 0 && j >= 0 && i < int (Grid.size ()) && j < int (Grid [0].size ())
+												   && Grid [i][j] != KImpossible; };
+
+		/* Recherche d'un emplacement pour le motif, à partir d'une case tirée au hasard :
+		   Pattern [0..2] l'alignement de trois cases, Gap l'indice de celle qui reçoit l'autre numéro, Pattern [3] sa voisine */
+		array <CPosition, 4> Pattern;
+		bool Found (false);
+		const unsigned Offset (Rand () % Cells.size ());
+		for (unsigned c (0); c < Cells.size () && ! Found; ++c)
+		{
+			const int i (Cells [(c + Offset) % Cells.size ()].first), j (Cells [(c + Offset) % Cells.size ()].second);
+			for (unsigned Vertical (0); Vertical < 2 && ! Found; ++Vertical)
+			{
+				const int di (Vertical), dj (1 - Vertical);
+				if (! IsCell (i + di, j + dj) || ! IsCell (i + 2 * di, j + 2 * dj)) continue;
+
+				for (int Gap (0); Gap < 3 && ! Found; ++Gap)
+				{
+					const int gi (i + Gap * di), gj (j + Gap * dj);
+					/* Voisines de la case du milieu de part et d'autre de l'alignement, plus dans son prolongement aux bouts */
+					const int Neighbours [4][2] = {{gi + dj, gj + di}, {gi - dj, gj - di},
+												   {gi - di, gj - dj}, {gi + di, gj + dj}};
+					for (unsigned n (0); n < 4 && ! Found; ++n)
+					{
+						if ((n == 2 && Gap != 0) || (n == 3 && Gap != 2)) continue;
+						if (! IsCell (Neighbours [n][0], Neighbours [n][1])) continue;
+
+						for (int k (0); k < 3; ++k)
+							Pattern [k] = make_pair (i + k * di, j + k * dj);
+						Pattern [3] = make_pair (Neighbours [n][0], Neighbours [n][1]);
+						swap (Pattern [Gap], Pattern [2]);	// L'autre numéro va en Pattern [2]
+						Found = true;
+					}
+				}
+			}
+		}
+		if (! Found) return false;
+
+		for (const CPosition & Pos : Cells) Grid [Pos.first][Pos.second] = KImpossible;
+		for (unsigned k (0); k < 4; ++k)
+		{
+			const unsigned Value (k == 2 ? Other : Most);
+			Grid [Pattern [k].first][Pattern [k].second] = Value;
+			--Counts [Value];
+		}
+
+		/* Une case pas encore placée est vide : il suffit de vérifier que chaque case placée n'est pas dans une suite */
+		auto Fits = [&] (const CPosition & Pos, unsigned Value)
+		{
+			Grid [Pos.first][Pos.second] = Value;
+			return ! IsInRun (Board, Pos.first, Pos.second);
+		};
+
+		for (unsigned c (0); c < Cells.size (); ++c)
+		{
+			const CPosition & Pos (Cells [c]);
+			if (Grid [Pos.first][Pos.second] != KImpossible) continue;	// Case du motif
+
+			/* Tirage d'un numéro restant qui ne forme pas de suite, selon le nombre d'exemplaires restants */
+			unsigned Total (0);
+			for (unsigned Value (1); Value <= MaxValue; ++Value)
+				if (Counts [Value] && Fits (Pos, Value)) Total += Counts [Value];
+
+			if (Total != 0)
+			{
+				unsigned Draw (Rand () % Total), Value (1);
+				for (;; ++Value)
+					if (Counts [Value] && Fits (Pos, Value))
+					{
+						if (Draw < Counts [Value]) break;
+						Draw -= Counts [Value];
+					}
+				--Counts [Value];
+				continue;
+			}
+
+			/* Aucun numéro restant ne convient : la case prend le numéro d'une case déjà placée, qui reçoit un numéro restant */
+			bool Repaired (false);
+			for (unsigned q (0); q < c && ! Repaired; ++q)
+			{
+				const CPosition & Placed (Cells [q]);
+				if (find (Pattern.begin (), Pattern.end (), Placed) != Pattern.end ()) continue;
+
+				const unsigned Moved (Grid [Placed.first][Placed.second]);
+				for (unsigned Value (1); Value <= MaxValue && ! Repaired; ++Value)
+				{
+					if (! Counts [Value]) continue;
+					Grid [Placed.first][Placed.second] = Value;
+					Repaired = Fits (Pos, Moved) && ! IsInRun (Board, Placed.first, Placed.second);
+					if (Repaired) --Counts [Value];
+				}
+				if (! Repaired) Grid [Placed.first][Placed.second] = Moved;
+			}
+			if (! Repaired)
+			{
+				/* Trop d'exemplaires d'un même numéro pour éviter toute suite : on remet la grille comme avant */
+				for (unsigned k (0); k < Cells.size (); ++k)
+					Grid [Cells [k].first][Cells [k].second] = Values [k];
+				return false;
+			}
+		}
+		return true;
+
+	} // ReshuffleGrid ()
+
+
+    /**
+    *@brief Initialize the Grid
+    *@param Grid the grid to initialize
+    *@param Size how many column and row
+    *@param NbCandies the maximum number that you can find in this grid
+    *@param Rand the random generator
+    * Initialize a random grid with chosen parameters
+    */
+	void InitGrid (CMat & Grid, unsigned Size, unsigned NbCandies, CRandom & Rand)
+    {
+		SizeGrid (Grid, Size);		// Dimensionne la grille pour qu'elle contienne "Size" lignes de "Size" cases
+
+		/* Tailles des niveaux : noyau spécialisé */
+		if ((Size == 6 || Size == 8) && (NbCandies == 4 || NbCandies == 5))
+		{
+			if (Size == 6)
+				NbCandies == 4 ? InitFixedGrid <6, 6, 4> (Grid, Rand) : InitFixedGrid <6, 6, 5> (Grid, Rand);
+			else
+				NbCandies == 4 ? InitFixedGrid <8, 8, 4> (Grid, Rand) : InitFixedGrid <8, 8, 5> (Grid, Rand);
+			return;
+		}
+
+		/* Au-delà de 8x8, une grille tirée au hasard n'est presque jamais sans suite : chaque case est tirée parmi les
+		   numéros qui ne complètent pas une suite avec les deux cases de gauche ou les deux cases du dessus */
+		if (Size > 8 && NbCandies >= 3)
+		{
+			for (unsigned i (0); i < Size; ++i)
+				for (unsigned j (0); j < Size; ++j)
+				{
+					const unsigned Left (j >= 2 && Grid [i][j - 1] == Grid [i][j - 2] ? Grid [i][j - 1] : KImpossible);
+					const unsigned Up (i >= 2 && Grid [i - 1][j] == Grid [i - 2][j] ? Grid [i - 1][j] : KImpossible);
+					unsigned Value;
+					do
+						Value = (Rand () % NbCandies) + 1;
+					while (Value == Left || Value == Up);
+					Grid [i][j] = Value;
+				}
+			return;
+		}
+
+		CPosition Pos;
+		unsigned HowMany; // osef, c'est juste pour utiliser la fonction de test
+		const CDynBoard Board {Grid};
+
+		/* Génère la grille jusqu'à ce qu'il n'y ait plus de suites dès le début */
+		do {
+			/* Chaque case prend une valeur aléatoire entre 1 et NbCandies */
+			for (CMat::iterator GridIter (Grid.begin ()); GridIter < Grid.end (); ++GridIter)
+				for (CVLine::iterator LineIter (GridIter -> begin ()); LineIter < GridIter -> end (); ++LineIter)
+					*LineIter = (Rand () % NbCandies) + 1;
+
+		} while (FindRunInColumn (Board, Pos, HowMany) || FindRunInRow (Board, Pos, HowMany));
+
+    } // InitGrid ()
+
+    /**
+    *@brief Initialize the Grid from the system time
+    *@param Grid the grid to initialize
+    *@param Size how many column and row
+    *@param NbCandies the maximum number that you can find in this grid
+    */
+	void InitGrid (CMat & Grid, unsigned Size, unsigned NbCandies)
+	{
+		CRandom Rand (time (NULL)); 	// Initialise la génération aléatoire (en fonction du temps système)
+		InitGrid (Grid, Size, NbCandies, Rand);
+
+	} // InitGrid ()
+
+	/**
+    *@brief ArrangeGrid under the rules TRules
+    *@param Grid the grid to arrange
+    *@param Score the score to increase
+    *@param PointsEarned, ComboMeter points and removals already made by the move
+    */
+	template <typename TRules>
+	void ArrangeRulesGrid (CMat & Grid, unsigned & Score, unsigned PointsEarned = 0, unsigned ComboMeter = 0)
+	{
+		/* Choisit le noyau spécialisé quand la grille a la taille d'un des niveaux */
+		if (Grid.size () == 6 && Grid [0].size () == 6)
+			ArrangeFixedGrid <TRules, 6, 6> (Grid, Score, PointsEarned, ComboMeter);
+		else if (Grid.size () == 8 && Grid [0].size () == 8)
+			ArrangeFixedGrid <TRules, 8, 8> (Grid, Score, PointsEarned, ComboMeter);
+		else
+		{
+			CDynBoard Board {Grid};
+			ArrangeBoard <TRules> (Board, Score, PointsEarned, ComboMeter);
+		}
+
+	} // ArrangeRulesGrid ()
+
+	/*	Détecte et supprime les suites de nombres identiques */
+    /**
+    *@brief Arrange Grid
+    *@param Grid the grid to arrange
+    *@param Score calculate the score
+    *@param PointsEarned, ComboMeter points and removals already made by the move (its shapes)
+    */
+    void ArrangeGrid (CMat & Grid, unsigned & Score, unsigned PointsEarned = 0, unsigned ComboMeter = 0)
+    {
+		ArrangeRulesGrid <CClassicRules> (Grid, Score, PointsEarned, ComboMeter);
+
+	} // ArrangeGrid ()
+
+	/*	FORMES SPÉCIALES
+
+		Les cases d'un coup qui forment une suite sont regroupées en une seule passe : chaque suite réunit ses cases
+		(union-find), deux cases voisines de même numéro dans des suites différentes aussi. Chaque groupe est classé (ligne
+		de 3, 4, 5, L, T, croix ou bloc) et rapporte un bonus selon sa forme. Seules les suites qui passent par les cases
+		modifiées sont parcourues, puis celles qui croisent leurs cases : le coût est proportionnel au nombre de cases du
+		coup, pas à la taille de la grille.
+		Les groupes sont supprimés d'un seul coup, toutes leurs cases à la fois : un groupe compte pour une suppression, qui
+		rapporte les points d'une suite de sa taille. ArrangeGrid supprime ensuite les suites que les chutes ont formées,
+		en continuant le compte des points et des suppressions du coup. */
+
+	/** @brief The shapes of the groups of a move */
+	enum CShape : unsigned char { KLine3, KLine4, KLine5, KShapeL, KShapeT, KCross, KBlock, KNbShapes };
+
+	/** @brief What a shape earns, on top of the points of its runs */
+	struct CShapeRule
+	{
+		const char * Name;
+		unsigned Bonus;
+	};
+
+	/** @brief Rules of each shape, in the order of CShape */
+	const array <CShapeRule, KNbShapes> KShapeRules {{ {"Ligne de 3", 0}, {"Ligne de 4", 0}, {"Ligne de 5", 10},
+													   {"Forme en L", 10}, {"Forme en T", 15}, {"Croix", 20}, {"Bloc", 5} }};
+
+	/** @brief A group of cells of the same number, connected through their runs */
+	struct CMatchGroup
+	{
+		unsigned Value;
+		CShape Shape;
+		unsigned NbCells;
+	};
+
+	/** @brief Alias to a vector of groups */
+	typedef vector <CMatchGroup> CVMatchGroup;
+
+	/** @brief A run found by FindMatchGroups */
+	struct CRun
+	{
+		unsigned First;		// Indice i * Largeur + j de sa première case
+		unsigned Length;
+		bool Vertical;
+	};
+
+	/**
+    *@brief Finds the groups of runs that go through the changed cells, and the runs that cross them, and classifies them
+    *@param Grid the grid, after the move
+    *@param Changed the cells changed by the move
+    *@param NbChanged how many cells changed
+    *@param Groups filled with the groups found
+    *@param Cells filled with the cells of the groups, i * Width + j
+    */
+	void FindMatchGroups (const CMat & Grid, const CPosition * Changed, unsigned NbChanged, CVMatchGroup & Groups,
+						  vector <unsigned> & Cells)
+	{
+		/* Tableaux indicés par case : une case n'est valide pour ce coup que si son Stamp vaut Generation, ce qui évite de
+		   les remettre à zéro à chaque coup */
+		static thread_local vector <uint32_t> Stamp, Parent, Size, RowSeen, ColumnSeen, GroupSeen, GroupOf;
+		static thread_local vector <unsigned> Work;
+		static thread_local vector <CRun> Runs;
+		static thread_local vector <array <unsigned, 4> > Counts; // Par groupe : suites horizontales, verticales, première de chaque sens
+		static thread_local uint32_t Generation (0);
+
+		Groups.clear ();
+		Cells.clear ();
+		if (Grid.empty ()) return;
+
+		const unsigned Height (Grid.size ()), Width (Grid [0].size ()), NbCells (Height * Width);
+		if (Stamp.size () < NbCells)
+		{
+			/* Une case est dans au plus deux suites : rien ne sera plus alloué pour cette taille de grille */
+			for (vector <uint32_t> * Array : {&Stamp, &Parent, &Size, &RowSeen, &ColumnSeen, &GroupSeen, &GroupOf})
+				Array -> resize (NbCells, 0);
+			Work.reserve (NbCells);
+			Runs.reserve (NbCells);
+			Counts.reserve (NbCells);
+		}
+		if (Groups.capacity () < NbCells) Groups.reserve (NbCells);
+		if (Cells.capacity () < NbCells) Cells.reserve (NbCells);
+		if (++Generation == 0)
+		{
+			for (vector <uint32_t> * Array : {&Stamp, &RowSeen, &ColumnSeen, &GroupSeen})
+				fill (Array -> begin (), Array -> end (), 0);
+			Generation = 1;
+		}
+		Work.clear ();
+		Runs.clear ();
+
+		auto Value = [&] (unsigned Cell) { return Grid [Cell / Width][Cell % Width]; };
+		auto Find = [&] (unsigned Cell)
+		{
+			while (Parent [Cell] != Cell)
+			{
+				Parent [Cell] = Parent [Parent [Cell]];
+				Cell = Parent [Cell];
+			}
+			return Cell;
+		};
+		auto Union = [&] (unsigned A, unsigned B)
+		{
+			A = Find (A);
+			B = Find (B);
+			if (A == B) return;
+			if (Size [A] < Size [B]) swap (A, B);
+			Parent [B] = A;
+			Size [A] += Size [B];
+		};
+		auto Match = [&] (unsigned Cell)
+		{
+			if (Stamp [Cell] == Generation) return;
+			Stamp [Cell] = Generation;
+			Parent [Cell] = Cell;
+			Size [Cell] = 1;
+			Work.push_back (Cell);
+		};
+
+		/* Parcourt la ligne ou la colonne de la case : une suite d'au moins trois réunit ses cases et les ajoute au travail */
+		auto Scan = [&] (unsigned Cell, bool Vertical)
+		{
+			vector <uint32_t> & Seen (Vertical ? ColumnSeen : RowSeen);
+			if (Seen [Cell] == Generation) return;
+
+			const unsigned Number (Value (Cell)), Step (Vertical ? Width : 1);
+			const unsigned i (Cell / Width), j (Cell % Width);
+			unsigned Before (0), After (0);
+			while ((Vertical ? i : j) > Before && Value (Cell - (Before + 1) * Step) == Number) ++Before;
+			while ((Vertical ? i + After + 1 < Height : j + After + 1 < Width) && Value (Cell + (After + 1) * Step) == Number) ++After;
+
+			const unsigned First (Cell - Before * Step), Length (Before + After + 1);
+			for (unsigned k (0); k < Length; ++k)
+				Seen [First + k * Step] = Generation;
+			if (Length < 3) return;
+
+			Runs.push_back (CRun {First, Length, Vertical});
+			for (unsigned k (0); k < Length; ++k)
+			{
+				Match (First + k * Step);
+				Union (First, First + k * Step);
+			}
+		};
+
+		for (unsigned c (0); c < NbChanged; ++c)
+		{
+			const unsigned Cell (Changed [c].first * Width + Changed [c].second);
+			if (Changed [c].first >= Height || Changed [c].second >= Width || Value (Cell) == KImpossible) continue;
+			Scan (Cell, false);
+			Scan (Cell, true);
+		}
+		for (unsigned w (0); w < Work.size (); ++w)
+		{
+			Scan (Work [w], false);
+			Scan (Work [w], true);
+		}
+
+		/* Deux suites parallèles qui se touchent forment un seul groupe */
+		for (unsigned Cell : Work)
+		{
+			if (Cell % Width + 1 < Width && Stamp [Cell + 1] == Generation && Value (Cell + 1) == Value (Cell))
+				Union (Cell, Cell + 1);
+			if (Cell + Width < NbCells && Stamp [Cell + Width] == Generation && Value (Cell + Width) == Value (Cell))
+				Union (Cell, Cell + Width);
+		}
+
+		/* Regroupement des suites par groupe : une première suite horizontale et verticale suffisent à classer les L et T */
+		Counts.clear ();
+		for (unsigned r (0); r < Runs.size (); ++r)
+		{
+			const unsigned Root (Find (Runs [r].First));
+			if (GroupSeen [Root] != Generation)
+			{
+				GroupSeen [Root] = Generation;
+				GroupOf [Root] = Groups.size ();
+				Groups.push_back (CMatchGroup {Value (Root), KLine3, Size [Root]});
+				Counts.push_back (array <unsigned, 4> {{0, 0, 0, 0}});
+			}
+
+			array <unsigned, 4> & Count (Counts [GroupOf [Root]]);
+			if (Count [Runs [r].Vertical] ++ == 0) Count [2 + Runs [r].Vertical] = r;
+		}
+
+		for (unsigned g (0); g < Groups.size (); ++g)
+		{
+			const array <unsigned, 4> & Count (Counts [g]);
+			CMatchGroup & Group (Groups [g]);
+
+			if (Count [0] + Count [1] == 1)
+			{
+				const unsigned Length (Runs [Count [2 + Count [1]]].Length);
+				Group.Shape = Length == 3 ? KLine3 : Length == 4 ? KLine4 : KLine5;
+			}
+			else if (Count [0] == 1 && Count [1] == 1)
+			{
+				/* Une suite de chaque sens : la forme dépend de l'endroit où elles se croisent */
+				const CRun & Row (Runs [Count [2]]), & Column (Runs [Count [3]]);
+				const unsigned RowLine (Row.First / Width), RowStart (Row.First % Width);
+				const unsigned ColumnStart (Column.First / Width), ColumnCol (Column.First % Width);
+
+				if (ColumnCol < RowStart || ColumnCol >= RowStart + Row.Length
+					|| RowLine < ColumnStart || RowLine >= ColumnStart + Column.Length)
+					Group.Shape = KBlock;
+				else
+				{
+					const bool RowEnd (ColumnCol == RowStart || ColumnCol + 1 == RowStart + Row.Length);
+					const bool ColumnEnd (RowLine == ColumnStart || RowLine + 1 == ColumnStart + Column.Length);
+					Group.Shape = RowEnd && ColumnEnd ? KShapeL : RowEnd || ColumnEnd ? KShapeT : KCross;
+				}
+			}
+			else
+				Group.Shape = KBlock;
+		}
+		Cells.assign (Work.begin (), Work.end ());
+
+	} // FindMatchGroups ()
+
+	/**
+    *@brief Points of the groups of a move : each is one removal, worth as much as a run of its size, plus the bonus of its shape
+    *@param Groups the groups
+    *@param Score increased by the bonus of the shapes
+    *@param PointsEarned increased by the points of the groups, multiplied at the end of the move as those of the runs
+    *@param ComboMeter increased by the number of groups
+    */
+	void ScoreMatchGroups (const CVMatchGroup & Groups, unsigned & Score, unsigned & PointsEarned, unsigned & ComboMeter)
+	{
+		for (const CMatchGroup & Group : Groups)
+		{
+			Score += KShapeRules [Group.Shape].Bonus;
+			PointsEarned += CTriangleScoring::Points (Group.NbCells);
+			++ComboMeter;
+		}
+
+	} // ScoreMatchGroups ()
+
+	/**
+    *@brief Cell next to Pos in the direction
+    *@param Pos the cell
+    *@param Direction one of the movement keys
+    */
+	CPosition NeighbourOf (const CPosition & Pos, char Direction)
+	{
+		if (Direction == KeyUp) return make_pair (Pos.first - 1, Pos.second);
+		if (Direction == KeyDown) return make_pair (Pos.first + 1, Pos.second);
+		if (Direction == KeyLeft) return make_pair (Pos.first, Pos.second - 1);
+		return make_pair (Pos.first, Pos.second + 1);
+
+	} // NeighbourOf ()
+
+	/*	FLUX D'ÉVÉNEMENTS
+
+		Le moteur décrit chaque coup par une suite d'événements : échange, suppression d'une suite, chute d'un bloc de cases,
+		points gagnés. Ils sont écrits dans un anneau (CEventStream), alloué une fois pour toutes à la taille de la grille, et
+		chaque consommateur les lit à son rythme avec son propre curseur (CEventReader) : il peut les lire par paquets, ignorer
+		ceux qui ne l'intéressent pas ou sauter directement aux derniers. Un coup publie au plus deux événements par case
+		supprimée, plus l'échange et les points : l'anneau contient toujours un coup entier. Un lecteur qui laisse passer
+		plusieurs coups perd les plus anciens, qu'il compte, et se resynchronise.
+		Sans flux (pointeur NULL), le moteur n'écrit rien : les parties sans affichage ne paient rien.
+		Rejouer les événements d'un coup sur la grille d'avant le coup (ApplyEvent) redonne exactement la grille d'après. */
+
+	enum CEventKind : unsigned char { KSwapped, KCleared, KFell, KScoreChanged };
+
+	struct CEvent
+	{
+		CEventKind Kind;
+		char Direction;		// Échange : direction du coup ; suppression : KeyRight pour une ligne, KeyDown pour une colonne
+		uint16_t Row;		// Case sélectionnée, première case de la suite ou première case du bloc qui tombe
+		uint16_t Column;
+		uint16_t Length;	// Longueur de la suite, ou nombre de cases du bloc qui tombe
+		uint16_t To;		// Chute : ligne d'arrivée de la première case du bloc
+		uint16_t Group;		// Suppression : numéro de la suppression dans le coup, à partir de 1
+		uint32_t Value;		// Suppression : numéro supprimé ; points : points gagnés par le coup
+	};
+
+	class CEventStream
+	{
+	  public:
+		static const unsigned KMinCapacity = 256;	// Puissance de 2
+
+	  private:
+		vector <CEvent> Ring;	// Taille : puissance de 2
+		uint64_t Head;			// Nombre d'événements écrits depuis le début
+		uint64_t Oldest;		// Premier événement encore dans l'anneau, après un agrandissement
+
+	  public:
+		/** @brief A stream that holds every event of one move on a grid of NbCells cells */
+		explicit CEventStream (unsigned NbCells = 0) : Head (0), Oldest (0) { Fit (NbCells); }
+
+		/**
+		*@brief Grows the ring, if needed, to hold every event of one move on a grid of NbCells cells
+		* The events not read yet are kept
+		*/
+		void Fit (unsigned NbCells)
+		{
+			size_t Capacity (KMinCapacity);
+			while (Capacity < 2 * size_t (NbCells) + 2) Capacity *= 2;
+			if (Capacity <= Ring.size ()) return;
+
+			vector <CEvent> Larger (Capacity);
+			Oldest = Head > Ring.size () ? Head - Ring.size () : 0;
+			for (uint64_t e (Oldest); e < Head; ++e)
+				Larger [e % Capacity] = Ring [e % Ring.size ()];
+			Ring.swap (Larger);
+		}
+
+		void Publish (const CEvent & Event) { Ring [Head++ % Ring.size ()] = Event; }
+
+		/** @brief Position of the next event to be written */
+		uint64_t End () const { return Head; }
+
+		/**
+		*@brief Copies the events written after Cursor, and moves Cursor after them
+		*@param Cursor the position of the reader
+		*@param Out receives at most Max events
+		*@param Dropped increased by the number of events overwritten before being read
+		*@return the number of events copied
+		*/
+		unsigned Read (uint64_t & Cursor, CEvent * Out, unsigned Max, uint64_t & Dropped) const
+		{
+			const uint64_t First (max (Oldest, Head > Ring.size () ? Head - Ring.size () : 0));
+			if (Cursor < First)
+			{
+				Dropped += First - Cursor;
+				Cursor = First;
+			}
+			unsigned NbRead (0);
+			for (; Cursor < Head && NbRead < Max; ++Cursor)
+				Out [NbRead++] = Ring [Cursor % Ring.size ()];
+			return NbRead;
+		}
+	};
+
+	/** @brief A subscription to an event stream : it only reads the events written after it was made */
+	struct CEventReader
+	{
+		const CEventStream & Stream;
+		uint64_t Cursor;
+		uint64_t Dropped;
+
+		explicit CEventReader (const CEventStream & Source) : Stream (Source), Cursor (Source.End ()), Dropped (0) {}
+
+		unsigned Read (CEvent * Out, unsigned Max) { return Stream.Read (Cursor, Out, Max, Dropped); }
+		void Skip () { Cursor = Stream.End (); }
+	};
+
+	/**
+    *@brief Publishes an event if there is a stream
+    */
+	inline void Emit (CEventStream * Events, CEventKind Kind, char Direction, unsigned Row, unsigned Column,
+					  unsigned Length = 0, unsigned To = 0, unsigned Group = 0, uint32_t Value = 0)
+	{
+		if (Events == NULL) return;
+		Events -> Publish (CEvent {Kind, Direction, uint16_t (Row), uint16_t (Column), uint16_t (Length), uint16_t (To),
+								   uint16_t (Group), Value});
+
+	} // Emit ()
+
+	/**
+    *@brief Publishes the events of the removal of a run, in the same order as ClearRunInRow and ClearRunInColumn move the cells
+    *@param Events the stream, or NULL
+    *@param Grid the grid, before the removal
+    *@param Pos the first cell of the run
+    *@param HowMany the length of the run
+    *@param Vertical true for a run in a column
+    *@param Group the number of the removal in the move
+    */
+	void EmitRemoval (CEventStream * Events, const CMat & Grid, const CPosition & Pos, unsigned HowMany, bool Vertical, unsigned Group)
+	{
+		if (Events == NULL) return;
+
+		const unsigned i (Pos.first), j (Pos.second);
+		Emit (Events, KCleared, Vertical ? KeyDown : KeyRight, i, j, HowMany, 0, Group, Grid [i][j]);
+		if (! Vertical)
+		{
+			/* Dans chaque colonne, les i cases au-dessus de la suite descendent d'une ligne */
+			if (i != 0)
+				for (unsigned Column (j); Column < j + HowMany; ++Column)
+					Emit (Events, KFell, KeyDown, 0, Column, i, 1);
+		}
+		else
+			/* Chaque case au-dessus de la suite descend de HowMany lignes, l'une après l'autre en partant du haut */
+			for (unsigned Row (0); Row < i; ++Row)
+				Emit (Events, KFell, KeyDown, Row, j, 1, Row + HowMany);
+
+	} // EmitRemoval ()
+
+	/**
+    *@brief Applies an event to a grid
+    *@param Grid the grid, as it was before the event
+    *@param Event the event
+    */
+	void ApplyEvent (CMat & Grid, const CEvent & Event)
+	{
+		switch (Event.Kind)
+		{
+			case KSwapped:
+				MakeAMove (Grid, make_pair (Event.Row, Event.Column), Event.Direction);
+				break;
+
+			case KCleared:
+				for (unsigned k (0); k < Event.Length; ++k)
+					(Event.Direction == KeyDown ? Grid [Event.Row + k][Event.Column] : Grid [Event.Row][Event.Column + k]) = KImpossible;
+				break;
+
+			case KFell:
+				/* Le bloc est recopié en partant du bas, puis les cases qu'il a quittées sont vidées */
+				for (unsigned k (Event.Length); k-- > 0;)
+					Grid [Event.To + k][Event.Column] = Grid [Event.Row + k][Event.Column];
+				for (unsigned Row (Event.Row); Row < min <unsigned> (Event.Row + Event.Length, Event.To); ++Row)
+					Grid [Row][Event.Column] = KImpossible;
+				break;
+
+			case KScoreChanged:
+				break;
+		}
+
+	} // ApplyEvent ()
+
+	/**
+    *@brief Removes the cells of the groups of a move all at once : the cells above each of them fall
+    *@param Grid the grid, after the swap
+    *@param Cells the cells of the groups (FindMatchGroups), sorted here by column then line
+    *@param Events receives a removal, numbered 1, and the fall of the cells above it for each piece of a column, if not NULL
+    */
+	void ClearMatchGroups (CMat & Grid, vector <unsigned> & Cells, CEventStream * Events = NULL)
+	{
+		if (Cells.empty ()) return;
+		const unsigned Width (Grid [0].size ());
+		sort (Cells.begin (), Cells.end (), [Width] (unsigned A, unsigned B)
+			  { return A % Width != B % Width ? A % Width < B % Width : A < B; });
+
+		/* Dans une colonne, les morceaux sont supprimés de haut en bas : une suppression ne déplace que les cases du dessus,
+		   et les morceaux suivants restent en place. Les cases du dessus tombent d'un bloc, en partant du bas */
+		for (unsigned c (0); c < Cells.size ();)
+		{
+			const unsigned First (Cells [c]), i (First / Width), j (First % Width);
+			unsigned HowMany (1);
+			while (c + HowMany < Cells.size () && Cells [c + HowMany] == First + HowMany * Width) ++HowMany;
+
+			Emit (Events, KCleared, KeyDown, i, j, HowMany, 0, 1, Grid [i][j]);
+			if (i != 0) Emit (Events, KFell, KeyDown, 0, j, i, HowMany);
+			for (unsigned Row (i + HowMany); Row-- > HowMany;)
+				Grid [Row][j] = Grid [Row - HowMany][j];
+			for (unsigned Row (0); Row < HowMany; ++Row)
+				Grid [Row][j] = KImpossible;
+			c += HowMany;
+		}
+
+	} // ClearMatchGroups ()
+
+	/**
+    *@brief Plays a move (which must be valid) : swap, removal of the groups formed with the bonus of their shapes, then
+    * removal of the runs made by the falls
+    *@param Grid the grid
+    *@param Pos the selected cell
+    *@param Direction the direction of the swap
+    *@param Score the score to increase
+    *@param Groups filled with the groups formed by the swap
+    */
+	void PlayMove (CMat & Grid, const CPosition & Pos, char Direction, unsigned & Score, CVMatchGroup & Groups)
+	{
+		static thread_local vector <unsigned> Cells;
+		MakeAMove (Grid, Pos, Direction);
+
+		const CPosition Changed [2] = {Pos, NeighbourOf (Pos, Direction)};
+		FindMatchGroups (Grid, Changed, 2, Groups, Cells);
+		unsigned PointsEarned (0), ComboMeter (0);
+		ScoreMatchGroups (Groups, Score, PointsEarned, ComboMeter);
+		ClearMatchGroups (Grid, Cells);
+
+		ArrangeGrid (Grid, Score, PointsEarned, ComboMeter);
+
+	} // PlayMove ()
+
+	/**
+    *@brief Same as PlayMove, when the groups are not needed
+    */
+	void PlayMove (CMat & Grid, const CPosition & Pos, char Direction, unsigned & Score)
+	{
+		static thread_local CVMatchGroup Groups;
+		PlayMove (Grid, Pos, Direction, Score, Groups);
+
+	} // PlayMove ()
+
+	/** @brief Consumer : shows each removal of a chain reaction, by replaying the events on its own copy of the grid */
+	struct CStepRenderer
+	{
+		CEventReader Reader;
+		CMat Shown;				// Grille telle qu'elle a été affichée
+		unsigned DelayMs;
+
+		explicit CStepRenderer (const CEventStream & Stream, unsigned Delay = 400) : Reader (Stream), DelayMs (Delay) {}
+
+		/** @brief Forgets the pending events : Grid was changed outside of the engine (undo, reshuffle...) */
+		void Reset (const CMat & Grid)
+		{
+			Shown = Grid;
+			Reader.Skip ();
+		}
+
+		/**
+		*@brief Replays the pending events, showing the grid before each removal but the first of a move
+		*@param Grid the grid after the events : the copy starts again from it if events were lost
+		*/
+		void Consume (const CMat & Grid)
+		{
+			CEvent Batch [32];
+			const uint64_t Dropped (Reader.Dropped);
+			for (unsigned NbRead; (NbRead = Reader.Read (Batch, 32)) != 0;)
+			{
+				/* Des événements ont été écrasés : rejouer la suite donnerait une grille fausse */
+				if (Reader.Dropped != Dropped)
+				{
+					Reset (Grid);
+					return;
+				}
+				for (unsigned e (0); e < NbRead; ++e)
+				{
+					/* La suppression précédente et ses chutes sont finies : on montre la grille avant la suivante */
+					if (Batch [e].Kind == KCleared && Batch [e].Group > 1)
+						Draw (Batch [e].Group - 1);
+					ApplyEvent (Shown, Batch [e]);
+				}
+			}
+
+		} // Consume ()
+
+		void Draw (unsigned Removal)
+		{
+			ostringstream Message;
+			Message << "Réaction en chaîne : suppression " << Removal;
+			DisplayGrid (Shown, Message.str ());
+			#ifdef _WIN32
+				Sleep (DelayMs);
+			#else
+				usleep (DelayMs * 1000);
+			#endif
+
+		} // Draw ()
+	};
+
+	/** @brief Consumer : appends the swaps and the points of each move to a binary journal, one write per batch */
+	struct CMoveJournal
+	{
+		CEventReader Reader;
+		ofstream File;
+		uint64_t Dropped;		// Événements perdus déjà vus
+		bool Resyncing;			// Des événements ont été perdus : rien n'est écrit avant l'échange suivant
+
+		CMoveJournal (const CEventStream & Stream, const string & Path, bool Append)
+			: Reader (Stream), File (Path, ios::binary | (Append ? ios::app : ios::trunc)), Dropped (0), Resyncing (false) {}
+
+		void Consume ()
+		{
+			CEvent Batch [32];
+			for (unsigned NbRead; (NbRead = Reader.Read (Batch, 32)) != 0;)
+			{
+				/* Un coup dont l'échange a été écrasé n'est pas écrit à moitié : le journal reprend au coup suivant */
+				if (Reader.Dropped != Dropped)
+				{
+					Dropped = Reader.Dropped;
+					Resyncing = true;
+				}
+
+				/* Les suppressions et les chutes se déduisent des échanges : elles ne sont pas écrites */
+				unsigned NbKept (0);
+				for (unsigned e (0); e < NbRead; ++e)
+				{
+					Resyncing &= Batch [e].Kind != KSwapped;
+					if (! Resyncing && (Batch [e].Kind == KSwapped || Batch [e].Kind == KScoreChanged))
+						Batch [NbKept++] = Batch [e];
+				}
+				File.write (reinterpret_cast <const char *> (Batch), NbKept * sizeof (CEvent));
+			}
+			File.flush ();
+
+		} // Consume ()
+	};
+
+	/** @brief Consumer : statistics of a game */
+	struct CTelemetry
+	{
+		CEventReader Reader;
+		unsigned NbMoves = 0;
+		unsigned NbRemovals = 0;	// Les groupes d'un coup, supprimés ensemble, en font une
+		unsigned NbCellsCleared = 0;
+		unsigned NbFalls = 0;
+		unsigned LongestChain = 0;	// Plus grand nombre de suppressions en un coup
+		unsigned BestMove = 0;		// Plus grand nombre de points en un coup
+		unsigned Removal = 0;		// Numéro de la dernière suppression du coup
+
+		explicit CTelemetry (const CEventStream & Stream) : Reader (Stream) {}
+
+		void Consume ()
+		{
+			CEvent Batch [32];
+			for (unsigned NbRead; (NbRead = Reader.Read (Batch, 32)) != 0;)
+				for (unsigned e (0); e < NbRead; ++e)
+					switch (Batch [e].Kind)
+					{
+						case KSwapped:		++NbMoves; Removal = 0;												break;
+						case KCleared:		NbRemovals += Batch [e].Group != Removal; Removal = Batch [e].Group;
+											NbCellsCleared += Batch [e].Length;
+											LongestChain = max <unsigned> (LongestChain, Batch [e].Group);		break;
+						case KFell:			NbFalls += Batch [e].Length;										break;
+						case KScoreChanged:	BestMove = max (BestMove, Batch [e].Value);						break;
+					}
+
+		} // Consume ()
+	};
+
+	/*	INDEX DES SUITES
+
+		Pour chaque case, CRunIndex garde le nombre de cases identiques qui la suivent à gauche, à droite, en haut et en bas.
+		Un échange, une suppression de suite ne modifient que quelques lignes et colonnes : seules celles-ci sont recalculées.
+		Savoir si un échange crée une suite, et de quelle longueur, ne demande alors que six lectures ; trouver la première
+		suite de la grille revient à trouver la première ligne (colonne) marquée comme en contenant une.
+		L'index garde sa propre copie des numéros, entourée d'une bordure de cases vides qui évite de tester les bords.
+		Les fonctions qui modifient la grille la reçoivent ; elle ne doit pas être modifiée ailleurs sans appeler Rebuild ().
+		Elles décrivent leurs modifications dans le flux d'événements qu'on leur passe, s'il y en a un. */
+
+	class CRunIndex
+	{
+		unsigned Height, Width, Stride;				// Stride = Width + 2, à cause de la bordure
+		vector <uint8_t> Cells;						// La case (i, j) est en (i + 1) * Stride + j + 1
+		vector <uint16_t> Left, Right, Up, Down;	// Cases identiques consécutives, 0 pour une case vide
+		vector <uint64_t> RowsWithRun;				// Bit i : la ligne i contient une suite d'au moins trois
+		vector <uint64_t> ColumnsWithRun;
+
+		unsigned CellOf (unsigned i, unsigned j) const { return (i + 1) * Stride + j + 1; }
+
+		static void SetBit (vector <uint64_t> & Bits, unsigned Index, bool Value)
+		{
+			if (Value)
+				Bits [Index / 64] |= uint64_t (1) << (Index % 64);
+			else
+				Bits [Index / 64] &= ~(uint64_t (1) << (Index % 64));
+		}
+
+		/** @brief Index of the first bit set, or Size if none */
+		static unsigned FirstBit (const vector <uint64_t> & Bits, unsigned Size)
+		{
+			for (unsigned w (0); w < Bits.size (); ++w)
+				if (Bits [w])
+					#ifdef __GNUC__
+						return w * 64 + __builtin_ctzll (Bits [w]);
+					#else
+						for (unsigned b (0); ; ++b)
+							if ((Bits [w] >> b) & 1) return w * 64 + b;
+					#endif
+			return Size;
+		}
+
+		void UpdateRow (const CMat & Grid, unsigned i)
+		{
+			const CVLine & Line (Grid [i]);
+			const unsigned First (CellOf (i, 0));
+			uint8_t * const V (&Cells [First]);
+			uint16_t * const L (&Left [First]), * const R (&Right [First]);
+			bool HasRun (false);
+
+			for (unsigned j (0); j < Width; ++j)
+				V [j] = Line [j];
+
+			/* Les comparaisons servent de masque plutôt que de test : sur une grille tirée au hasard, un branchement se tromperait
+			   une fois sur deux */
+			unsigned Count (0);
+			for (unsigned j (0), Previous (KImpossible); j < Width; Previous = V [j++])
+			{
+				Count = (Count + 1) & -unsigned ((V [j] != KImpossible) & (V [j] == Previous));
+				L [j] = Count;
+				HasRun |= Count >= 2;
+			}
+			Count = 0;
+			for (unsigned j (Width), Next (KImpossible); j-- > 0; Next = V [j])
+			{
+				Count = (Count + 1) & -unsigned ((V [j] != KImpossible) & (V [j] == Next));
+				R [j] = Count;
+			}
+
+			SetBit (RowsWithRun, i, HasRun);
+		}
+
+		/* Lit la copie des numéros : les lignes modifiées doivent avoir été mises à jour avant */
+		void UpdateColumn (unsigned j)
+		{
+			const unsigned First (CellOf (0, j)), Last (CellOf (Height - 1, j));
+			bool HasRun (false);
+
+			unsigned Count (0);
+			for (unsigned c (First); c <= Last; c += Stride)
+			{
+				Count = (Count + 1) & -unsigned ((Cells [c] != KImpossible) & (Cells [c] == Cells [c - Stride]));
+				Up [c] = Count;
+				HasRun |= Count >= 2;
+			}
+			Count = 0;
+			for (unsigned c (Last + Stride); c != First;)
+			{
+				c -= Stride;
+				Count = (Count + 1) & -unsigned ((Cells [c] != KImpossible) & (Cells [c] == Cells [c + Stride]));
+				Down [c] = Count;
+			}
+
+			SetBit (ColumnsWithRun, j, HasRun);
+		}
+
+		void UpdateRows (const CMat & Grid, unsigned First, unsigned Last)
+		{
+			for (unsigned i (First); i <= Last; ++i) UpdateRow (Grid, i);
+		}
+
+		void UpdateColumns (unsigned First, unsigned Last)
+		{
+			for (unsigned j (First); j <= Last; ++j) UpdateColumn (j);
+		}
+
+		/** @brief Number of cells equal to Value after Cell in the direction Step, Counts being the counts of that direction */
+		unsigned Along (unsigned Cell, int Step, const uint16_t * Counts, unsigned Value) const
+		{
+			return Cells [Cell + Step] == Value ? 1 + Counts [Cell + Step] : 0;
+		}
+
+		/** @brief Same as SwapRunLength, with the index of the cell and the step to its neighbour */
+		unsigned SwapLength (unsigned From, int Step) const
+		{
+			const unsigned To (From + Step);
+			const unsigned Value (Cells [From]), OtherValue (Cells [To]);	// Une case de la bordure vaut KImpossible
+			if (Value == KImpossible || OtherValue == KImpossible || Value == OtherValue) return 0;
+
+			const bool Horizontal (Step == 1 || Step == -1);
+			const int Across (Horizontal ? int (Stride) : 1);
+			const uint16_t * const Ahead  (Step == 1 ? &Right [0] : Step == -1 ? &Left [0] : Step > 0 ? &Down [0] : &Up [0]);
+			const uint16_t * const Behind (Step == 1 ? &Left [0] : Step == -1 ? &Right [0] : Step > 0 ? &Up [0] : &Down [0]);
+			const uint16_t * const Before (Horizontal ? &Up [0] : &Left [0]);
+			const uint16_t * const After  (Horizontal ? &Down [0] : &Right [0]);
+
+			/* Value arrive en To, où elle prolonge les cases qui la suivent dans le sens de l'échange, ou qui l'entourent
+			   dans l'autre sens ; la case qu'elle quitte ne compte pas. De même pour OtherValue en From */
+			const unsigned Length (max (max (1 + Along (To, Step, Ahead, Value),
+											 1 + Along (To, -Across, Before, Value) + Along (To, Across, After, Value)),
+										max (1 + Along (From, -Step, Behind, OtherValue),
+											 1 + Along (From, -Across, Before, OtherValue) + Along (From, Across, After, OtherValue))));
+			return Length >= 3 ? Length : 0;
+		}
+
+	  public:
+		CRunIndex () : Height (0), Width (0), Stride (2) {}
+
+		/** @brief Computes the whole index of the grid */
+		void Rebuild (const CMat & Grid)
+		{
+			Height = Grid.size ();
+			Width = Height ? Grid [0].size () : 0;
+			Stride = Width + 2;
+			Cells.assign ((Height + 2) * Stride, KImpossible);
+			for (vector <uint16_t> * Counts : {&Left, &Right, &Up, &Down})
+				Counts -> assign (Cells.size (), 0);
+			RowsWithRun.assign ((Height + 63) / 64, 0);
+			ColumnsWithRun.assign ((Width + 63) / 64, 0);
+
+			if (Width == 0) return;
+			UpdateRows (Grid, 0, Height - 1);
+			UpdateColumns (0, Width - 1);
+		}
+
+		/**
+		*@brief Length of the longest run created by a swap, 0 if it does not create any
+		*@param Pos the selected cell, which must be in the grid
+		*@param Direction the direction of the swap (0 is returned if it leaves the grid)
+		*/
+		unsigned SwapRunLength (const CPosition & Pos, char Direction) const
+		{
+			const int Step (Direction == KeyRight ? 1 : Direction == KeyLeft ? -1 : Direction == KeyDown ? int (Stride) : -int (Stride));
+			return SwapLength (CellOf (Pos.first, Pos.second), Step);
+		}
+
+		/** @brief Lists every scoring move (towards the right or the bottom), in the same order as ListScoringMoves */
+		void ListScoringMoves (CVMove & Moves) const
+		{
+			Moves.clear ();
+			for (unsigned i (0); i < Height; ++i)
+				for (unsigned j (0), Cell (CellOf (i, 0)); j < Width; ++j, ++Cell)
+				{
+					if (SwapLength (Cell, 1))
+						Moves.push_back (CMove {make_pair (i, j), KeyRight});
+					if (SwapLength (Cell, Stride))
+						Moves.push_back (CMove {make_pair (i, j), KeyDown});
+				}
+		}
+
+		/** @brief True if at least one swap creates a run : any swap scores while a run is left on the grid */
+		bool HasScoringMove () const
+		{
+			if (FirstBit (RowsWithRun, Height) < Height || FirstBit (ColumnsWithRun, Width) < Width) return true;
+			for (unsigned i (0); i < Height; ++i)
+				for (unsigned Cell (CellOf (i, 0)), End (Cell + Width); Cell < End; ++Cell)
+					if (SwapLength (Cell, 1) || SwapLength (Cell, Stride))
+						return true;
+			return false;
+		}
+
+		/**
+		*@brief Hint : the move that creates the longest run
+		*@return false if no move scores
+		*/
+		bool Hint (CMove & Move) const
+		{
+			unsigned Best (0);
+			for (unsigned i (0); i < Height; ++i)
+				for (unsigned j (0), Cell (CellOf (i, 0)); j < Width; ++j, ++Cell)
+				{
+					const unsigned Horizontal (SwapLength (Cell, 1)), Vertical (SwapLength (Cell, Stride));
+					if (Horizontal > Best)
+					{
+						Best = Horizontal;
+						Move = CMove {make_pair (i, j), KeyRight};
+					}
+					if (Vertical > Best)
+					{
+						Best = Vertical;
+						Move = CMove {make_pair (i, j), KeyDown};
+					}
+				}
+			return Best != 0;
+		}
+
+		/** @brief Swaps two cells (the move must be valid) and updates their lines and columns */
+		void Swap (CMat & Grid, const CPosition & Pos, char Direction, CEventStream * Events = NULL)
+		{
+			const CPosition Other (NeighbourOf (Pos, Direction));
+			MakeAMove (Grid, Pos, Direction);
+			Emit (Events, KSwapped, Direction, Pos.first, Pos.second);
+			UpdateRows (Grid, min (Pos.first, Other.first), max (Pos.first, Other.first));
+			UpdateColumns (min (Pos.second, Other.second), max (Pos.second, Other.second));
+		}
+
+		/**
+		*@brief ClearMatchGroups, then updates the lines and columns that moved
+		*@param Cells the cells of the groups of the move
+		*/
+		void ClearGroups (CMat & Grid, vector <unsigned> & Cells, CEventStream * Events = NULL)
+		{
+			if (Cells.empty ()) return;
+			ClearMatchGroups (Grid, Cells, Events);
+
+			/* Les cases sont triées par colonne : les chutes vont de la ligne 0 à la plus basse supprimée */
+			unsigned LastRow (0);
+			for (unsigned Cell : Cells) LastRow = max (LastRow, Cell / Width);
+			UpdateRows (Grid, 0, LastRow);
+			UpdateColumns (Cells.front () % Width, Cells.back () % Width);
+		}
+
+		/**
+		*@brief Same as ArrangeGrid : the runs are found with the index, which is updated after each removal
+		*@param Grid the grid described by the index
+		*@param Score the score to increase
+		*@param Events receives the removals and the falls, if not NULL
+		*@param PointsEarned, ComboMeter points and removals already made by the move (its groups, removed as number 1)
+		*/
+		void Arrange (CMat & Grid, unsigned & Score, CEventStream * Events = NULL, unsigned PointsEarned = 0, unsigned ComboMeter = 0)
+		{
+			CDynBoard Board {Grid};
+			unsigned NbSteps (ComboMeter != 0);	// Suppressions publiées : les groupes du coup n'en font qu'une
+
+			for (unsigned i; (i = FirstBit (RowsWithRun, Height)) < Height;)
+			{
+				/* La troisième case d'une suite est la première qui a deux cases identiques à sa gauche */
+				unsigned Cell (CellOf (i, 0));
+				while (Left [Cell] < 2) ++Cell;
+				const unsigned HowMany (3 + Right [Cell]);
+				const unsigned j (Cell - CellOf (i, 0) - 2);
+
+				EmitRemoval (Events, Grid, make_pair (i, j), HowMany, false, ++NbSteps);
+				ClearRunInRow (Board, make_pair (i, j), HowMany);
+				UpdateRows (Grid, 0, i);
+				UpdateColumns (j, j + HowMany - 1);
+				++ComboMeter;
+				PointsEarned += HowMany * (HowMany + 1) / 2;
+			}
+
+			for (unsigned j; (j = FirstBit (ColumnsWithRun, Width)) < Width;)
+			{
+				unsigned Cell (CellOf (0, j));
+				while (Up [Cell] < 2) Cell += Stride;
+				const unsigned HowMany (3 + Down [Cell]);
+				const unsigned i ((Cell - CellOf (0, j)) / Stride - 2);
+
+				EmitRemoval (Events, Grid, make_pair (i, j), HowMany, true, ++NbSteps);
+				ClearRunInColumn (Board, make_pair (i, j), HowMany);
+				UpdateRows (Grid, 0, i + HowMany - 1);
+				UpdateColumn (j);
+				++ComboMeter;
+				PointsEarned += HowMany * (HowMany + 1) / 2;
+			}
+
+			Score += PointsEarned * ComboMeter;
+		}
+	};
+
+	/**
+    *@brief Same as PlayMove, the runs being found and removed with the index of the grid
+    *@param Index the index, which describes Grid and stays up to date
+    *@param Events receives the events of the move, if not NULL
+    */
+	void PlayMove (CRunIndex & Index, CMat & Grid, const CPosition & Pos, char Direction, unsigned & Score, CVMatchGroup & Groups,
+				   CEventStream * Events = NULL)
+	{
+		static thread_local vector <unsigned> Cells;
+		const unsigned Before (Score);
+		Index.Swap (Grid, Pos, Direction, Events);
+
+		const CPosition Changed [2] = {Pos, NeighbourOf (Pos, Direction)};
+		FindMatchGroups (Grid, Changed, 2, Groups, Cells);
+		unsigned PointsEarned (0), ComboMeter (0);
+		ScoreMatchGroups (Groups, Score, PointsEarned, ComboMeter);
+		Index.ClearGroups (Grid, Cells, Events);
+
+		Index.Arrange (Grid, Score, Events, PointsEarned, ComboMeter);
+		Emit (Events, KScoreChanged, '\0', 0, 0, 0, 0, 0, Score - Before);
+
+	} // PlayMove ()
+
+	/*	VARIANTES DE RÈGLES
+
+		Chaque variante est une instanciation de CRules : les fonctions ci-dessous en font un jeu complet (validité d'un coup,
+		coup joué, coups qui marquent), avec leurs propres noyaux, et CRuleSet les range dans une table où la partie choisit
+		sa variante une fois pour toutes. Les règles classiques gardent leurs fonctions d'origine, avec l'index des suites,
+		les formes spéciales et le détail des événements ; les variantes n'ont pas de bonus de forme et ne publient que
+		l'échange et les points de chaque coup. */
+
+	/** @brief IsValidDirection under the rules TRules */
+	template <typename TRules>
+	bool IsValidRulesDirection (char Direction)
+	{
+		int Di, Dj;
+		return StepOf (Direction, Di, Dj) && TRules::Swaps::IsAllowed (Di, Dj);
+
+	} // IsValidRulesDirection ()
+
+	/** @brief IsValidMove under the rules TRules */
+	template <typename TRules>
+	bool IsValidRulesMove (const CMat & Grid, const CPosition & Pos, char Direction)
+	{
+		int Di, Dj;
+		return StepOf (Direction, Di, Dj) && TRules::Swaps::IsAllowed (Di, Dj)
+			&& IsValidPosition (Grid, make_pair (Pos.first + Di, Pos.second + Dj));
+
+	} // IsValidRulesMove ()
+
+	/**
+    *@brief Plays a move (which must be valid) under the rules TRules : swap, then removal of the runs
+    */
+	template <typename TRules>
+	void PlayRulesMove (CMat & Grid, const CPosition & Pos, char Direction, unsigned & Score)
+	{
+		int Di, Dj;
+		StepOf (Direction, Di, Dj);
+		swap (Grid [Pos.first][Pos.second], Grid [Pos.first + Di][Pos.second + Dj]);
+		ArrangeRulesGrid <TRules> (Grid, Score);
+
+	} // PlayRulesMove ()
+
+	/** @brief Length of the longest run through the cell (i, j), in its line or in its column */
+	inline unsigned RunThrough (const CMat & Grid, unsigned i, unsigned j)
+	{
+		const unsigned Value (Grid [i][j]);
+		if (Value == KImpossible) return 0;
+
+		unsigned InRow (1), InColumn (1);
+		for (unsigned k (j); k-- > 0 && Grid [i][k] == Value;) ++InRow;
+		for (unsigned k (j + 1); k < Grid [i].size () && Grid [i][k] == Value; ++k) ++InRow;
+		for (unsigned k (i); k-- > 0 && Grid [k][j] == Value;) ++InColumn;
+		for (unsigned k (i + 1); k < Grid.size () && Grid [k][j] == Value; ++k) ++InColumn;
+		return max (InRow, InColumn);
+
+	} // RunThrough ()
+
+	/**
+    *@brief ListScoringMoves under the rules TRules : each swap is made on a copy, then undone
+    */
+	template <typename TRules>
+	void ListRulesScoringMoves (const CMat & Grid, CVMove & Moves)
+	{
+		static thread_local CMat Work;
+		Work = Grid;
+		Moves.clear ();
+
+		for (unsigned i (0); i < Work.size (); ++i)
+			for (unsigned j (0); j < Work [i].size (); ++j)
+				for (unsigned k (0); k < TRules::Swaps::KNbForward; ++k)
+				{
+					const char Direction (TRules::Swaps::Forward (k));
+					int Di, Dj;
+					StepOf (Direction, Di, Dj);
+					const unsigned Ni (i + Di), Nj (j + Dj);	// Hors de la grille aussi quand i + Di < 0 (unsigned)
+					if (Ni >= Work.size () || Nj >= Work [i].size () || Work [i][j] == KImpossible || Work [Ni][Nj] == KImpossible
+						|| Work [i][j] == Work [Ni][Nj])
+						continue;
+
+					swap (Work [i][j], Work [Ni][Nj]);
+					if (max (RunThrough (Work, i, j), RunThrough (Work, Ni, Nj)) >= TRules::KMinRun)
+						Moves.push_back (CMove {make_pair (i, j), Direction});
+					swap (Work [i][j], Work [Ni][Nj]);
+				}
+
+	} // ListRulesScoringMoves ()
+
+	/** @brief A variant of the rules, as chosen from the level menu or with --rules */
+	struct CRuleSet
+	{
+		const char * Id;			// Nom sur la ligne de commande
+		const char * Name;
+		bool Classic;				// Règles d'origine : le jeu passe par l'index des suites et les formes spéciales
+		const char * Keys;			// Touches en plus des quatre directions, NULL s'il n'y en a pas
+		bool (* IsValidDirection) (char);
+		bool (* IsValidMove) (const CMat &, const CPosition &, char);
+		void (* Play) (CMat &, const CPosition &, char, unsigned &);
+		void (* ListScoringMoves) (const CMat &, CVMove &);
+	};
+
+	template <typename TRules>
+	CRuleSet MakeRuleSet (const char * Id, const char * Name, const char * Keys = NULL)
+	{
+		return CRuleSet {Id, Name, false, Keys, IsValidRulesDirection <TRules>, IsValidRulesMove <TRules>, PlayRulesMove <TRules>,
+						 ListRulesScoringMoves <TRules>};
+
+	} // MakeRuleSet ()
+
+	const array <CRuleSet, 6> KRuleSets {{
+		{"classique", "Classiques", true, NULL, IsValidDirection, IsValidMove, PlayMove, ListScoringMoves},
+		MakeRuleSet <CRules <4, COrthogonalSwaps, CGravityDown, CTriangleScoring>> ("quatre", "Suites de quatre"),
+		MakeRuleSet <CRules <3, CDiagonalSwaps, CGravityDown, CTriangleScoring>> ("diagonales", "Échanges en diagonale",
+																					"7, 9, 1, 3 : diagonales, comme sur un pavé numérique"),
+		MakeRuleSet <CRules <3, COrthogonalSwaps, CGravityUp, CTriangleScoring>> ("envers", "Gravité vers le haut"),
+		MakeRuleSet <CRules <3, COrthogonalSwaps, CNoGravity, CTriangleScoring>> ("sans-gravite", "Sans gravité"),
+		MakeRuleSet <CRules <3, COrthogonalSwaps, CGravityDown, CFlatScoring>> ("points-fixes", "10 points par case")
+	}};
+
+	/** @brief Index in KRuleSets of the rules of the next games */
+	unsigned CurrentRules (0);
+
+	/**
+    *@brief Checks that a move still scores under the rules
+    *@param Index the index of Grid, used by the classic rules
+    */
+	bool HasScoringMove (const CRuleSet & Rules, const CRunIndex & Index, const CMat & Grid)
+	{
+		if (Rules.Classic) return Index.HasScoringMove ();
+
+		static thread_local CVMove Moves;
+		Rules.ListScoringMoves (Grid, Moves);
+		return ! Moves.empty ();
+
+	} // HasScoringMove ()
+
+	/**
+    *@brief ReshuffleGrid under the rules : for a variant, reshuffles again until a move scores under its rules
+    *@return false if the grid could not be reshuffled
+    */
+	bool ReshuffleGrid (const CRuleSet & Rules, CMat & Grid, CRandom & Rand)
+	{
+		CVMove Moves;
+		for (unsigned Try (0); Try < 20; ++Try)
+		{
+			if (! ReshuffleGrid (Grid, Rand)) return false;
+			if (Rules.Classic) return true;
+
+			Rules.ListScoringMoves (Grid, Moves);
+			if (! Moves.empty ()) return true;
+		}
+		return false;
+
+	} // ReshuffleGrid ()
+
+	/**
+    *@brief Hint under the rules : the longest run for the classic rules, the move worth the most points for a variant
+    *@return false if no move scores
+    */
+	bool Hint (const CRuleSet & Rules, const CRunIndex & Index, const CMat & Grid, CMove & Move)
+	{
+		if (Rules.Classic) return Index.Hint (Move);
+
+		CVMove Moves;
+		Rules.ListScoringMoves (Grid, Moves);
+		unsigned Best (0);
+		for (const CMove & Candidate : Moves)
+		{
+			CMat Copy (Grid);
+			unsigned Points (0);
+			Rules.Play (Copy, Candidate.Pos, Candidate.Direction, Points);
+			if (Points > Best)
+			{
+				Best = Points;
+				Move = Candidate;
+			}
+		}
+		return Best != 0;
+
+	} // Hint ()
+
+	/**
+    *@brief Plays a move (which must be valid) under the rules
+    *@param Index the index of Grid, kept up to date
+    *@param Groups the shapes formed, always empty for a variant
+    *@param Events receives the events of the move, if not NULL
+    */
+	void PlayMove (const CRuleSet & Rules, CRunIndex & Index, CMat & Grid, const CPosition & Pos, char Direction, unsigned & Score,
+				   CVMatchGroup & Groups, CEventStream * Events = NULL)
+	{
+		if (Rules.Classic)
+		{
+			PlayMove (Index, Grid, Pos, Direction, Score, Groups, Events);
+			return;
+		}
+
+		const unsigned Before (Score);
+		Groups.clear ();
+		Emit (Events, KSwapped, Direction, Pos.first, Pos.second);
+		Rules.Play (Grid, Pos, Direction, Score);
+		Index.Rebuild (Grid);
+		Emit (Events, KScoreChanged, '\0', 0, 0, 0, 0, 0, Score - Before);
+
+	} // PlayMove ()
+
+	/**
+    *@brief Finds a variant by its command line name
+    *@return its index in KRuleSets, KRuleSets.size () if there is none
+    */
+	unsigned FindRuleSet (const string & Id)
+	{
+		unsigned r (0);
+		while (r < KRuleSets.size () && Id != KRuleSets [r].Id) ++r;
+		return r;
+
+	} // FindRuleSet ()
+
+	/*	MOTEUR PAR LOTS
+
+		Pour évaluer beaucoup de coups ou de parties à la fois, KLanes grilles de même taille sont rangées case par case :
+		la case (i, j) des KLanes grilles tient dans un seul vecteur de KLanes octets. Chaque étape d'ArrangeBoard (trouver
+		la première suite, la supprimer, compter les points) est faite dans toutes les grilles en même temps, avec des masques
+		pour les grilles qui n'ont plus rien à supprimer : le résultat est exactement celui d'ArrangeGrid, grille par grille.
+		Le noyau est compilé deux fois, pour le processeur de base (SSE2 en x86-64) et pour AVX2, et choisi à l'exécution ;
+		sans les vecteurs de GCC, chaque grille passe par ArrangeBoard. */
+
+	/** @brief How many grids in a batch */
+	const unsigned KLanes = 32;
+
+#ifdef __GNUC__
+	/** @brief One byte per grid of the batch (the numbers are small enough for signed bytes, which SSE2 compares directly) */
+	typedef int8_t CLaneBytes __attribute__ ((vector_size (KLanes)));
+
+	/** @brief Register of the base instruction set : SSE2 in x86, NEON in ARM */
+	typedef int8_t CLaneBytes16 __attribute__ ((vector_size (16)));
+#else
+	typedef array <uint8_t, KLanes> CLaneBytes;
+#endif
+
+	/** @brief KLanes grids of KHeight x KWidth, cell after cell */
+	template <unsigned KHeight, unsigned KWidth>
+	struct CBatch
+	{
+		static_assert (KHeight < 16 && KWidth < 16, "les longueurs des suites doivent tenir sur un octet");
+
+		CLaneBytes Cells [KHeight * KWidth];
+
+		/** @brief Copies a grid in a lane of the batch */
+		void Load (unsigned Lane, const CMat & Grid)
+		{
+			for (unsigned i (0); i < KHeight; ++i)
+				for (unsigned j (0); j < KWidth; ++j)
+					Cells [i * KWidth + j][Lane] = Grid [i][j];
+		}
+
+		/** @brief Copies a grid in every lane of the batch */
+		void LoadAll (const CMat & Grid)
+		{
+			for (unsigned i (0); i < KHeight; ++i)
+				for (unsigned j (0); j < KWidth; ++j)
+					for (unsigned Lane (0); Lane < KLanes; ++Lane)
+						Cells [i * KWidth + j][Lane] = Grid [i][j];
+		}
+
+		/** @brief Copies a lane of the batch in a grid of the same dimensions */
+		void Store (unsigned Lane, CMat & Grid) const
+		{
+			for (unsigned i (0); i < KHeight; ++i)
+				for (unsigned j (0); j < KWidth; ++j)
+					Grid [i][j] = Cells [i * KWidth + j][Lane];
+		}
+
+		/** @brief Swaps two cells in a lane (the move must be valid) */
+		void Swap (unsigned Lane, const CPosition & Pos, char Direction)
+		{
+			const CPosition Other (NeighbourOf (Pos, Direction));
+			swap (Cells [Pos.first * KWidth + Pos.second][Lane], Cells [Other.first * KWidth + Other.second][Lane]);
+		}
+	};
+
+	/** @brief Implementations of the batch kernel */
+	enum CBatchKernel { KScalarKernel, KVectorKernel, KAvx2Kernel };
+
+	/** @brief Names of the kernels, in the order of CBatchKernel */
+	const char * const KBatchKernelNames [] = {"scalaire", "vectoriel", "AVX2"};
+
+	/**
+    *@brief Scalar version of ArrangeBatch : every lane goes through ArrangeBoard
+    */
+	template <unsigned KHeight, unsigned KWidth>
+	void ArrangeBatchScalar (CBatch <KHeight, KWidth> & Batch, unsigned * Scores)
+	{
+		CFixedBoard <KHeight, KWidth> Board;
+		for (unsigned Lane (0); Lane < KLanes; ++Lane)
+		{
+			for (unsigned Cell (0); Cell < KHeight * KWidth; ++Cell) Board.Cells [Cell] = Batch.Cells [Cell][Lane];
+			ArrangeBoard (Board, Scores [Lane]);
+			for (unsigned Cell (0); Cell < KHeight * KWidth; ++Cell) Batch.Cells [Cell][Lane] = Board.Cells [Cell];
+		}
+
+	} // ArrangeBatchScalar ()
+
+#ifdef __GNUC__
+
+	/** @brief Each byte of the result is taken from A where Mask is 0xFF, from B where it is 0 */
+	#define KITTY_SELECT(Mask, A, B) (((Mask) & (A)) | (~(Mask) & (B)))
+
+	/** @brief True if no byte of the mask is set */
+	template <typename TVec>
+	inline __attribute__ ((always_inline)) bool IsEmptyMask (const TVec & Mask)
+	{
+		uint64_t Words [sizeof (TVec) / 8];
+		memcpy (Words, &Mask, sizeof (Words));
+		uint64_t Any (0);
+		for (uint64_t Word : Words) Any |= Word;
+		return Any == 0;
+
+	} // IsEmptyMask ()
+
+	/**
+    *@brief Body of the vector kernels : ArrangeBoard on every lane of a register at once
+    *@param Cells the cells of the batch : cell k of the register is at Cells [k * KStride], KStride registers per cell
+    *@param Points the points of the runs of each lane of the register
+    *@param Combos the number of runs of each lane
+    */
+	template <typename TVec, unsigned KStride, unsigned KHeight, unsigned KWidth>
+	inline __attribute__ ((always_inline)) void ArrangeBatchBody (TVec * Cells, unsigned * Points, TVec & Combos)
+	{
+		typedef TVec V;
+		const V Zero = {}, One = Zero + 1;
+		auto Cell = [=] (unsigned i, unsigned j) -> V & { return Cells [(i * KWidth + j) * KStride]; };
+
+		/* Points d'une suite de longueur L : L (L + 1) / 2, sans multiplication d'octets qui n'existe pas en SSE / AVX */
+		auto AddPoints = [&] (const V & L)
+		{
+			V Triangle (Zero);
+			for (unsigned Len (3); Len <= max (KHeight, KWidth); ++Len)
+				Triangle = KITTY_SELECT ((V) (L == int8_t (Len)), Zero + int8_t (Len * (Len + 1) / 2), Triangle);
+			for (unsigned Lane (0); Lane < sizeof (V); ++Lane)
+				Points [Lane] += uint8_t (Triangle [Lane]);
+		};
+
+		/* Suites horizontales : la première dans l'ordre des lignes, comme FindRunInRow */
+		for (;;)
+		{
+			V Found (Zero), I (Zero), J (Zero), L (Zero);
+			for (int i (KHeight - 1); i >= 0; --i)
+			{
+				V Length (One);	// Longueur de la suite de cases identiques qui commence en (i, j)
+				for (int j (KWidth - 2); j >= 0; --j)
+				{
+					const V Same ((V) (Cell (i, j) == Cell (i, j + 1)) & (V) (Cell (i, j) != 0));
+					Length = KITTY_SELECT (Same, Length + 1, One);
+					const V Start ((V) (Length >= 3));
+					I = KITTY_SELECT (Start, Zero + int8_t (i), I);
+					J = KITTY_SELECT (Start, Zero + int8_t (j), J);
+					L = KITTY_SELECT (Start, Length, L);
+					Found |= Start;
+				}
+			}
+			if (IsEmptyMask (Found)) break;
+
+			/* Comme ClearRunInRow : les cases au-dessus de la suite descendent d'une ligne */
+			const V End (J + L);
+			for (int i (KHeight - 1); i >= 0; --i)
+			{
+				const V Row (Found & (V) (I >= int8_t (i)));
+				for (unsigned j (0); j < KWidth; ++j)
+				{
+					const V Mask (Row & (V) (J <= int8_t (j)) & (V) (End > int8_t (j)));
+					Cell (i, j) = KITTY_SELECT (Mask, i > 0 ? Cell (i - 1, j) : Zero, Cell (i, j));
+				}
+			}
+			AddPoints (L & Found);
+			Combos += One & Found;
+		}
+
+		/* Suites verticales : la première dans l'ordre des colonnes, comme FindRunInColumn */
+		for (;;)
+		{
+			V Found (Zero), I (Zero), J (Zero), L (Zero);
+			for (int j (KWidth - 1); j >= 0; --j)
+			{
+				V Length (One);
+				for (int i (KHeight - 2); i >= 0; --i)
+				{
+					const V Same ((V) (Cell (i, j) == Cell (i + 1, j)) & (V) (Cell (i, j) != 0));
+					Length = KITTY_SELECT (Same, Length + 1, One);
+					const V Start ((V) (Length >= 3));
+					I = KITTY_SELECT (Start, Zero + int8_t (i), I);
+					J = KITTY_SELECT (Start, Zero + int8_t (j), J);
+					L = KITTY_SELECT (Start, Length, L);
+					Found |= Start;
+				}
+			}
+			if (IsEmptyMask (Found)) break;
+
+			/* Même résultat que ClearRunInColumn, parcours compris : au-dessus de la suite tout est vidé, et la case i de la
+			   suite reçoit l'ancienne case i % L si i >= L, sinon elle reste vide */
+			const V End (I + L);
+			for (unsigned j (0); j < KWidth; ++j)
+			{
+				const V Column (Found & (V) (J == int8_t (j)));
+				if (IsEmptyMask (Column)) continue;
+
+				V Old [KHeight];
+				for (unsigned i (0); i < KHeight; ++i) Old [i] = Cell (i, j);
+
+				for (unsigned i (0); i < KHeight; ++i)
+				{
+					V Moved (Zero);
+					for (unsigned Len (3); Len <= i; ++Len)
+						Moved = KITTY_SELECT ((V) (L == int8_t (Len)), Old [i % Len], Moved);
+
+					const V InRun ((V) (I <= int8_t (i)) & (V) (End > int8_t (i)));
+					const V New (KITTY_SELECT ((V) (I > int8_t (i)), Zero, KITTY_SELECT (InRun, Moved, Old [i])));
+					Cell (i, j) = KITTY_SELECT (Column, New, Old [i]);
+				}
+			}
+			AddPoints (L & Found);
+			Combos += One & Found;
+		}
+
+	} // ArrangeBatchBody ()
+
+	/**
+    *@brief Vector kernel for the base instruction set : the batch in registers of 16 lanes
+    */
+	template <unsigned KHeight, unsigned KWidth>
+	__attribute__ ((flatten)) void ArrangeBatchVector (CBatch <KHeight, KWidth> & Batch, unsigned * Points, int8_t * Combos)
+	{
+		const unsigned KParts (KLanes / 16);
+		CLaneBytes16 * Cells (reinterpret_cast <CLaneBytes16 *> (Batch.Cells));
+		for (unsigned Part (0); Part < KParts; ++Part)
+		{
+			CLaneBytes16 PartCombos = {};
+			ArrangeBatchBody <CLaneBytes16, KParts, KHeight, KWidth> (Cells + Part, Points + 16 * Part, PartCombos);
+			memcpy (Combos + 16 * Part, &PartCombos, 16);
+		}
+
+	} // ArrangeBatchVector ()
+
+	#if defined (__x86_64__) || defined (__i386__)
+		#define KITTY_AVX2
+
+	/**
+    *@brief Vector kernel for AVX2 : the whole batch in each register
+    */
+	template <unsigned KHeight, unsigned KWidth>
+	__attribute__ ((target ("avx2"), flatten)) void ArrangeBatchAvx2 (CBatch <KHeight, KWidth> & Batch, unsigned * Points, int8_t * Combos)
+	{
+		CLaneBytes AllCombos = {};
+		ArrangeBatchBody <CLaneBytes, 1, KHeight, KWidth> (Batch.Cells, Points, AllCombos);
+		memcpy (Combos, &AllCombos, KLanes);
+
+	} // ArrangeBatchAvx2 ()
+	#endif
+
+#endif // __GNUC__
+
+	/** @brief Best kernel for this processor */
+	CBatchKernel BestBatchKernel ()
+	{
+		#if defined (KITTY_AVX2)
+			static const CBatchKernel Best (__builtin_cpu_supports ("avx2") ? KAvx2Kernel : KVectorKernel);
+			return Best;
+		#elif defined (__GNUC__)
+			return KVectorKernel;
+		#else
+			return KScalarKernel;
+		#endif
+
+	} // BestBatchKernel ()
+
+	/**
+    *@brief Same as ArrangeGrid on every lane of the batch
+    *@param Batch the batch
+    *@param Scores the scores of the lanes, to increase
+    *@param Kernel the implementation, which must be available on this processor
+    */
+	template <unsigned KHeight, unsigned KWidth>
+	void ArrangeBatch (CBatch <KHeight, KWidth> & Batch, unsigned * Scores, CBatchKernel Kernel = BestBatchKernel ())
+	{
+		#ifdef __GNUC__
+			if (Kernel != KScalarKernel)
+			{
+				unsigned Points [KLanes] = {};
+				int8_t Combos [KLanes];
+				#ifdef KITTY_AVX2
+					if (Kernel == KAvx2Kernel)
+						ArrangeBatchAvx2 (Batch, Points, Combos);
+					else
+				#endif
+						ArrangeBatchVector (Batch, Points, Combos);
+
+				for (unsigned Lane (0); Lane < KLanes; ++Lane)
+					Scores [Lane] += Points [Lane] * unsigned (Combos [Lane]);
+				return;
+			}
+		#endif
+		ArrangeBatchScalar (Batch, Scores);
+
+	} // ArrangeBatch ()
+
+	/**
+    *@brief Fixed-size version of EvaluateMoves
+    */
+	template <unsigned KHeight, unsigned KWidth>
+	void EvaluateBatchMoves (const CMat & Grid, const CVMove & Moves, vector <unsigned> & Points, CBatchKernel Kernel)
+	{
+		CBatch <KHeight, KWidth> Base, Batch;
+		Base.LoadAll (Grid);
+
+		for (unsigned First (0); First < Moves.size (); First += KLanes)
+		{
+			Batch = Base;
+			const unsigned Count (min <unsigned> (KLanes, Moves.size () - First));
+			for (unsigned Lane (0); Lane < Count; ++Lane)
+				Batch.Swap (Lane, Moves [First + Lane].Pos, Moves [First + Lane].Direction);
+
+			unsigned Scores [KLanes] = {};
+			ArrangeBatch (Batch, Scores, Kernel);
+			copy (Scores, Scores + Count, Points.begin () + First);
+		}
+
+	} // EvaluateBatchMoves ()
+
+	/**
+    *@brief Leaf evaluation : the points of each move, played on its own copy of the grid with the original removal of the
+    * runs (without the shapes, which are removed first by PlayMove), KLanes moves at a time for the sizes of the levels
+    *@param Grid the grid
+    *@param Moves the moves, which must be valid
+    *@param Points filled with the points of each move
+    *@param Kernel the implementation of the batches
+    */
+	void EvaluateMoves (const CMat & Grid, const CVMove & Moves, vector <unsigned> & Points, CBatchKernel Kernel = BestBatchKernel ())
+	{
+		Points.assign (Moves.size (), 0);
+
+		if (Grid.size () == 6 && Grid [0].size () == 6)
+			EvaluateBatchMoves <6, 6> (Grid, Moves, Points, Kernel);
+		else if (Grid.size () == 8 && Grid [0].size () == 8)
+			EvaluateBatchMoves <8, 8> (Grid, Moves, Points, Kernel);
+		else
+		{
+			CMat Copy;
+			for (unsigned m (0); m < Moves.size (); ++m)
+			{
+				Copy = Grid;
+				MakeAMove (Copy, Moves [m].Pos, Moves [m].Direction);
+				ArrangeGrid (Copy, Points [m]);
+			}
+		}
+
+	} // EvaluateMoves ()
+
+	/*	HISTORIQUE DES COUPS
+
+		Chaque état de la partie est une version immuable de la grille : une ligne qu'un coup n'a pas modifiée est partagée
+		avec la version précédente au lieu d'être copiée. Annuler ou refaire un coup ne recopie que les lignes qui diffèrent
+		entre deux versions, ce qui sert aussi aux solveurs à jouer puis défaire un coup sans copier toute la grille. */
+
+	/** @brief A line of a snapshot, shared by every version of the grid in which it did not change */
+	typedef shared_ptr <const CVLine> CSharedLine;
+
+	/** @brief State of the game after a move */
+	struct CSnapshot
+	{
+		vector <CSharedLine> Lines;
+		unsigned Score;
+		unsigned NbMoves;
+	};
+
+	/** @brief Undo / redo history of a game, limited in depth and in memory */
+	class CHistory
+	{
+		deque <CSnapshot> Done;		// Done.back () est l'état courant
+		vector <CSnapshot> Undone;	// États annulés, le dernier est le prochain à refaire
+		unsigned MaxDepth;
+		size_t MaxBytes;
+		size_t Bytes;				// Mémoire des lignes de toutes les versions
+
+		static size_t LineBytes (const CVLine & Line) { return sizeof (CVLine) + Line.size () * sizeof (unsigned); }
+
+		/** @brief Releases the lines of the snapshot, counting those that nobody else shares */
+		void Forget (CSnapshot & Snapshot)
+		{
+			for (CSharedLine & Line : Snapshot.Lines)
+			{
+				if (Line.use_count () == 1) Bytes -= LineBytes (*Line);
+				Line.reset ();
+			}
+		}
+
+		/** @brief Drops the oldest versions until the limits are respected (the current state is always kept) */
+		void Trim ()
+		{
+			while (Done.size () > 1 && (Done.size () > MaxDepth + 1 || Bytes > MaxBytes))
+			{
+				Forget (Done.front ());
+				Done.pop_front ();
+			}
+		}
+
+		/** @brief Turns Grid, which holds the version From, into the version To by copying the lines that differ */
+		static void Restore (CMat & Grid, const CSnapshot & From, const CSnapshot & To)
+		{
+			if (Grid.size () != To.Lines.size ()) SizeGrid (Grid, To.Lines.size ());
+			for (unsigned i (0); i < To.Lines.size (); ++i)
+				if (i >= From.Lines.size () || From.Lines [i] != To.Lines [i])
+					Grid [i] = *To.Lines [i];
+		}
+
+	  public:
+		/**
+		*@brief Creates an empty history
+		*@param Depth how many moves can be undone
+		*@param Memory maximum memory used by the versions of the grid, in bytes
+		*/
+		CHistory (unsigned Depth, size_t Memory) : MaxDepth (Depth), MaxBytes (Memory), Bytes (0) {}
+
+		/** @brief Changes the limits of the history */
+		void SetLimits (unsigned Depth, size_t Memory)
+		{
+			MaxDepth = Depth;
+			MaxBytes = Memory;
+			Trim ();
+		}
+
+		/** @brief Forgets everything and starts from the given state */
+		void Reset (const CMat & Grid, unsigned Score, unsigned NbMoves)
+		{
+			for (CSnapshot & Snapshot : Done) Forget (Snapshot);
+			for (CSnapshot & Snapshot : Undone) Forget (Snapshot);
+			Done.clear ();
+			Undone.clear ();
+
+			Done.push_back (CSnapshot {vector <CSharedLine> (), Score, NbMoves});
+			for (const CVLine & Line : Grid)
+			{
+				Done.back ().Lines.push_back (make_shared <const CVLine> (Line));
+				Bytes += LineBytes (Line);
+			}
+		}
+
+		/** @brief Records the state reached by a move (the moves undone before it cannot be redone anymore) */
+		void Push (const CMat & Grid, unsigned Score, unsigned NbMoves)
+		{
+			for (CSnapshot & Snapshot : Undone) Forget (Snapshot);
+			Undone.clear ();
+
+			const CSnapshot & Previous (Done.back ());
+			CSnapshot Next {vector <CSharedLine> (), Score, NbMoves};
+			Next.Lines.reserve (Grid.size ());
+			for (unsigned i (0); i < Grid.size (); ++i)
+			{
+				if (i < Previous.Lines.size () && *Previous.Lines [i] == Grid [i])
+					Next.Lines.push_back (Previous.Lines [i]); // Ligne inchangée : partagée
+				else
+				{
+					Next.Lines.push_back (make_shared <const CVLine> (Grid [i]));
+					Bytes += LineBytes (Grid [i]);
+				}
+			}
+			Done.push_back (move (Next));
+			Trim ();
+		}
+
+		/** @brief Make : plays the move (which must be valid) and records the new state */
+		void Play (CMat & Grid, const CMove & Move, unsigned & Score, unsigned & NbMoves)
+		{
+			PlayMove (Grid, Move.Pos, Move.Direction, Score);
+			++NbMoves;
+			Push (Grid, Score, NbMoves);
+		}
+
+		/** @brief Replaces the current state, when the grid changed without a move (the grid reshuffled, for instance) */
+		void Amend (const CMat & Grid, unsigned Score, unsigned NbMoves)
+		{
+			if (Done.size () < 2)
+			{
+				Reset (Grid, Score, NbMoves);
+				return;
+			}
+			Forget (Done.back ());
+			Done.pop_back ();
+			Push (Grid, Score, NbMoves);
+		}
+
+		/** @brief Unmake : goes back to the previous state, Grid must hold the current state */
+		bool Undo (CMat & Grid, unsigned & Score, unsigned & NbMoves)
+		{
+			if (Done.size () < 2) return false;
+
+			Undone.push_back (move (Done.back ()));
+			Done.pop_back ();
+			Restore (Grid, Undone.back (), Done.back ());
+			Score = Done.back ().Score;
+			NbMoves = Done.back ().NbMoves;
+			return true;
+		}
+
+		/** @brief Replays the last move undone, Grid must hold the current state */
+		bool Redo (CMat & Grid, unsigned & Score, unsigned & NbMoves)
+		{
+			if (Undone.empty ()) return false;
+
+			Done.push_back (move (Undone.back ()));
+			Undone.pop_back ();
+			Restore (Grid, Done [Done.size () - 2], Done.back ());
+			Score = Done.back ().Score;
+			NbMoves = Done.back ().NbMoves;
+			Trim ();
+			return true;
+		}
+
+		/** @brief How many moves can be undone */
+		unsigned NbUndo () const { return Done.size () - 1; }
+
+		/** @brief How many moves can be redone */
+		unsigned NbRedo () const { return Undone.size (); }
+
+		/** @brief Memory used by the versions of the grid, in bytes */
+		size_t Memory () const { return Bytes; }
+	};
+
+    /**
+    *@brief Test if a string is binary
+    *@param Str the string to test
+    */
+	bool IsBinary(string Str)
+	/* On teste si une string est binaire, si oui renvoie true */
+    {
+        for (unsigned i (0) ; i < Str.size() ; ++ i)
+        {
+           if ( ! (Str [i] == '0' || Str [i] == '1') )
+               return false ;
+        }
+        return true ;
+
+    } // IsBinary ()
+
+    /**
+    *@brief Decimal to binary
+    *@param Nbr the number to convert
+    * Convert a number to a X number binary string
+    */
+	string DecToBin (unsigned Nbr)
+	/* Conversion du décimal vers binaire, on rentre un nombre entier
+       positif, et on le convertis en une string de NbZero caractères */
+    {
+            string Binary ( NbZero, '0') ; // Le nombre de zeros, initialisé à 0
+            unsigned Pos (0), Local (Nbr) ;
+            if (Nbr > RealMax) return "Size_Error" ; // On ne peut pas dépasser le max
+            for (unsigned i (NbMax) ; i >= 1 ; i /= 2 )
+            {
+                if ( Local >= i )
+                {
+                    Binary[Pos] = '1' ;
+                    Local -= i ;
+                }
+                Pos += 1 ;
+            }
+            return Binary ;
+
+    } // DecToBin ()
+
+    /**
+    *@brief Binary to decimal
+    *@param Str the string to convert
+    */
+    unsigned BinToDec (string Str) // Pour le décryptage
+    /* On prend une string binaire et on la transforme en un unsigned */
+    {
+        unsigned NbDec (0), Squared (1) ; // Squared (au carré en anglais) va être multiplié pour faire 1,2,4,8,16
+        if (IsBinary (Str))
+        {
+            for (unsigned i (Str.size() ) ; i-- > 0;)
+            {
+                if (Str[i] == '1')
+                    NbDec += Squared ;
+                if (i != Str.size() )
+                    Squared *=2 ;
+            }
+            return NbDec ;
+        }
+        else
+            return 0 ; // Renvoie 0 si la string qu'on demande n'est pas binaire.
+
+    } // BinToDec ()
+
+	/** @brief used to crpyt data to save */
+	const CVStr KeyTab {"0001101101","0101100010", "1000010101", "0000000110" }; // Le tableau des clés qui serviront a coder les données
+    /**
+    *@brief Do a exclusive or in a binary string
+    *@param Bin the string to code
+    *@param Key the key to do a XOR with
+    */
+    string CodeXor (string Bin, string Key) // Un ou exclusif sur les string
+    {
+        if ( (Bin.size() == Key.size()) && IsBinary(Key) )
+        {
+            string Code (Key.size(), '0') ;
+            for (unsigned i(0) ; i < Code.size() ; ++i)
+            {
+                if ( ( ( Bin[i] == '0' ) && ( Key[i] == '1' ) ) || ( ( Bin[i] == '1' ) && ( Key[i] == '0' ) ) )
+                Code[i] = '1' ;
+            }
+            return Code ;
+        }
+        else
+            return "Error_XOR" ;
+
+    } // CodeXor ()
+
+    /**
+    *@brief Crypt a number
+    *@param Data the number to crypt
+    *@param Key the key to crypt with
+    *@param KeyTab a vector who contains the keys
+    */
+    string Crypt (unsigned Data, unsigned Key, const CVStr & KeyTab )
+    /* Un compilé des fonctions précédentes pour crypter de mannière simple
+       Data la donnée a crypter, Key la clé actuelle qui va changer à chaque tour
+       et KeyTab le tableau de clés déterminé préalablement */
+    {
+        if (Key > KeyTab.size() - 1)
+            return "Error:Bad_Key" ;
+        string Code ;
+        string BinData ( DecToBin(Data) ) ;
+        string KeyBin ;
+        if ( BinData == "Size_Error")
+            return "Size_Error" ;
+        Code = CodeXor(BinData, KeyTab [Key]) ;
+        return Code ;
+
+    } // Crypt ()
+
+    /**
+    *@brief Uncrypt
+    *@param StrData the string to uncrypt
+    *@param Key the key to do the uncrpyt
+    *@param KeyTab a vector who contains the keys
+    */
+    unsigned Decrypt (string StrData, unsigned Key, const CVStr & KeyTab) // Décrypte une string binaire en unsigned, le processus inverse du cryptage.
+    {
+        if (IsBinary(StrData) && Key < KeyTab.size() )
+        {
+            string CodeCrypt (CodeXor (StrData, KeyTab[Key]) ) ;
+            unsigned CodeDecrypt (BinToDec (CodeCrypt) ) ;
+            return CodeDecrypt ;
+        }
+        else return 1024 ; // Valeur qu'on utilisera jamais, forcément supérieure à NbCandies, elle renverra forcément erreur dans le programme de chargement
+
+    } // Decrypt ()
+
+    /**
+    *@brief Appends Data to the buffer like DecToBin, or like Crypt if a key is given, without building any string
+    *@param Buffer the buffer to append to
+    *@param Data the number to write
+    *@param KeyBin the binary key to do a XOR with, NULL to write Data in clear
+    */
+    void AppendBinary (string & Buffer, unsigned Data, const string * KeyBin)
+    {
+        if (Data > RealMax)
+        {
+            Buffer += "Size_Error" ; // Même résultat que DecToBin et Crypt
+            return ;
+        }
+        for (unsigned Pos (0) ; Pos < NbZero ; ++Pos)
+        {
+            bool Bit ((Data >> (NbZero - 1 - Pos)) & 1) ;
+            if (KeyBin != NULL && (*KeyBin) [Pos] == '1')
+                Bit = ! Bit ;
+            Buffer += Bit ? '1' : '0' ;
+        }
+
+    } // AppendBinary ()
+
+    /**
+    *@brief Writes the whole save in the buffer (same content as Save), reusing the memory of the buffer
+    *@param Buffer the buffer, cleared first
+    *@param Grid the game grid
+    *@param Turn parameter of the game
+    *@param Score parameter of the game
+    *@param BestScore parameter of the game
+    *@param Size parameter of the game
+    *@param KeyTab vector who contains every keys
+    *@param MaxTimes parameter of the game
+    */
+    void EncodeSave (string & Buffer, const CMat & Grid, unsigned Turn, unsigned Score, unsigned BestScore, unsigned Size, const CVStr & KeyTab, unsigned MaxTimes)
+    {
+        unsigned Key ((Turn % KeyTab.size() + 1) - 1 ) ;
+        const string & KeyBin (KeyTab [Key]) ;
+
+        Buffer.clear () ;
+        AppendBinary (Buffer, Key, NULL) ; // Key (1) en clair
+        Buffer += Separator ;
+        for (unsigned Data : {Score, BestScore, Size, Turn, MaxTimes}) // Score (2), BestScore (3), Taille (4), Tour (5), Niveau (6)
+        {
+            AppendBinary (Buffer, Data, &KeyBin) ;
+            Buffer += Separator ;
+        }
+        for (const CVLine & Line : Grid)
+            for (unsigned Cell : Line)
+            {
+                AppendBinary (Buffer, Cell, &KeyBin) ;
+                Buffer += Separator ;
+            }
+
+    } // EncodeSave ()
+
+    /**
+    *@brief Save the game in a stream
+    *@param SaveFile the stream to write to
+    *@param Grid the game grid
+    *@param Turn parameter of the game
+    *@param Score parameter of the game
+    *@param BestScore parameter of the game
+    *@param Size parameter of the game
+    *@param KeyTab vector who contains every keys
+    *@param MaxTimes parameter of the game
+    */
+    void Save (ostream & SaveFile, const CMat & Grid, unsigned Turn, unsigned Score, unsigned BestScore, unsigned Size, const CVStr & KeyTab, unsigned MaxTimes )
+    {
+        /* La sauvegarde, elle écrit dans SaveFile toutes les données nécéssaires au jeu, et les crypte.
+           Le tampon est propre au thread et garde sa taille d'une sauvegarde à l'autre */
+        static thread_local string Buffer ;
+        EncodeSave (Buffer, Grid, Turn, Score, BestScore, Size, KeyTab, MaxTimes) ;
+        SaveFile.write (Buffer.data (), Buffer.size ()) ;
+
+    } // Save ()
+
+    namespace Reference
+    {
+
+    /**
+    *@brief The original Save, writing to a stream instead of save.txt : reference of EncodeSave for --check-engines
+    *@param SaveFile the stream to write to
+    */
+    void Save (ostream & SaveFile, const CMat & Grid, unsigned Turn, unsigned Score, unsigned BestScore, unsigned Size, const CVStr & KeyTab, unsigned MaxTimes )
+    {
+        unsigned Key ((Turn % KeyTab.size() + 1) - 1 ) ;
+        SaveFile << DecToBin(Key) << Separator ; // CRYPTAGE Key (1)
+        string CryptScore = Crypt(Score, Key, KeyTab) ;
+        string CryptBestScore = Crypt(BestScore, Key, KeyTab) ;
+        SaveFile << CryptScore << Separator << CryptBestScore << Separator ; // CRYPTAGE Score (2) BestScore(3)
+        string CryptSize = Crypt(Size, Key, KeyTab) ; // CRYPTAGE Taille (4)
+        SaveFile << CryptSize << Separator ;
+		string CryptTurn = Crypt(Turn, Key, KeyTab) ; // CRYPTAGE Tour (5)
+		SaveFile << CryptTurn << Separator ;
+		string CryptMaxTimes = Crypt (MaxTimes, Key, KeyTab) ; // CRYPTAGE Niveau (6)
+		SaveFile << CryptMaxTimes << Separator ;
         for (unsigned i (0); i < Grid.size (); ++i)
         {
             for (unsigned j (0); j < Grid [i].size (); ++j)
@@ -871,367 +3723,6459 @@ namespace KittyCrush
             }
         }
 
-    } // Save ()
+    } // Save ()
+
+    } // namespace Reference
+
+	/*	LECTURE DES SAUVEGARDES
+
+		Une sauvegarde est une suite de segments de NbZero chiffres binaires, chacun suivi du séparateur : la clé en clair,
+		puis chiffrés par la clé, le score, le meilleur score, la taille, le tour, le nombre maximal de coups et les cases
+		ligne après ligne. CSaveReader la lit en un seul passage, par morceaux de n'importe quelle taille, sans la copier :
+		chaque caractère est vérifié, la clé doit être l'une de KeyTab, la taille entre 1 et KMaxSaveSize, chaque case au
+		plus le nombre maximal de coups (règle de l'ancien chargement), et il faut exactement Taille * Taille cases. Une
+		sauvegarde peut venir de n'importe qui (fichier modifié à la main, et plus tard le serveur) : aucune entrée ne doit
+		faire lire ou écrire hors de la grille. Le mode --fuzz-saves et le point d'entrée libFuzzer (KITTY_FUZZ, à la fin
+		du fichier) le vérifient sur des sauvegardes abîmées au hasard. */
+
+	/** @brief Why a save could not be read, KSaveOk (0) if it could : an error converts to true, like the old result */
+	enum CSaveError : unsigned char { KSaveOk, KSaveMissing, KSaveBadCharacter, KSaveBadSegment, KSaveBadKey, KSaveBadSize,
+									  KSaveBadCell, KSaveTruncated, KSaveTooLong, KSaveBadRules };
+
+	/** @brief Largest grid read from a save, like the time-attack mode */
+	const unsigned KMaxSaveSize = 99;
+
+	/**
+    *@brief Text of an error of the reader
+    *@param Error the error
+    */
+	const char * SaveErrorText (CSaveError Error)
+	{
+		switch (Error)
+		{
+			case KSaveOk :			return "correcte";
+			case KSaveMissing :		return "inexistante";
+			case KSaveBadCharacter :	return "caractère invalide";
+			case KSaveBadSegment :	return "segment de mauvaise longueur";
+			case KSaveBadKey :		return "clé inconnue";
+			case KSaveBadSize :		return "taille invalide";
+			case KSaveBadCell :		return "case invalide";
+			case KSaveTruncated :	return "incomplète";
+			case KSaveTooLong :		return "trop de cases";
+			case KSaveBadRules :	return "règles inconnues";
+		}
+		return "inconnue";
+
+	} // SaveErrorText ()
+
+	/** @brief Single pass reader of a save, given in pieces of any size */
+	class CSaveReader
+	{
+		CMat & Grid;
+		const CVStr & KeyTab;
+		unsigned Values [6];		// Clé, score, meilleur score, taille, tour, nombre maximal de coups
+		unsigned KeyMask;			// La clé en binaire
+		unsigned Segment;			// Numéro du segment en cours
+		unsigned Bits;				// Chiffres du segment en cours
+		unsigned NbBits;
+		unsigned NbCells;			// Cases déjà lues
+		CSaveError Error;
+		bool Ended;					// Fin de ligne lue : la suite du fichier est ignorée, comme le faisait getline ()
+
+		/** @brief Ends the segment at a separator */
+		CSaveError EndSegment ()
+		{
+			if (NbBits != NbZero) return KSaveBadSegment;
+			unsigned Value (Bits);
+			Bits = 0;
+			NbBits = 0;
+
+			if (Segment == 0)
+			{
+				if (Value >= KeyTab.size ()) return KSaveBadKey;
+				KeyMask = 0;
+				for (char Digit : KeyTab [Value]) KeyMask = KeyMask << 1 | (Digit == '1');
+			}
+			else
+				Value ^= KeyMask;
+
+			if (Segment < 6)
+			{
+				Values [Segment++] = Value;
+				if (Segment == 4)
+				{
+					if (Value == 0 || Value > KMaxSaveSize) return KSaveBadSize;
+					SizeGrid (Grid, Value);
+				}
+				return KSaveOk;
+			}
+
+			const unsigned Size (Values [3]);
+			if (NbCells == Size * Size) return KSaveTooLong;
+			if (Value > Values [5]) return KSaveBadCell;
+			Grid [NbCells / Size][NbCells % Size] = Value;
+			++NbCells;
+			return KSaveOk;
+		}
+
+	public:
+		CSaveReader (CMat & SaveGrid, const CVStr & Keys) : Grid (SaveGrid), KeyTab (Keys), KeyMask (0), Segment (0), Bits (0),
+															NbBits (0), NbCells (0), Error (KSaveOk), Ended (false) {}
+
+		/**
+		*@brief Reads the next piece of the save
+		*@return the first error met, KSaveOk so far
+		*/
+		CSaveError Feed (const char * Data, size_t Length)
+		{
+			for (size_t i (0); i < Length && Error == KSaveOk && ! Ended; ++i)
+				switch (Data [i])
+				{
+					case '0' :
+					case '1' :
+						if (NbBits == NbZero)
+							Error = KSaveBadSegment;
+						else
+						{
+							Bits = Bits << 1 | (Data [i] - '0');
+							++NbBits;
+						}
+						break;
+					case Separator :
+						Error = EndSegment ();
+						break;
+					case '\r' :
+					case '\n' :
+						Ended = true;
+						break;
+					default :
+						Error = KSaveBadCharacter;
+				}
+			return Error;
+		}
+
+		/** @brief true once nothing more will be read : an error, or the end of the line */
+		bool Done () const { return Error != KSaveOk || Ended; }
+
+		/**
+		*@brief Ends the reading and gives the parameters of the game, only if the save is correct
+		*@return the error, KSaveOk if the save is correct
+		*/
+		CSaveError Finish (unsigned & Score, unsigned & BestScore, unsigned & Turn, unsigned & Size, unsigned & MaxTimes)
+		{
+			if (Error == KSaveOk && (NbBits != 0 || Segment < 6 || NbCells != Values [3] * Values [3]))
+				Error = KSaveTruncated;
+			if (Error != KSaveOk) return Error;
+
+			Score = Values [1];
+			BestScore = Values [2];
+			Size = Values [3];
+			Turn = Values [4];
+			MaxTimes = Values [5];
+			return KSaveOk;
+		}
+	};
+
+    /**
+    *@brief Acts like InitGrid with the data of a save (the text written by Save)
+    *@param CryptedSave the save
+    *@param Grid the game grid
+    *@param KeyTab vector who contains every keys
+    *@param Score parameter of the game
+    *@param BestScore parameter of the game
+    *@param Turn parameter of the game
+    *@param Size parameter of the game
+    *@param MaxTimes parameter of the game
+    *@return KSaveOk (false) if the save is correct, the parameters are only changed then
+    */
+    CSaveError DecodeSave (const string & CryptedSave, CMat & Grid,const CVStr & KeyTab, unsigned & Score, unsigned & BestScore, unsigned & Turn, unsigned & Size, unsigned & MaxTimes)
+    {
+		CSaveReader Reader (Grid, KeyTab);
+		Reader.Feed (CryptedSave.data (), CryptedSave.size ());
+		return Reader.Finish (Score, BestScore, Turn, Size, MaxTimes);
+
+    } // DecodeSave ()
+
+	/*	MEILLEURS SCORES
+
+		Un fichier par niveau, "scores_<niveau>.dat" : un en-tête de taille fixe (l'index) suivi des scores, un enregistrement
+		de taille fixe par partie, dans l'ordre d'arrivée. L'index range les scores par valeur : un arbre de Fenwick compte
+		les parties de chaque valeur, et chaque valeur a la liste chaînée de ses parties, la plus récente en tête. Ajouter un
+		score, connaître son rang ou lister les k premiers coûte O(log n) par valeur rencontrée, quel que soit le nombre de
+		parties enregistrées. Les scores trop grands pour l'index partagent sa dernière valeur : cette liste-là est gardée
+		triée du meilleur au moins bon, et y insérer un score la parcourt jusqu'à sa place. Un verrou consultatif (fcntl) sur le fichier permet à plusieurs jeux ou serveurs de l'utiliser
+		en même temps. */
+
+	/** @brief Scores are indexed up to this value, higher scores share the last value of the index, kept sorted */
+	const unsigned KScoreBuckets = 8192;
+
+	/** @brief End of a list of scores */
+	const uint32_t KNoEntry = 0xFFFFFFFF;
+
+	/** @brief A score in the leaderboard file */
+	struct CScoreEntry
+	{
+		uint32_t Score;
+		uint32_t Next;		// Enregistrement suivant de même valeur, KNoEntry à la fin
+		int64_t Date;
+		char Name [16];
+	};
+
+	/** @brief Header of the leaderboard file */
+	struct CScoreIndex
+	{
+		char Magic [4];
+		uint32_t NbBuckets;
+		uint64_t NbEntries;
+		uint32_t Tree [KScoreBuckets + 1];	// Arbre de Fenwick des nombres de parties par valeur (indices à partir de 1)
+		uint32_t Heads [KScoreBuckets];		// Dernier enregistrement de chaque valeur
+	};
+
+	/**
+    *@brief Level (from 1 to 4) matching the parameters of a game, 0 if they are not the ones of a level
+    *@param Size parameter of the game
+    *@param MaxTimes parameter of the game
+    *@param NbCandies parameter of the game
+    */
+	unsigned LevelOf (unsigned Size, unsigned MaxTimes, unsigned NbCandies)
+	{
+		for (unsigned Level (0); Level < KLevels.size (); ++Level)
+			if (KLevels [Level].Size == Size && KLevels [Level].MaxTimes == MaxTimes && KLevels [Level].NbCandies == NbCandies)
+				return Level + 1;
+		return 0;
+
+	} // LevelOf ()
+
+	/*	EMPLACEMENTS DE SAUVEGARDE
+
+		Les parties sont sauvegardées dans le dossier "saves", une par emplacement numéroté : "saves/slot_<n>.sav". Chaque
+		fichier commence par un en-tête binaire de taille fixe (CSaveHeader) avec le niveau, le tour, le score, la date et la
+		taille de la grille, suivi de la sauvegarde chiffrée habituelle. L'en-tête de chaque emplacement est recopié dans
+		"saves/index.dat", à la position de son emplacement : le menu "Charger Partie" lit ce seul petit fichier pour lister
+		les parties, et le chargement d'une partie ne lit que son propre fichier. Si l'index manque, il est reconstruit à
+		partir des en-têtes des fichiers. Une ancienne sauvegarde "save.txt" est reprise dans un emplacement libre. */
+
+	/** @brief Number of save slots */
+	const unsigned KNbSlots = 256;
+
+	const string KSaveDirectory ("./saves");
+
+	const uint32_t KSaveVersion = 1;
+
+	/** @brief Header of a save file, and entry of the index of the slots */
+	struct CSaveHeader
+	{
+		char Magic [4];		// "KCSV", que des 0 dans l'index pour un emplacement vide
+		uint32_t Version;
+		uint32_t Level;		// 1 à 4, 0 si la partie ne correspond à aucun niveau
+		uint32_t Turn;
+		uint32_t MaxTimes;
+		uint32_t Score;
+		uint32_t Size;
+		uint8_t Rules;		// Indice dans KRuleSets, 0 (classiques) dans les sauvegardes d'avant les variantes
+		uint8_t NbCandies;	// 0 dans les sauvegardes plus anciennes : celui du niveau de même taille et même nombre de coups
+		uint8_t Adaptive;	// 1 pour une partie adaptative
+		uint8_t Reserved;
+		int64_t Date;		// Dernière sauvegarde, en secondes depuis 1970
+	};
+
+	/** @brief Checks that a header is the one of a used slot */
+	inline bool IsUsedSlot (const CSaveHeader & Header)
+	{
+		return memcmp (Header.Magic, "KCSV", 4) == 0 && Header.Version == KSaveVersion;
+
+	} // IsUsedSlot ()
+
+	/** @brief Path of the save file of a slot */
+	string SlotPath (unsigned Slot)
+	{
+		ostringstream Path;
+		Path << KSaveDirectory << "/slot_" << setw (3) << setfill ('0') << Slot << ".sav";
+		return Path.str ();
+
+	} // SlotPath ()
+
+	/** @brief Creates the save directory if needed */
+	void MakeSaveDirectory ()
+	{
+		#ifdef _WIN32
+			CreateDirectoryA (KSaveDirectory.c_str (), NULL);
+		#else
+			mkdir (KSaveDirectory.c_str (), 0755);
+		#endif
+
+	} // MakeSaveDirectory ()
+
+	/**
+    *@brief Reads the header of a save file, and only it
+    *@return false if the slot is empty or its file is not a save
+    */
+	bool ReadSlotHeader (unsigned Slot, CSaveHeader & Header)
+	{
+		ifstream File (SlotPath (Slot), ios::binary);
+		return File.read (reinterpret_cast <char *> (&Header), sizeof (Header)) && IsUsedSlot (Header);
+
+	} // ReadSlotHeader ()
+
+	/**
+    *@brief Reads the headers of all the slots from the index, which is rebuilt from the save files if it is missing
+    *@param Headers the KNbSlots headers, empty ones for the empty slots
+    */
+	void ReadSaveIndex (vector <CSaveHeader> & Headers)
+	{
+		Headers.assign (KNbSlots, CSaveHeader ());
+		ifstream Index (KSaveDirectory + "/index.dat", ios::binary);
+		if (Index.read (reinterpret_cast <char *> (Headers.data ()), KNbSlots * sizeof (CSaveHeader))) return;
+
+		for (unsigned Slot (0); Slot < KNbSlots; ++Slot)
+			if (! ReadSlotHeader (Slot, Headers [Slot]))
+				Headers [Slot] = CSaveHeader ();
+
+		MakeSaveDirectory ();
+		ofstream Rebuilt (KSaveDirectory + "/index.dat", ios::binary | ios::trunc);
+		Rebuilt.write (reinterpret_cast <const char *> (Headers.data ()), KNbSlots * sizeof (CSaveHeader));
+
+	} // ReadSaveIndex ()
+
+	/** @brief Writes the header of a slot at its place in the index */
+	void WriteSaveIndex (unsigned Slot, const CSaveHeader & Header)
+	{
+		fstream Index (KSaveDirectory + "/index.dat", ios::binary | ios::in | ios::out);
+		if (! Index)
+		{
+			/* Pas encore d'index : on le construit, il contient alors déjà cet emplacement */
+			vector <CSaveHeader> Headers;
+			ReadSaveIndex (Headers);
+			return;
+		}
+		Index.seekp (Slot * sizeof (CSaveHeader));
+		Index.write (reinterpret_cast <const char *> (&Header), sizeof (Header));
+
+	} // WriteSaveIndex ()
+
+	/**
+    *@brief Slot for a new game : the first empty one, or the one saved the longest ago
+    */
+	unsigned FreeSlot ()
+	{
+		vector <CSaveHeader> Headers;
+		ReadSaveIndex (Headers);
+		unsigned Oldest (0);
+		for (unsigned Slot (0); Slot < KNbSlots; ++Slot)
+		{
+			if (! IsUsedSlot (Headers [Slot])) return Slot;
+			if (Headers [Slot].Date < Headers [Oldest].Date) Oldest = Slot;
+		}
+		return Oldest;
+
+	} // FreeSlot ()
+
+    /**
+    *@brief Save the game in its slot, then updates the index
+    *@param Slot the slot of the game
+    *@param Grid the game grid
+    *@param Turn parameter of the game
+    *@param Score parameter of the game
+    *@param BestScore parameter of the game
+    *@param Size parameter of the game
+    *@param KeyTab vector who contains every keys
+    *@param MaxTimes parameter of the game
+    *@param Rules index in KRuleSets of the rules of the game
+    *@param NbCandies parameter of the game
+    *@param Adaptive whether the parameters were chosen by the adaptive level
+    */
+    void Save (unsigned Slot, const CMat & Grid, unsigned Turn, unsigned Score, unsigned BestScore, unsigned Size, const CVStr & KeyTab, unsigned MaxTimes,
+			   unsigned Rules, unsigned NbCandies, bool Adaptive)
+    {
+		CSaveHeader Header;
+		memcpy (Header.Magic, "KCSV", 4);
+		Header.Version = KSaveVersion;
+		Header.Level = Adaptive ? 0 : LevelOf (Size, MaxTimes, NbCandies);
+		Header.Turn = Turn;
+		Header.MaxTimes = MaxTimes;
+		Header.Score = Score;
+		Header.Size = Size;
+		Header.Rules = Rules;
+		Header.NbCandies = NbCandies;
+		Header.Adaptive = Adaptive;
+		Header.Reserved = 0;
+		Header.Date = time (NULL);
+
+		MakeSaveDirectory ();
+		ofstream SaveFile (SlotPath (Slot), ios::binary | ios::trunc);
+		SaveFile.write (reinterpret_cast <const char *> (&Header), sizeof (Header));
+		Save (SaveFile, Grid, Turn, Score, BestScore, Size, KeyTab, MaxTimes);
+		SaveFile.close ();
+
+		WriteSaveIndex (Slot, Header);
+
+    } // Save ()
+
+    /**
+    *@brief Acts like InitGrid and loads a slot, reading only its file
+    *@param Rules index in KRuleSets of the rules of the game, read from the header
+    *@param NbCandies parameter of the game, read from the header (left as it is in the oldest saves, without a level)
+    *@param Adaptive whether it is an adaptive game, read from the header
+    *@return KSaveOk (false) if the save is correct, the error if it is missing or corrupted
+    * The file is read block by block straight into the reader
+    */
+    CSaveError LoadSave (unsigned Slot, CMat & Grid, const CVStr & KeyTab, unsigned & Score, unsigned & BestScore, unsigned & Turn, unsigned & Size, unsigned & MaxTimes,
+						 unsigned & Rules, unsigned & NbCandies, bool & Adaptive)
+    {
+		ifstream SaveFile (SlotPath (Slot), ios::binary);
+		CSaveHeader Header;
+		if (! SaveFile.read (reinterpret_cast <char *> (&Header), sizeof (Header)) || ! IsUsedSlot (Header))
+		{
+			cout << "Sauvegarde Inexistante" << endl;
+			return KSaveMissing;
+		}
+		if (Header.Rules >= KRuleSets.size ()) return KSaveBadRules;
+		Rules = Header.Rules;
+		Adaptive = Header.Adaptive != 0;
+		CSaveReader Reader (Grid, KeyTab);
+		char Block [4096];
+		while (! Reader.Done () && (SaveFile.read (Block, sizeof (Block)) || SaveFile.gcount () > 0))
+			Reader.Feed (Block, SaveFile.gcount ());
+		if (const CSaveError Error = Reader.Finish (Score, BestScore, Turn, Size, MaxTimes)) return Error;
+
+		if (Header.NbCandies != 0)
+			NbCandies = Header.NbCandies;
+		else if (Header.Level >= 1 && Header.Level <= KLevels.size ())
+			NbCandies = KLevels [Header.Level - 1].NbCandies;
+		return KSaveOk;
+
+    } // LoadSave ()
+
+    /**
+    *@brief Existing save
+    Test if a slot is used. An old save.txt is first moved to an empty slot
+    */
+    bool ExistingSave () // Y a-t-il une partie sauvegardée ?
+    {
+		ifstream Legacy ("./save.txt");
+		if (Legacy)
+		{
+			CMat Grid;
+			unsigned Score (0), BestScore (0), Turn (0), Size (0), MaxTimes (0);
+			string CryptedSave;
+			getline (Legacy, CryptedSave);
+			Legacy.close ();
+			if (! DecodeSave (CryptedSave, Grid, KeyTab, Score, BestScore, Turn, Size, MaxTimes) && Size != 0)
+				Save (FreeSlot (), Grid, Turn, Score, BestScore, Size, KeyTab, MaxTimes, 0, 0, false);
+			rename ("./save.txt", "./save.txt.old");
+		}
+
+		vector <CSaveHeader> Headers;
+		ReadSaveIndex (Headers);
+		for (const CSaveHeader & Header : Headers)
+			if (IsUsedSlot (Header)) return true;
+		return false;
+
+    } // ExistingSave ()
+
+    /**
+    *@brief Lists the saved games from the index, the most recent first, and lets the player choose one
+    *@return the slot chosen, KNbSlots to go back to the menu
+    */
+    unsigned ChooseSave ()
+    {
+		vector <CSaveHeader> Headers;
+		ReadSaveIndex (Headers);
+		vector <unsigned> Slots;
+		for (unsigned Slot (0); Slot < KNbSlots; ++Slot)
+			if (IsUsedSlot (Headers [Slot])) Slots.push_back (Slot);
+		sort (Slots.begin (), Slots.end (), [&] (unsigned a, unsigned b) { return Headers [a].Date > Headers [b].Date; });
+
+		ClearScreen ();
+		cout << '\t' << "Charger une partie : " << endl << endl;
+		for (unsigned s (0); s < Slots.size (); ++s)
+		{
+			const CSaveHeader & Header (Headers [Slots [s]]);
+			const time_t When (Header.Date);
+			char Date [32];
+			strftime (Date, sizeof (Date), "%d/%m/%Y %H:%M", localtime (&When));
+			const string Kind (Header.Adaptive ? string ("Adaptative")
+							   : Header.Level != 0 ? "Niveau " + to_string (Header.Level) : string ("Personnalisée"));
+			cout << setw (3) << s + 1 << " - " << Kind
+				 << ", " << Header.Size << "x" << Header.Size << ", coup " << Header.Turn << "/" << Header.MaxTimes
+				 << ", score " << Header.Score << ", " << Date << endl;
+		}
+		cout << setw (3) << Slots.size () + 1 << " - Retour au menu" << endl << endl;
+
+		unsigned Choix;
+		MenuPrompt (Choix, Slots.size () + 1);
+		return Choix <= Slots.size () ? Slots [Choix - 1] : KNbSlots;
+
+    } // ChooseSave ()
+
+#ifndef _WIN32
+
+	/** @brief Leaderboard of a level, shared between processes */
+	class CLeaderboard
+	{
+		int Fd;
+		CScoreIndex * Index;
+
+		/** @brief Locks the whole file, for reading or writing */
+		bool Lock (short Type)
+		{
+			struct flock Request;
+			memset (&Request, 0, sizeof (Request));
+			Request.l_type = Type;
+			Request.l_whence = SEEK_SET;
+			while (fcntl (Fd, F_SETLKW, &Request) < 0)
+				if (errno != EINTR) return false;
+			return true;
+		}
+
+		/** @brief Number of entries whose value is lower than or equal to Bucket - 1 */
+		uint32_t Prefix (unsigned Bucket) const
+		{
+			uint32_t Count (0);
+			for (; Bucket > 0; Bucket &= Bucket - 1)
+				Count += Index -> Tree [Bucket];
+			return Count;
+		}
+
+		/** @brief Smallest value (index from 1) such that Prefix (value) >= Rank */
+		unsigned FindRank (uint32_t Rank) const
+		{
+			unsigned Bucket (0);
+			for (unsigned Step (KScoreBuckets); Step > 0; Step /= 2)
+				if (Bucket + Step <= KScoreBuckets && Index -> Tree [Bucket + Step] < Rank)
+				{
+					Bucket += Step;
+					Rank -= Index -> Tree [Bucket];
+				}
+			return Bucket + 1;
+		}
+
+		off_t Offset (uint32_t Entry) const { return sizeof (CScoreIndex) + off_t (Entry) * sizeof (CScoreEntry); }
+
+	  public:
+		CLeaderboard () : Fd (-1), Index (NULL) {}
+		~CLeaderboard () { Close (); }
+
+		/**
+		*@brief Opens (or creates) the leaderboard of a level
+		*@param Level the level, from 1 to 4
+		*@param Directory where the file is
+		*/
+		bool Open (unsigned Level, const string & Directory = ".")
+		{
+			Close ();
+			const string Path (Directory + "/scores_" + to_string (Level) + ".dat");
+			Fd = open (Path.c_str (), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+			if (Fd < 0 || ! Lock (F_WRLCK)) return false;
+
+			/* Premier utilisateur du fichier : on écrit l'en-tête */
+			struct stat Status;
+			bool Valid (fstat (Fd, &Status) == 0);
+			if (Valid && Status.st_size < off_t (sizeof (CScoreIndex)))
+			{
+				Valid = ftruncate (Fd, sizeof (CScoreIndex)) == 0;
+				CScoreIndex Header;
+				Valid = Valid && pread (Fd, &Header, sizeof (Header), 0) == sizeof (Header);
+				memcpy (Header.Magic, "KCSB", 4);
+				Header.NbBuckets = KScoreBuckets;
+				for (uint32_t & Head : Header.Heads) Head = KNoEntry;
+				Valid = Valid && pwrite (Fd, &Header, sizeof (Header), 0) == sizeof (Header);
+			}
+
+			if (Valid)
+			{
+				void * Map (mmap (NULL, sizeof (CScoreIndex), PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0));
+				Index = Map == MAP_FAILED ? NULL : static_cast <CScoreIndex *> (Map);
+				Valid = Index != NULL && memcmp (Index -> Magic, "KCSB", 4) == 0 && Index -> NbBuckets == KScoreBuckets;
+			}
+			Lock (F_UNLCK);
+
+			if (! Valid) Close ();
+			return Valid;
+		}
+
+		void Close ()
+		{
+			if (Index != NULL) munmap (Index, sizeof (CScoreIndex));
+			if (Fd >= 0) close (Fd);
+			Index = NULL;
+			Fd = -1;
+		}
+
+		/**
+		*@brief Adds a score
+		*@param Score the score
+		*@param Name the name of the player (truncated to 15 characters)
+		*@param Rank the rank of the score among all the scores of the level (1 : best)
+		*/
+		bool Insert (unsigned Score, const string & Name, uint64_t & Rank)
+		{
+			if (Index == NULL || ! Lock (F_WRLCK)) return false;
+
+			const unsigned Bucket (min (Score, KScoreBuckets - 1));
+			CScoreEntry Entry;
+			memset (&Entry, 0, sizeof (Entry));
+			Entry.Score = Score;
+			Entry.Next = Index -> Heads [Bucket];
+			Entry.Date = time (NULL);
+			strncpy (Entry.Name, Name.c_str (), sizeof (Entry.Name) - 1);
+
+			/* Dernière valeur : le score prend sa place dans la liste triée, après les Better meilleurs que lui */
+			bool Done (true);
+			uint32_t Previous (KNoEntry);	// Enregistrement qui précède le nouveau, KNoEntry s'il est en tête
+			uint64_t Better (0);
+			if (Bucket == KScoreBuckets - 1)
+			{
+				CScoreEntry Other;
+				while (Done && Entry.Next != KNoEntry)
+				{
+					Done = pread (Fd, &Other, sizeof (Other), Offset (Entry.Next)) == sizeof (Other);
+					if (! Done || Other.Score <= Score) break;
+					Previous = Entry.Next;
+					Entry.Next = Other.Next;
+					++Better;
+				}
+			}
+
+			const uint32_t Number (Index -> NbEntries);
+			Done = Done && pwrite (Fd, &Entry, sizeof (Entry), Offset (Number)) == sizeof (Entry);
+			if (Done && Previous != KNoEntry)
+				Done = pwrite (Fd, &Number, sizeof (Number), Offset (Previous) + offsetof (CScoreEntry, Next)) == sizeof (Number);
+			if (Done)
+			{
+				/* L'enregistrement est écrit avant d'être rendu visible par l'index */
+				if (Previous == KNoEntry) Index -> Heads [Bucket] = Number;
+				for (unsigned Node (Bucket + 1); Node <= KScoreBuckets; Node += Node & -Node)
+					++Index -> Tree [Node];
+				++Index -> NbEntries;
+				Rank = Index -> NbEntries - Prefix (Bucket + 1) + 1 + Better;
+			}
+
+			Lock (F_UNLCK);
+			return Done;
+		}
+
+		/**
+		*@brief Reads the best scores, from the best one
+		*@param NbWanted how many scores to read at most
+		*@param Entries filled with the scores
+		*/
+		bool Top (unsigned NbWanted, vector <CScoreEntry> & Entries)
+		{
+			Entries.clear ();
+			if (Index == NULL || ! Lock (F_RDLCK)) return false;
+
+			const uint64_t NbEntries (Index -> NbEntries);
+			bool Done (true);
+			for (uint64_t Rank (1); Done && Rank <= NbEntries && Entries.size () < NbWanted;)
+			{
+				/* Valeur du Rank-ième score en partant du meilleur, puis on parcourt sa liste */
+				const unsigned Bucket (FindRank (NbEntries - Rank + 1) - 1);
+				Rank += Prefix (Bucket + 1) - Prefix (Bucket);
+				for (uint32_t Entry (Index -> Heads [Bucket]); Done && Entry != KNoEntry && Entries.size () < NbWanted;)
+				{
+					Entries.push_back (CScoreEntry ());
+					Done = pread (Fd, &Entries.back (), sizeof (CScoreEntry), Offset (Entry)) == sizeof (CScoreEntry);
+					Entry = Entries.back ().Next;
+				}
+			}
+
+			Lock (F_UNLCK);
+			return Done;
+		}
+
+		/** @brief Number of scores of the level */
+		uint64_t Size () const { return Index != NULL ? Index -> NbEntries : 0; }
+	};
+
+	/**
+    *@brief Best score of a level, 0 if there is none yet
+    *@param Level the level, from 1 to 4
+    */
+	unsigned BestScoreOf (unsigned Level)
+	{
+		CLeaderboard Board;
+		vector <CScoreEntry> Best;
+		if (Level == 0 || ! Board.Open (Level) || ! Board.Top (1, Best) || Best.empty ())
+			return 0;
+		return Best [0].Score;
+
+	} // BestScoreOf ()
+
+	/**
+    *@brief Adds the score of a finished game to the leaderboard of its level and tells the player his rank
+    *@param Level the level, from 1 to 4
+    *@param Score the final score
+    */
+	void RecordScore (unsigned Level, unsigned Score)
+	{
+		CLeaderboard Board;
+		if (Level == 0 || ! Board.Open (Level)) return;
+
+		/* Toute la ligne : un nom peut contenir des espaces */
+		string Name;
+		do
+		{
+			cout << "Votre nom pour le tableau des scores : ";
+			cin.clear ();
+			if (! getline (cin, Name)) return;
+			Name.erase (0, Name.find_first_not_of (" \t\r"));
+			Name.erase (Name.find_last_not_of (" \t\r") + 1);
+		} while (Name.empty ());
+
+		uint64_t Rank;
+		if (Board.Insert (Score, Name, Rank))
+			cout << "Vous êtes " << Rank << (Rank == 1 ? "er" : "e") << " sur " << Board.Size () << " parties de ce niveau" << endl;
+
+	} // RecordScore ()
+
+	/**
+    *@brief Displays the best scores of a level
+    */
+	void DisplayBestScores ()
+	{
+		ClearScreen ();
+		cout << '\t' << "Meilleurs scores" << endl << endl
+			 << "1 - Facile" << endl << "2 - Moyen" << endl << "3 - Difficile" << endl << "4 - Expert" << endl << endl;
+
+		unsigned Level;
+		MenuPrompt (Level, KLevels.size ());
+
+		ClearScreen ();
+		CLeaderboard Board;
+		vector <CScoreEntry> Best;
+		if (! Board.Open (Level) || ! Board.Top (10, Best))
+			cerr << "Erreur : tableau des scores illisible" << endl;
+		else if (Best.empty ())
+			cout << "Aucune partie terminée à ce niveau" << endl;
+		else
+		{
+			cout << '\t' << "Niveau " << Level << " : " << Board.Size () << (Board.Size () > 1 ? " parties" : " partie") << endl << endl;
+			for (unsigned i (0); i < Best.size (); ++i)
+			{
+				char Date [32];
+				time_t When (Best [i].Date);
+				strftime (Date, sizeof (Date), "%d/%m/%Y", localtime (&When));
+				cout << setw (3) << i + 1 << ". " << left << setw (16) << Best [i].Name << right << setw (6) << Best [i].Score << "   " << Date << endl;
+			}
+		}
+
+		cout << endl << "Tapez Entrée pour revenir au menu...";
+		string B;
+		getline (cin, B);
+
+	} // DisplayBestScores ()
+
+	/**
+    *@brief Inserts random scores in a temporary leaderboard and times inserts and top 10 queries (mode --bench-scores)
+    *@param NbScores how many scores to insert
+    */
+	int RunScoresBenchmark (unsigned NbScores)
+	{
+		char Directory [] = "/tmp/kittyscoresXXXXXX";
+		if (mkdtemp (Directory) == NULL)
+		{
+			cerr << "Impossible de créer un dossier temporaire" << endl;
+			return 1;
+		}
+
+		CLeaderboard Board;
+		if (! Board.Open (1, Directory))
+		{
+			cerr << "Impossible d'ouvrir le tableau des scores" << endl;
+			return 1;
+		}
+
+		CRandom Rand (time (NULL));
+		uint64_t Rank;
+		chrono::steady_clock::time_point Start (chrono::steady_clock::now ());
+		for (unsigned i (0); i < NbScores; ++i)
+			Board.Insert (Rand () % 2000, "bench", Rank);
+		const double InsertNs (ElapsedNs (Start) / NbScores);
+
+		const unsigned NbQueries (1000);
+		vector <CScoreEntry> Best;
+		bool Sorted (true);
+		Start = chrono::steady_clock::now ();
+		for (unsigned i (0); i < NbQueries; ++i)
+		{
+			Board.Top (10, Best);
+			for (unsigned k (1); k < Best.size (); ++k)
+				Sorted = Sorted && Best [k - 1].Score >= Best [k].Score;
+		}
+		const double TopNs (ElapsedNs (Start) / NbQueries);
+
+		cout << NbScores << " scores : ajout " << fixed << setprecision (2) << InsertNs / 1000 << " us, top 10 "
+			 << TopNs / 1000 << " us" << endl;
+
+		Board.Close ();
+		unlink ((string (Directory) + "/scores_1.dat").c_str ());
+		rmdir (Directory);
+
+		if (! Sorted) cerr << "Erreur : le top 10 n'est pas trié" << endl;
+		return Sorted ? 0 : 1;
+
+	} // RunScoresBenchmark ()
+
+#endif // _WIN32
+
+	/*	PUZZLES
+
+		Le mode --puzzles cherche, sur tous les cœurs, des grilles de départ dont le meilleur score en un nombre de coups
+		donné tombe dans une fourchette : deux parties sur le même puzzle ont la même difficulté. Le meilleur score est
+		calculé par une recherche exhaustive sur tous les coups permis, même ceux qui ne marquent rien, avec une table des
+		grilles déjà vues, puisque deux coups joués loin l'un de l'autre donnent la même grille dans les deux ordres : c'est
+		alors le meilleur score possible. Quand la recherche exhaustive dépasserait KPuzzleBudget positions, elle n'explore
+		que les coups qui marquent (tous quand la grille contient encore une suite) : le score trouvé n'est qu'un score à
+		atteindre, que le joueur peut dépasser. Une grille dont cette recherche dépasse aussi le budget est écartée.
+		Les puzzles acceptés sont rangés dans un recueil (entiers dans l'ordre de la machine) :
+
+			en-tête			"KCPZ", version, taille, nombre de numéros, nombre de coups, nombre de puzzles (6 x 4 octets)
+			puzzles			meilleur score (2 octets), 1 s'il est le meilleur possible, 0 si c'est un score à atteindre
+							(1 octet), un octet par coup de la solution (i * taille + j, bit 7 : échange avec la case du
+							dessous plutôt qu'avec celle de droite), puis les cases, deux par octet
+
+		Tous les puzzles ont la même taille : le puzzle n se lit directement à sa position, sans parcourir le recueil. Une
+		case tient sur 7 bits : la taille est au plus 11. Sur un puzzle, une grille bloquée n'est pas mélangée, la partie
+		s'arrête. */
+
+	/** @brief Positions the search may visit for one grid */
+	const uint64_t KPuzzleBudget = 2000000;
+
+	/** @brief Largest puzzle : the cell of a move of the solution is written on 7 bits */
+	const unsigned KPuzzleMaxSize = 11;
+
+	/** @brief Grids searched per puzzle asked before the generator gives up (band too narrow, or too many moves) */
+	const unsigned KPuzzleTries = 1000;
+
+	const uint32_t KPuzzleVersion = 2;
+
+	/** @brief A puzzle : the grid, how many moves to play, the best score found and a move sequence reaching it */
+	struct CPuzzle
+	{
+		CLevel Level;		// MaxTimes est le nombre de coups du puzzle
+		unsigned Best;
+		bool Exact;			// Best est le meilleur score possible, sinon un score à atteindre
+		CMat Grid;
+		CVMove Solution;
+	};
+
+	/** @brief Exhaustive search of the best score of a grid, over every move, or over the moves that score if it is too big */
+	class CPuzzleSolver
+	{
+		struct CEntry
+		{
+			uint64_t Key;		// 0 : case libre
+			unsigned Best;
+		};
+
+		vector <CMat> Boards;		// Grille à chaque profondeur
+		vector <CVMove> Moves;		// Coups explorés à chaque profondeur
+		vector <CEntry> Table;		// Meilleur score depuis une grille, selon le nombre de coups restants
+		uint64_t NbNodes;
+		uint64_t Salt;				// Change à chaque recherche : la table n'a pas à être vidée
+		bool AllMoves;				// Recherche exhaustive, sinon seulement sur les coups qui marquent
+
+		uint64_t KeyOf (const CMat & Grid, unsigned MovesLeft) const
+		{
+			uint64_t Key ((14695981039346656037ull ^ MovesLeft) + Salt);
+			for (const CVLine & Line : Grid)
+				for (unsigned Cell : Line)
+					Key = (Key ^ Cell) * 1099511628211ull;
+			return Key | 1;
+		}
+
+		/**
+		*@brief Lists every valid move of a grid, towards the right or the bottom (the swap is the same both ways)
+		*/
+		static void ListValidMoves (const CMat & Grid, CVMove & Moves)
+		{
+			Moves.clear ();
+			for (unsigned i (0); i < Grid.size (); ++i)
+				for (unsigned j (0); j < Grid [i].size (); ++j)
+					if (Grid [i][j] != KImpossible)
+						for (char Direction : {KeyRight, KeyDown})
+							if (IsValidMove (Grid, make_pair (i, j), Direction))
+								Moves.push_back (CMove {make_pair (i, j), Direction});
+		}
+
+		/** @brief The moves explored from a grid : all of them, or those that score, every move scoring while a run is left */
+		void ListMoves (unsigned Depth)
+		{
+			if (AllMoves || HasRun (Boards [Depth]))
+				ListValidMoves (Boards [Depth], Moves [Depth]);
+			else
+				ListScoringMoves (Boards [Depth], Moves [Depth]);
+		}
+
+		/** @brief Best score of Boards [Depth] with MovesLeft moves, false if the budget is exhausted */
+		bool Search (unsigned Depth, unsigned MovesLeft, unsigned & Best)
+		{
+			Best = 0;
+			if (MovesLeft == 0) return true;
+
+			const uint64_t Key (KeyOf (Boards [Depth], MovesLeft));
+			CEntry & Entry (Table [Key & (Table.size () - 1)]);
+			if (Entry.Key == Key)
+			{
+				Best = Entry.Best;
+				return true;
+			}
+
+			/* Comme dans la partie : une grille où plus aucun coup ne marque arrête le puzzle */
+			if (HasScoringMove (Boards [Depth]))
+			{
+				ListMoves (Depth);
+				for (const CMove & Move : Moves [Depth])
+				{
+					if (++NbNodes > KPuzzleBudget) return false;
+					Boards [Depth + 1] = Boards [Depth];
+					unsigned Points (0), Next;
+					PlayMove (Boards [Depth + 1], Move.Pos, Move.Direction, Points);
+					if (! Search (Depth + 1, MovesLeft - 1, Next)) return false;
+					Best = max (Best, Points + Next);
+				}
+			}
+
+			Entry.Key = Key;
+			Entry.Best = Best;
+			return true;
+		}
+
+	public:
+		CPuzzleSolver () : Table (size_t (1) << 18, CEntry {0, 0}), NbNodes (0), Salt (0), AllMoves (true) {}
+
+		/**
+		*@brief Best score of Grid in NbMoves moves, and a sequence of moves reaching it
+		*@param Exact set if Best is the best possible score : false when only the moves that score could be searched
+		*@return false if the search went over KPuzzleBudget positions
+		*/
+		bool Solve (const CMat & Grid, unsigned NbMoves, unsigned & Best, bool & Exact, CVMove & Solution)
+		{
+			Boards.resize (NbMoves + 1);
+			Moves.resize (NbMoves + 1);
+			Boards [0] = Grid;
+
+			/* Sans la table, la recherche exhaustive jouerait (nombre de coups permis) ^ NbMoves coups : au-delà du budget,
+			   elle n'est pas tentée */
+			ListValidMoves (Grid, Moves [0]);
+			uint64_t Estimate (1);
+			for (unsigned m (0); m < NbMoves && Estimate <= KPuzzleBudget; ++m)
+				Estimate *= Moves [0].size ();
+			AllMoves = Exact = Estimate <= KPuzzleBudget;
+
+			Salt += 0x9E3779B97F4A7C15ull;
+			NbNodes = 0;
+			if (! Search (0, NbMoves, Best))
+			{
+				if (! AllMoves) return false;
+
+				/* La table n'a pas suffi : un score à atteindre plutôt que rien. Les scores déjà rangés valent pour tous
+				   les coups, la nouvelle recherche ne doit pas les lire */
+				AllMoves = Exact = false;
+				Salt += 0x9E3779B97F4A7C15ull;
+				NbNodes = 0;
+				if (! Search (0, NbMoves, Best)) return false;
+			}
+
+			/* La solution : à chaque coup, un de ceux qui atteignent encore le meilleur score. La table est pleine de
+			   ces grilles, chaque étape ne coûte que quelques lectures */
+			Solution.clear ();
+			unsigned Left (Best);
+			for (unsigned Depth (0); Left != 0 && Depth < NbMoves; ++Depth)
+			{
+				ListMoves (Depth);
+				for (const CMove & Move : Moves [Depth])
+				{
+					Boards [Depth + 1] = Boards [Depth];
+					unsigned Points (0), Next;
+					PlayMove (Boards [Depth + 1], Move.Pos, Move.Direction, Points);
+					if (! Search (Depth + 1, NbMoves - Depth - 1, Next)) return false;
+					if (Points + Next == Left)
+					{
+						Solution.push_back (Move);
+						Left = Next;
+						break;
+					}
+				}
+			}
+			return true;
+		}
+
+		uint64_t Nodes () const { return NbNodes; }
+	};
+
+	/** @brief Bytes of a puzzle in a pack */
+	inline size_t PuzzleBytes (const CLevel & Level)
+	{
+		return 3 + Level.MaxTimes + (Level.Size * Level.Size + 1) / 2;
+
+	} // PuzzleBytes ()
+
+	/**
+    *@brief Reads the puzzle Number of a pack, without reading the others
+    *@return false if the pack is not valid or has no such puzzle
+    */
+	bool LoadPuzzle (const string & Path, unsigned Number, CPuzzle & Puzzle)
+	{
+		ifstream File (Path, ios::binary);
+		char Magic [4];
+		uint32_t Header [5];		// Version, taille, numéros, coups, nombre de puzzles
+		if (! File.read (Magic, 4) || ! File.read (reinterpret_cast <char *> (Header), sizeof (Header))
+			|| memcmp (Magic, "KCPZ", 4) != 0 || Header [0] != KPuzzleVersion || Header [1] < 3 || Header [1] > KPuzzleMaxSize
+			|| Header [2] < 3 || Header [2] > 15 || Header [3] == 0 || Header [3] > 64 || Number >= Header [4])
+			return false;
+
+		Puzzle.Level = CLevel {Header [1], Header [3], Header [2]};
+		vector <uint8_t> Bytes (PuzzleBytes (Puzzle.Level));
+		File.seekg (4 + sizeof (Header) + uint64_t (Number) * Bytes.size ());
+		if (! File.read (reinterpret_cast <char *> (Bytes.data ()), Bytes.size ())) return false;
+
+		const unsigned Size (Puzzle.Level.Size);
+		Puzzle.Best = Bytes [0] | (Bytes [1] << 8);
+		Puzzle.Exact = Bytes [2] != 0;
+		Puzzle.Solution.clear ();
+		for (unsigned m (0); m < Puzzle.Level.MaxTimes && Bytes [3 + m] != 0xFF; ++m)
+		{
+			const unsigned Cell (Bytes [3 + m] & 0x7F);
+			if (Cell >= Size * Size) return false;
+			Puzzle.Solution.push_back (CMove {make_pair (Cell / Size, Cell % Size), Bytes [3 + m] & 0x80 ? KeyDown : KeyRight});
+		}
+
+		const uint8_t * Cells (&Bytes [3 + Puzzle.Level.MaxTimes]);
+		Puzzle.Grid.assign (Size, CVLine (Size));
+		for (unsigned c (0); c < Size * Size; ++c)
+		{
+			const unsigned Value ((Cells [c / 2] >> (c % 2 * 4)) & 0xF);
+			if (Value > Puzzle.Level.NbCandies) return false;
+			Puzzle.Grid [c / Size][c % Size] = Value;
+		}
+		return true;
+
+	} // LoadPuzzle ()
+
+	/**
+    *@brief Searches puzzles on one thread, until the threads together have accepted Count of them
+    *@param Accepted the puzzles accepted by all the threads
+    *@param Tried the grids searched by all the threads : they give up after KPuzzleTries per puzzle asked
+    *@param Found the puzzles of this thread
+    *@param NbTried how many grids this thread has searched
+    *@param NbOverBudget how many of them went over KPuzzleBudget
+    *@param NbExact how many of the puzzles found have their best possible score
+    */
+	void GeneratePuzzles (const CLevel & Level, unsigned Count, unsigned MinScore, unsigned MaxScore, uint32_t Seed,
+						  atomic <unsigned> & Accepted, atomic <uint64_t> & Tried, vector <CPuzzle> & Found,
+						  uint64_t & NbTried, uint64_t & NbOverBudget, uint64_t & NbExact)
+	{
+		CRandom Rand (Seed);
+		CPuzzleSolver Solver;
+		CPuzzle Puzzle;
+		Puzzle.Level = Level;
+
+		while (Accepted.load () < Count && Tried.fetch_add (1) < uint64_t (Count) * KPuzzleTries)
+		{
+			InitGrid (Puzzle.Grid, Level.Size, Level.NbCandies, Rand);
+			++NbTried;
+			if (! Solver.Solve (Puzzle.Grid, Level.MaxTimes, Puzzle.Best, Puzzle.Exact, Puzzle.Solution))
+			{
+				++NbOverBudget;
+				continue;
+			}
+			if (Puzzle.Best < MinScore || Puzzle.Best > MaxScore) continue;
+			if (Accepted.fetch_add (1) >= Count) break;
+			Found.push_back (Puzzle);
+			NbExact += Puzzle.Exact;
+		}
+
+	} // GeneratePuzzles ()
+
+	/**
+    *@brief Puzzle generator (mode --puzzles) : writes Count puzzles of a level whose best score is in [MinScore, MaxScore]
+    *@param Path the pack to write
+    *@param NbMoves the moves of each puzzle, 0 for the MaxTimes of the level
+    *@param NbThreads how many threads, 0 for one per core
+    */
+	int RunPuzzleGenerator (const string & Path, const CLevel & Level, unsigned Count, unsigned MinScore, unsigned MaxScore,
+							unsigned NbMoves, unsigned NbThreads)
+	{
+		CLevel PuzzleLevel (Level);
+		if (NbMoves != 0) PuzzleLevel.MaxTimes = NbMoves;
+		if (NbThreads == 0) NbThreads = max (1u, thread::hardware_concurrency ());
+		if (Count == 0 || MinScore > MaxScore || MaxScore > 0xFFFF || PuzzleLevel.MaxTimes > 64 || PuzzleLevel.Size > KPuzzleMaxSize)
+		{
+			cerr << "Paramètres invalides" << endl;
+			return 1;
+		}
+
+		cout << Count << " puzzles " << PuzzleLevel.Size << "x" << PuzzleLevel.Size << ", " << PuzzleLevel.NbCandies
+			 << " numéros, " << PuzzleLevel.MaxTimes << " coups, meilleur score entre " << MinScore << " et " << MaxScore
+			 << ", " << NbThreads << " threads" << endl;
+
+		const chrono::steady_clock::time_point Start (chrono::steady_clock::now ());
+		atomic <unsigned> Accepted (0);
+		atomic <uint64_t> Tried (0);
+		vector <vector <CPuzzle> > Found (NbThreads);
+		vector <uint64_t> NbTried (NbThreads, 0), NbOverBudget (NbThreads, 0), NbExact (NbThreads, 0);
+		vector <thread> Threads;
+		const uint32_t Seed (time (NULL));
+		for (unsigned t (0); t < NbThreads; ++t)
+			Threads.push_back (thread ([&, t] { GeneratePuzzles (PuzzleLevel, Count, MinScore, MaxScore, Seed + t * 2654435761u,
+																 Accepted, Tried, Found [t], NbTried [t], NbOverBudget [t], NbExact [t]); }));
+		for (thread & Thread : Threads) Thread.join ();
+		const double Seconds (ElapsedNs (Start) / 1e9);
+
+		unsigned NbFound (0);
+		for (const vector <CPuzzle> & Puzzles : Found) NbFound += Puzzles.size ();
+		if (NbFound < Count)
+			cerr << "Seulement " << NbFound << " puzzles trouvés : élargir la fourchette ou réduire le nombre de coups" << endl;
+
+		/* Écriture du recueil, un puzzle après l'autre dans l'ordre des threads */
+		ofstream File (Path, ios::binary | ios::trunc);
+		const uint32_t Header [5] = {KPuzzleVersion, PuzzleLevel.Size, PuzzleLevel.NbCandies, PuzzleLevel.MaxTimes, NbFound};
+		File.write ("KCPZ", 4);
+		File.write (reinterpret_cast <const char *> (Header), sizeof (Header));
+
+		vector <uint8_t> Bytes (PuzzleBytes (PuzzleLevel));
+		const unsigned Size (PuzzleLevel.Size);
+		for (const vector <CPuzzle> & Puzzles : Found)
+			for (const CPuzzle & Puzzle : Puzzles)
+			{
+				fill (Bytes.begin (), Bytes.end (), 0);
+				Bytes [0] = Puzzle.Best & 0xFF;
+				Bytes [1] = Puzzle.Best >> 8;
+				Bytes [2] = Puzzle.Exact;
+				for (unsigned m (0); m < PuzzleLevel.MaxTimes; ++m)
+					Bytes [3 + m] = m >= Puzzle.Solution.size () ? 0xFF
+								  : (Puzzle.Solution [m].Pos.first * Size + Puzzle.Solution [m].Pos.second)
+									| (Puzzle.Solution [m].Direction == KeyDown ? 0x80 : 0);
+				for (unsigned c (0); c < Size * Size; ++c)
+					Bytes [3 + PuzzleLevel.MaxTimes + c / 2] |= Puzzle.Grid [c / Size][c % Size] << (c % 2 * 4);
+				File.write (reinterpret_cast <const char *> (Bytes.data ()), Bytes.size ());
+			}
+		File.close ();
+
+		uint64_t Searched (0), OverBudget (0), Exact (0);
+		for (unsigned t (0); t < NbThreads; ++t)
+		{
+			Searched += NbTried [t];
+			OverBudget += NbOverBudget [t];
+			Exact += NbExact [t];
+		}
+		cout << Searched << " grilles cherchées (" << OverBudget << " au-delà de " << KPuzzleBudget << " positions) en "
+			 << fixed << setprecision (1) << Seconds << " s : " << setprecision (0) << NbFound / Seconds * 3600 << " puzzles/heure, "
+			 << Searched / Seconds << " grilles/s" << endl;
+		cout.unsetf (ios::floatfield);
+		if (Exact < NbFound)
+			cout << NbFound - Exact << " puzzles sur " << NbFound << " trop grands pour une recherche exhaustive : leur score est "
+				 << "un score à atteindre, pas le meilleur possible" << endl;
+
+		if (! File)
+		{
+			cerr << "Erreur d'écriture dans " << Path << endl;
+			return 1;
+		}
+		return NbFound == Count ? 0 : 1;
+
+	} // RunPuzzleGenerator ()
+
+    /**
+    *@brief Check if the number is in column or row in a cin
+    *@param Result check if the input isn't superior than grid's size
+    *@param Grid the game's grid
+    *@param Invite An invit before the cin
+    */
+	void SaisieLigneCol (unsigned & Result, const CMat & Grid, const string & Invite)
+	{
+		SaisieCin (Result, "Erreur de saisie", Invite);
+		while (! cin.eof () && (Result < 1 || Result >= Grid.size () + 1)) // Vérifie que le numéro de ligne ou colonne se trouve bien dans la grille
+		{
+			cout << "Numéro invalide" << endl;
+			SaisieCin (Result, "Erreur de saisie", Invite);
+		}
+
+	} // SaisieLigneCol ()
+
+	/*	SAISIE DE PLUSIEURS COUPS
+
+		Une ligne peut contenir plusieurs coups séparés par des ';' (ex : "2 3 z; 4 1 s; 5 5 a"). Elle est découpée sur
+		place, sans copie ni allocation, et entièrement vérifiée avant de jouer : en cas d'erreur, le message indique la
+		colonne fautive. Les coups sont ensuite joués dans l'ordre, sans réafficher la grille entre eux ; chacun est vérifié
+		sur la grille laissée par le précédent, et le premier qui n'est pas possible arrête les suivants. */
+
+	/** @brief Moves typed on one line, waiting to be played */
+	struct CMoveBatch
+	{
+		static const unsigned KCapacity = 32;
+		CMove Moves [KCapacity];
+		unsigned Count = 0;		// Coups de la ligne
+		unsigned Next = 0;		// Prochain coup à jouer
+
+		bool Pending () const { return Next < Count; }
+		void Clear () { Count = Next = 0; }
+	};
+
+	/** @brief Error found in a line of moves : where, and what */
+	struct CParseError
+	{
+		unsigned Column;
+		const char * Message;
+	};
+
+	/**
+    *@brief Reads the moves of a line, without allocating
+    *@param Line the characters of the line, Length of them
+    *@param InputLineFirst true if the moves are typed "line column direction"
+    *@param Size the size of the grid, for the bounds of the numbers
+    *@param IsValidDirection the check of the direction, under the rules of the game
+    *@param Batch receives the moves, Next set to 0
+    *@param Error where and why the line was rejected
+    *@return false if the line is not a valid list of moves
+    */
+	bool ParseMoves (const char * Line, size_t Length, bool InputLineFirst, unsigned Size, bool (* IsValidDirection) (char),
+					 CMoveBatch & Batch, CParseError & Error)
+	{
+		const char * const End (Line + Length);
+		const char * Cursor (Line);
+		auto SkipSpaces = [&] { while (Cursor != End && (*Cursor == ' ' || *Cursor == '\t' || *Cursor == '\r')) ++Cursor; };
+		auto Fail = [&] (const char * Message) { Error = CParseError {unsigned (Cursor - Line), Message}; return false; };
+
+		Batch.Clear ();
+		for (;;)
+		{
+			SkipSpaces ();
+			if (Cursor == End) break;
+			if (Batch.Count == CMoveBatch::KCapacity) return Fail ("trop de coups sur une ligne (32 au plus)");
+
+			unsigned Numbers [2];
+			for (unsigned n (0); n < 2; ++n)
+			{
+				SkipSpaces ();
+				const bool IsLine ((n == 0) == InputLineFirst);
+				if (Cursor == End || *Cursor < '0' || *Cursor > '9')
+					return Fail (IsLine ? "numéro de ligne attendu" : "numéro de colonne attendu");
+
+				const char * const Start (Cursor);
+				unsigned Value (0);
+				while (Cursor != End && *Cursor >= '0' && *Cursor <= '9')
+				{
+					if (Value < 1000) Value = Value * 10 + (*Cursor - '0');
+					++Cursor;
+				}
+				if (Value < 1 || Value > Size)
+				{
+					Cursor = Start;
+					return Fail (IsLine ? "ligne hors de la grille" : "colonne hors de la grille");
+				}
+				Numbers [n] = Value - 1;
+			}
+
+			SkipSpaces ();
+			if (Cursor == End || *Cursor == ';') return Fail ("direction attendue");
+			if (! IsValidDirection (*Cursor) || (Cursor + 1 != End && *(Cursor + 1) != ' ' && *(Cursor + 1) != '\t'
+												&& *(Cursor + 1) != '\r' && *(Cursor + 1) != ';'))
+				return Fail ("direction invalide");
+
+			CMove & Move (Batch.Moves [Batch.Count++]);
+			Move.Pos = InputLineFirst ? make_pair (Numbers [0], Numbers [1]) : make_pair (Numbers [1], Numbers [0]);
+			Move.Direction = *Cursor++;
+
+			SkipSpaces ();
+			if (Cursor == End) break;
+			if (*Cursor != ';') return Fail ("';' attendu entre deux coups");
+			++Cursor;
+		}
+		if (Batch.Count == 0) return Fail ("aucun coup");
+		return true;
+
+	} // ParseMoves ()
+
+	/** @brief Shows the line with a mark under the error */
+	void DisplayParseError (const string & Line, const CParseError & Error)
+	{
+		cout << "  " << Line << endl
+			 << string (Error.Column + 2, ' ') << "^ " << Error.Message << endl;
+
+	} // DisplayParseError ()
+
+    /**
+    *@brief Same as SaisieLigneCol, but the player can also type a command, or whole moves, instead of the number
+    *@param Result the number typed
+    *@param Command the command typed ('u' : annuler, 'r' : rejouer, 'i' : indice, 'm' : coups complets), '\0' if a number was typed
+    *@param Grid the game's grid
+    *@param Invite An invit before the cin
+    *@param Batch receives the moves when whole moves are typed
+    *@param InputLineFirst true if the moves are typed "line column direction"
+    *@param IsValidDirection the check of the direction, under the rules of the game
+    */
+	void SaisieLigneColOuCommande (unsigned & Result, char & Command, const CMat & Grid, const string & Invite, CMoveBatch & Batch,
+								   bool InputLineFirst, bool (* IsValidDirection) (char))
+	{
+		static thread_local string Input;	// Garde sa mémoire d'une saisie à l'autre
+		Command = '\0';
+		for (;;)
+		{
+			cout << Invite;
+			getline (cin, Input);
+			if (cin.eof ()) return;
+
+			const size_t First (Input.find_first_not_of (" \t\r")), Last (Input.find_last_not_of (" \t\r"));
+			if (First == string::npos) continue;
+
+			if (Last == First && (Input [First] == 'u' || Input [First] == 'r' || Input [First] == 'i'))
+			{
+				Command = Input [First];
+				return;
+			}
+
+			/* Un numéro seul : le reste du coup est demandé ensuite, une donnée à la fois */
+			if (Input.find_first_not_of ("0123456789", First) > Last)
+			{
+				Result = Last - First < 9 ? strtoul (Input.c_str () + First, NULL, 10) : 0;
+				if (Result >= 1 && Result < Grid.size () + 1) return;
+				cout << "Numéro invalide" << endl;
+				continue;
+			}
+
+			/* Sinon, un ou plusieurs coups complets */
+			CParseError Error;
+			if (ParseMoves (Input.data (), Input.size (), InputLineFirst, Grid.size (), IsValidDirection, Batch, Error))
+			{
+				Command = 'm';
+				return;
+			}
+			DisplayParseError (Input, Error);
+		}
+
+	} // SaisieLigneColOuCommande ()
+
+	/**
+    *@brief Menu of the variants of the rules, sets CurrentRules
+    */
+	void ChooseRules ()
+	{
+		ClearScreen ();
+		cout << '\t' << "Choisir les règles : " << endl << endl;
+		for (unsigned r (0); r < KRuleSets.size (); ++r)
+			cout << r + 1 << " - " << KRuleSets [r].Name << (r == CurrentRules ? " (actuelles)" : "") << endl;
+		cout << endl;
+
+		unsigned Choix;
+		MenuPrompt (Choix, KRuleSets.size ());
+		CurrentRules = Choix - 1;
+
+	} // ChooseRules ()
+
+	/*	BOUCLE DE JEU
+
+		La boucle de jeu est une coroutine écrite à la main : tout son état tient dans une CSession, et elle ne fait aucune
+		entrée ni sortie. StartPlay la lance jusqu'à sa première attente, celle de l'action du joueur ; ResumePlay lui donne
+		cette action (coup, annulation, indice), la fait avancer jusqu'à l'attente suivante ou jusqu'à la fin de la partie,
+		et rend la main. Ce qu'a fait le pas est décrit par Session.Step, Session.Reshuffled et Session.End, et par les
+		événements des coups si la session a un flux. D'où viennent les actions et ce qui est montré regarde le front-end :
+		le terminal (Game), un script (--script), le serveur ou le jeu de données, qui font avancer des milliers de parties
+		suspendues sur un seul thread. Aucune partie n'a besoin de son propre thread. */
+
+	/** @brief The actions awaited by the game loop */
+	enum CPlayAction : unsigned char { KPlayMove, KPlayUndo, KPlayRedo, KPlayHint };
+
+	/** @brief An action of the player */
+	struct CPlayInput
+	{
+		CPlayAction Action;
+		CMove Move;		// Coup à jouer, pour KPlayMove
+	};
+
+	/** @brief What the last step of the game loop did */
+	enum CStepResult : unsigned char { KStepStarted, KStepPlayed, KStepRejected, KStepUndone, KStepRedone, KStepNothingToUndo,
+									   KStepNothingToRedo, KStepHinted, KStepNoHint };
+
+	/** @brief Why the game is over */
+	enum CGameEnd : unsigned char { KNotOver, KNoMovesLeft, KBlocked, KNoCandiesLeft };
+
+	/** @brief A game and the state of its loop, whatever the front-end */
+	struct CSession
+	{
+		CMat Grid;
+		unsigned Size = 0;
+		unsigned MaxTimes = 0;
+		unsigned NbCandies = 0;
+		unsigned Score = 0;
+		unsigned BestScore = 0;
+		unsigned NbMoves = 0;
+		CRandom Rand {1};	// Tire la grille, puis la mélange quand elle est bloquée
+		CVMatchGroup Groups;	// Formes faites par le dernier coup
+		CRunIndex Index;		// Suites de la grille
+
+		const CRuleSet * Rules = &KRuleSets [0];
+		bool StopWhenBlocked = false;	// Puzzle : la partie finit quand plus aucun coup ne rapporte, au lieu de mélanger la grille
+		CHistory * History = NULL;		// Pour annuler et rejouer les coups, NULL si le front-end ne le permet pas
+		CEventStream * Events = NULL;	// Reçoit les événements des coups, NULL si personne ne les lit
+
+		/* Le dernier pas */
+		CStepResult Step = KStepStarted;
+		CMove Hinted;					// Pour KStepHinted
+		bool Reshuffled = false;		// La grille était bloquée et a été mélangée à la fin du pas
+		CGameEnd End = KNotOver;
+	};
+
+	/**
+    *@brief End of a step : checks whether the game is over, and whether the grid is blocked, before the next action
+    *@param Session the session
+    *@return true if the game awaits an action
+    */
+	bool AwaitAction (CSession & Session)
+	{
+		if (Session.End == KNotOver && Session.NbMoves >= Session.MaxTimes) Session.End = KNoMovesLeft;
+		if (Session.End != KNotOver) return false;
+
+		/* Plus aucun coup ne rapporte de points : on mélange la grille plutôt que de laisser le joueur perdre ses coups */
+		if (! HasScoringMove (*Session.Rules, Session.Index, Session.Grid))
+		{
+			if (Session.StopWhenBlocked)
+				Session.End = KBlocked;
+			else if (! ReshuffleGrid (*Session.Rules, Session.Grid, Session.Rand))
+				Session.End = KNoCandiesLeft;
+			else
+			{
+				Session.Reshuffled = true;
+				Session.Index.Rebuild (Session.Grid);
+				if (Session.History != NULL) Session.History -> Amend (Session.Grid, Session.Score, Session.NbMoves);
+			}
+		}
+		return Session.End == KNotOver;
+
+	} // AwaitAction ()
+
+	/**
+    *@brief Starts the game loop on the grid, the score and the moves of the session
+    *@param Session the session
+    *@return true if the game awaits an action
+    */
+	bool StartPlay (CSession & Session)
+	{
+		Session.Index.Rebuild (Session.Grid);
+		if (Session.History != NULL) Session.History -> Reset (Session.Grid, Session.Score, Session.NbMoves);
+		Session.Step = KStepStarted;
+		Session.Reshuffled = false;
+		Session.End = KNotOver;
+		return AwaitAction (Session);
+
+	} // StartPlay ()
+
+	/**
+    *@brief Resumes the game loop with the action it awaits
+    *@param Session the session
+    *@param Input the action of the player
+    *@return true if the game awaits the next action, false if it is over
+    */
+	bool ResumePlay (CSession & Session, const CPlayInput & Input)
+	{
+		Session.Reshuffled = false;
+		if (Session.End != KNotOver)
+		{
+			Session.Step = KStepRejected;
+			return false;
+		}
+
+		const CRuleSet & Rules (*Session.Rules);
+		switch (Input.Action)
+		{
+			case KPlayMove:
+				if (! IsValidPosition (Session.Grid, Input.Move.Pos) || ! Rules.IsValidDirection (Input.Move.Direction)
+					|| ! Rules.IsValidMove (Session.Grid, Input.Move.Pos, Input.Move.Direction))
+				{
+					Session.Step = KStepRejected;
+					return true;
+				}
+				PlayMove (Rules, Session.Index, Session.Grid, Input.Move.Pos, Input.Move.Direction, Session.Score, Session.Groups,
+						  Session.Events);
+				++Session.NbMoves;
+				if (Session.History != NULL) Session.History -> Push (Session.Grid, Session.Score, Session.NbMoves);
+				Session.Step = KStepPlayed;
+				break;
+
+			case KPlayUndo:
+			case KPlayRedo:
+			{
+				const bool Undo (Input.Action == KPlayUndo);
+				if (Session.History == NULL
+					|| ! (Undo ? Session.History -> Undo (Session.Grid, Session.Score, Session.NbMoves)
+							   : Session.History -> Redo (Session.Grid, Session.Score, Session.NbMoves)))
+				{
+					Session.Step = Undo ? KStepNothingToUndo : KStepNothingToRedo;
+					return true;
+				}
+				Session.Index.Rebuild (Session.Grid);
+				Session.Step = Undo ? KStepUndone : KStepRedone;
+				break;
+			}
+
+			case KPlayHint:
+				Session.Step = Hint (Rules, Session.Index, Session.Grid, Session.Hinted) ? KStepHinted : KStepNoHint;
+				return true;
+		}
+		return AwaitAction (Session);
+
+	} // ResumePlay ()
+
+	/**
+    *@brief Starts a new game in the session
+    *@param Session the session
+    *@param Level the parameters of the level
+    *@param Seed the seed of the grid
+    */
+	void NewSession (CSession & Session, const CLevel & Level, uint32_t Seed)
+	{
+		Session.Rand = CRandom (Seed);
+		Session.Size = Level.Size;
+		Session.MaxTimes = Level.MaxTimes;
+		Session.NbCandies = Level.NbCandies;
+		Session.Score = 0;
+		Session.NbMoves = 0;
+		InitGrid (Session.Grid, Level.Size, Level.NbCandies, Session.Rand);
+		StartPlay (Session);
+
+	} // NewSession ()
+
+	/**
+    *@brief Plays a move in the session, after checking it
+    *@param Session the session
+    *@param Pos the selected cell
+    *@param Direction the direction of the swap
+    *@return false if the move is not valid or if the game is over
+    * When no scoring move is left after the move, the grid is reshuffled
+    */
+	bool PlaySessionMove (CSession & Session, const CPosition & Pos, char Direction)
+	{
+		ResumePlay (Session, CPlayInput {KPlayMove, CMove {Pos, Direction}});
+		return Session.Step == KStepPlayed;
+
+	} // PlaySessionMove ()
+
+	/*	ARCHIVE DES PARTIES
+
+		Une partie tirée d'une graine (nouvelle partie du menu, simulateur --record) se rejoue à l'identique à partir de sa
+		graine, de ses règles, de son niveau et de ses actions : les coups joués, les annulations et les rejeux. L'archive
+		range des millions de parties ainsi, numérotées dans l'ordre d'arrivée et regroupées par blocs de KReplaysPerBlock.
+		Dans un bloc, les parties sont écrites en entiers de longueur variable : la graine par différence avec celle de la
+		partie précédente, chaque coup par différence avec la case du coup précédent. Les octets du bloc passent ensuite par
+		un code de Huffman propre au bloc, de KMaxCodeLength bits au plus pour être décodé par une seule table. Un index à la
+		fin du fichier donne la position de chaque bloc : une partie se lit par son numéro en ne décodant que son bloc, et
+		les blocs se décodent en parallèle. Format (entiers dans l'ordre de la machine) :
+
+			en-tête			"KCRA", version
+			blocs			CReplayBlockHeader, longueurs des codes des 256 octets (4 bits chacune), bits du bloc
+			index			une CReplayBlockEntry par bloc
+			fin				CReplayFooter
+
+		Ajouter des parties reprend le dernier bloc s'il n'est pas plein et le réécrit à la fermeture, avec l'index : une
+		partie par lancement du jeu ne fait pas un bloc par partie. Si l'index ne correspond plus aux blocs (programme tué
+		pendant l'écriture), les blocs sont relus un à un depuis le début, jusqu'au premier bloc abîmé. Le codage des parties
+		sert partout, le fichier de l'archive n'est pas disponible sous Windows. */
+
+	const uint32_t KReplayVersion = 2;
+
+	/** @brief Games in a block, the last block of an archive may hold less */
+	const unsigned KReplaysPerBlock = 1024;
+
+	/** @brief Longest code of the Huffman codes of the blocks */
+	const unsigned KMaxCodeLength = 12;
+
+	/** @brief Archive of the new games of the menu */
+	const string KReplayArchive ("./replays.kcra");
+
+	/** @brief Codes of the actions of a replay : KReplayMove + case * 9 + direction for a move */
+	enum : uint32_t { KReplayUndo, KReplayRedo, KReplayMove };
+
+	/** @brief A recorded game */
+	struct CReplay
+	{
+		uint64_t Id = 0;			// Numéro dans l'archive
+		uint32_t Seed = 0;
+		uint32_t Rules = 0;			// Indice dans KRuleSets
+		CLevel Level {0, 0, 0};
+		uint32_t Score = 0;			// Score à la fin, pour vérifier la relecture
+		vector <uint32_t> Actions;
+	};
+
+	/** @brief Header of a block */
+	struct CReplayBlockHeader
+	{
+		char Magic [4];				// "KCRB"
+		uint32_t NbGames;
+		uint64_t FirstId;
+		uint32_t NbBytes;			// Octets du bloc avant le code de Huffman
+		uint32_t NbCoded;			// Octets après l'en-tête
+		uint32_t Checksum;			// FNV-1a de l'en-tête, ce champ à 0, puis des NbCoded octets
+		uint32_t Reserved;
+	};
+
+	/** @brief Entry of the index */
+	struct CReplayBlockEntry
+	{
+		uint64_t Offset;
+		uint64_t FirstId;
+		uint32_t NbGames;
+		uint32_t NbCoded;
+	};
+
+	/** @brief End of an archive */
+	struct CReplayFooter
+	{
+		uint64_t IndexOffset;
+		uint32_t NbBlocks;
+		uint32_t Checksum;			// FNV-1a de l'index
+		char Magic [4];				// "KCRI"
+		uint32_t Version;
+	};
+
+	/**
+    *@brief FNV-1a hash of bytes
+    *@param Data the bytes
+    *@param Size how many
+    *@param Hash the hash of the bytes before them, to hash several pieces
+    */
+	uint32_t Fnv1a (const void * Data, size_t Size, uint32_t Hash = 2166136261u)
+	{
+		for (size_t i (0); i < Size; ++i)
+			Hash = (Hash ^ static_cast <const uint8_t *> (Data) [i]) * 16777619u;
+		return Hash;
+
+	} // Fnv1a ()
+
+	/**
+    *@brief Checksum of a block of replays : its header, without the checksum, then its coded bytes
+    *@param Header the header of the block
+    *@param Coded the Header.NbCoded bytes after the header
+    */
+	uint32_t ReplayBlockChecksum (CReplayBlockHeader Header, const uint8_t * Coded)
+	{
+		Header.Checksum = 0;
+		return Fnv1a (Coded, Header.NbCoded, Fnv1a (&Header, sizeof (Header)));
+
+	} // ReplayBlockChecksum ()
+
+	/**
+    *@brief Records the last step of a session in its replay
+    *@param Replay the replay
+    *@param Session the session
+    *@param Input the action of the step
+    */
+	void RecordStep (CReplay & Replay, const CSession & Session, const CPlayInput & Input)
+	{
+		if (Session.Step == KStepPlayed)
+		{
+			int Di, Dj;
+			StepOf (Input.Move.Direction, Di, Dj);
+			Replay.Actions.push_back (KReplayMove + (Input.Move.Pos.first * Session.Size + Input.Move.Pos.second) * 9
+									  + (Di + 1) * 3 + Dj + 1);
+		}
+		else if (Session.Step == KStepUndone)
+			Replay.Actions.push_back (KReplayUndo);
+		else if (Session.Step == KStepRedone)
+			Replay.Actions.push_back (KReplayRedo);
+		Replay.Score = Session.Score;
+
+	} // RecordStep ()
+
+	/**
+    *@brief Plays a replay again in a session
+    *@param Replay the replay
+    *@param Session the session
+    *@param History the history of the session, used only when the replay undoes moves
+    *@return false if the replay is not valid, or does not end with its score
+    */
+	bool PlayReplay (const CReplay & Replay, CSession & Session, CHistory & History)
+	{
+		const CLevel & Level (Replay.Level);
+		if (Replay.Rules >= KRuleSets.size () || Level.Size < 3 || Level.Size > 99 || Level.NbCandies < 3 || Level.NbCandies > RealMax)
+			return false;
+
+		const char Directions [9] = { KeyUpLeft, KeyUp, KeyUpRight, KeyLeft, '\0', KeyRight, KeyDownLeft, KeyDown, KeyDownRight };
+		Session.Rules = &KRuleSets [Replay.Rules];
+		Session.History = find (Replay.Actions.begin (), Replay.Actions.end (), uint32_t (KReplayUndo)) != Replay.Actions.end ()
+						  ? &History : NULL;
+		NewSession (Session, Level, Replay.Seed);
+
+		for (uint32_t Action : Replay.Actions)
+		{
+			CPlayInput Input {Action == KReplayUndo ? KPlayUndo : Action == KReplayRedo ? KPlayRedo : KPlayMove, CMove ()};
+			if (Action >= KReplayMove)
+			{
+				const uint32_t Cell ((Action - KReplayMove) / 9);
+				if (Cell >= Level.Size * Level.Size) return false;
+				Input.Move = CMove {make_pair (Cell / Level.Size, Cell % Level.Size), Directions [(Action - KReplayMove) % 9]};
+			}
+			ResumePlay (Session, Input);
+			if (Session.Step != (Action == KReplayUndo ? KStepUndone : Action == KReplayRedo ? KStepRedone : KStepPlayed))
+				return false;
+		}
+		return Session.Score == Replay.Score;
+
+	} // PlayReplay ()
+
+	/** @brief Appends an integer in 7 bits bytes, the high bit telling that another byte follows */
+	void PutVarint (vector <uint8_t> & Bytes, uint32_t Value)
+	{
+		while (Value >= 0x80)
+		{
+			Bytes.push_back (uint8_t (Value | 0x80));
+			Value >>= 7;
+		}
+		Bytes.push_back (uint8_t (Value));
+
+	} // PutVarint ()
+
+	/** @brief Reads an integer written by PutVarint, false if it goes past End */
+	bool GetVarint (const uint8_t * & Cursor, const uint8_t * End, uint32_t & Value)
+	{
+		Value = 0;
+		for (unsigned Shift (0); Shift < 35 && Cursor != End; Shift += 7)
+		{
+			const uint8_t Byte (*Cursor++);
+			Value |= uint32_t (Byte & 0x7F) << Shift;
+			if (Byte < 0x80) return true;
+		}
+		return false;
+
+	} // GetVarint ()
+
+	/** @brief Small differences, positive or negative, as small integers : 0, -1, 1, -2, 2... */
+	inline uint32_t ZigZag (int32_t Value) { return (uint32_t (Value) << 1) ^ uint32_t (Value >> 31); }
+
+	inline int32_t UnZigZag (uint32_t Value) { return int32_t (Value >> 1) ^ - int32_t (Value & 1); }
+
+	/**
+    *@brief Computes the lengths of a Huffman code of the bytes, none above KMaxCodeLength
+    *@param Counts how many times each byte is found
+    *@param Lengths the length of the code of each byte, 0 for the bytes not found
+    * When a code is too long, the counts are flattened and the code built again
+    */
+	void HuffmanLengths (const uint32_t * Counts, uint8_t * Lengths)
+	{
+		uint32_t Weights [256];
+		copy (Counts, Counts + 256, Weights);
+		for (;;)
+		{
+			vector <pair <uint64_t, unsigned>> Heap;
+			int Parents [511];
+			unsigned NbNodes (256);
+			for (unsigned s (0); s < 256; ++s)
+				if (Weights [s] != 0) Heap.push_back (make_pair (uint64_t (Weights [s]), s));
+			memset (Lengths, 0, 256);
+			if (Heap.size () == 1) Lengths [Heap [0].second] = 1;
+			if (Heap.size () <= 1) return;
+
+			/* Les deux nœuds les plus légers sont réunis tant qu'il en reste plusieurs */
+			make_heap (Heap.begin (), Heap.end (), greater <pair <uint64_t, unsigned>> ());
+			while (Heap.size () > 1)
+			{
+				pop_heap (Heap.begin (), Heap.end (), greater <pair <uint64_t, unsigned>> ());
+				const pair <uint64_t, unsigned> First (Heap.back ());
+				Heap.pop_back ();
+				pop_heap (Heap.begin (), Heap.end (), greater <pair <uint64_t, unsigned>> ());
+				const pair <uint64_t, unsigned> Second (Heap.back ());
+				Heap.pop_back ();
+				Parents [First.second] = Parents [Second.second] = NbNodes;
+				Heap.push_back (make_pair (First.first + Second.first, NbNodes++));
+				push_heap (Heap.begin (), Heap.end (), greater <pair <uint64_t, unsigned>> ());
+			}
+
+			unsigned Longest (0);
+			for (unsigned s (0); s < 256; ++s)
+				if (Weights [s] != 0)
+				{
+					unsigned Length (0);
+					for (unsigned Node (s); Node != NbNodes - 1; Node = Parents [Node]) ++Length;
+					Lengths [s] = uint8_t (min (Length, 255u));
+					Longest = max (Longest, Length);
+				}
+			if (Longest <= KMaxCodeLength) return;
+
+			for (uint32_t & Weight : Weights)
+				if (Weight != 0) Weight = Weight / 2 + 1;
+		}
+
+	} // HuffmanLengths ()
+
+	/**
+    *@brief Canonical codes of the lengths : codes of the same length follow each other in the order of the bytes
+    *@param Lengths the length of the code of each byte
+    *@param Codes the code of each byte
+    */
+	void HuffmanCodes (const uint8_t * Lengths, uint16_t * Codes)
+	{
+		unsigned Code (0);
+		for (unsigned Length (1); Length <= KMaxCodeLength; ++Length, Code <<= 1)
+			for (unsigned s (0); s < 256; ++s)
+				if (Lengths [s] == Length) Codes [s] = Code++;
+
+	} // HuffmanCodes ()
+
+	/**
+    *@brief Writes a block of games
+    *@param Games the games, numbered from FirstId
+    *@param Block the block : header, lengths of the codes, then bits
+    *@param Bytes buffer of the bytes before the Huffman code
+    */
+	void EncodeReplayBlock (const vector <CReplay> & Games, vector <uint8_t> & Block, vector <uint8_t> & Bytes)
+	{
+		Bytes.clear ();
+		uint32_t PreviousSeed (0);
+		for (const CReplay & Replay : Games)
+		{
+			PutVarint (Bytes, ZigZag (int32_t (Replay.Seed - PreviousSeed)));
+			PreviousSeed = Replay.Seed;
+			for (uint32_t Value : {Replay.Rules, Replay.Level.Size, Replay.Level.MaxTimes, Replay.Level.NbCandies, Replay.Score,
+								   uint32_t (Replay.Actions.size ())})
+				PutVarint (Bytes, Value);
+
+			int32_t PreviousCell (0);
+			for (uint32_t Action : Replay.Actions)
+			{
+				if (Action < KReplayMove)
+				{
+					PutVarint (Bytes, Action);
+					continue;
+				}
+				const int32_t Cell ((Action - KReplayMove) / 9);
+				PutVarint (Bytes, KReplayMove + ZigZag (Cell - PreviousCell) * 9 + (Action - KReplayMove) % 9);
+				PreviousCell = Cell;
+			}
+		}
+
+		uint32_t Counts [256] = {0};
+		uint8_t Lengths [256];
+		uint16_t Codes [256];
+		for (uint8_t Byte : Bytes) ++Counts [Byte];
+		HuffmanLengths (Counts, Lengths);
+		HuffmanCodes (Lengths, Codes);
+
+		Block.assign (sizeof (CReplayBlockHeader), 0);
+		for (unsigned s (0); s < 256; s += 2)
+			Block.push_back (uint8_t (Lengths [s] << 4 | Lengths [s + 1]));
+		uint64_t Bits (0);
+		unsigned NbBits (0);
+		for (uint8_t Byte : Bytes)
+		{
+			Bits = Bits << Lengths [Byte] | Codes [Byte];
+			for (NbBits += Lengths [Byte]; NbBits >= 8; NbBits -= 8)
+				Block.push_back (uint8_t (Bits >> (NbBits - 8)));
+		}
+		if (NbBits != 0) Block.push_back (uint8_t (Bits << (8 - NbBits)));
+
+		CReplayBlockHeader Header;
+		memcpy (Header.Magic, "KCRB", 4);
+		Header.NbGames = Games.size ();
+		Header.FirstId = Games.empty () ? 0 : Games [0].Id;
+		Header.NbBytes = Bytes.size ();
+		Header.NbCoded = Block.size () - sizeof (Header);
+		Header.Reserved = 0;
+		Header.Checksum = ReplayBlockChecksum (Header, Block.data () + sizeof (Header));
+		memcpy (Block.data (), &Header, sizeof (Header));
+
+	} // EncodeReplayBlock ()
+
+	/**
+    *@brief Reads a block of games, checking everything
+    *@param Block the block (its header, then Header.NbCoded bytes)
+    *@param Size the size of the block
+    *@param Games the games of the block, their memory is reused
+    *@param Bytes buffer of the bytes before the Huffman code
+    */
+	bool DecodeReplayBlock (const uint8_t * Block, size_t Size, vector <CReplay> & Games, vector <uint8_t> & Bytes)
+	{
+		CReplayBlockHeader Header;
+		if (Size < sizeof (Header) + 128) return false;
+		memcpy (&Header, Block, sizeof (Header));
+		/* Chaque octet coûte au moins un bit : NbBytes ne peut dépasser les bits après la table des codes */
+		if (memcmp (Header.Magic, "KCRB", 4) || Header.NbCoded != Size - sizeof (Header) || Header.NbGames > KReplaysPerBlock
+			|| Header.NbBytes > 8 * uint64_t (Header.NbCoded - 128) || Header.Checksum != ReplayBlockChecksum (Header, Block + sizeof (Header)))
+			return false;
+		const uint8_t * Coded (Block + sizeof (Header));
+		const uint8_t * const End (Block + Size);
+
+		/* Table des codes : les KMaxCodeLength prochains bits donnent l'octet et la longueur de son code */
+		uint8_t Lengths [256];
+		uint16_t Codes [256];
+		for (unsigned s (0); s < 256; s += 2)
+		{
+			Lengths [s] = Coded [s / 2] >> 4;
+			Lengths [s + 1] = Coded [s / 2] & 15;
+		}
+		Coded += 128;
+		uint32_t Kraft (0);
+		for (uint8_t Length : Lengths)
+		{
+			if (Length > KMaxCodeLength) return false;
+			if (Length != 0) Kraft += 1u << (KMaxCodeLength - Length);
+		}
+		if (Kraft > 1u << KMaxCodeLength) return false;
+		HuffmanCodes (Lengths, Codes);
+		static thread_local array <uint16_t, 1u << KMaxCodeLength> Table;
+		Table.fill (0);
+		for (unsigned s (0); s < 256; ++s)
+			if (Lengths [s] != 0)
+			{
+				const unsigned Shift (KMaxCodeLength - Lengths [s]);
+				fill (Table.begin () + (Codes [s] << Shift), Table.begin () + ((Codes [s] + 1) << Shift), uint16_t (Lengths [s] << 8 | s));
+			}
+
+		Bytes.resize (Header.NbBytes);
+		uint64_t Bits (0), NbLeft (uint64_t (End - Coded) * 8);	// Les bits du bloc pas encore décodés, sans les 0 ajoutés après
+		unsigned NbBits (0);
+		for (uint32_t n (0); n < Header.NbBytes; ++n)
+		{
+			while (NbBits <= 56)
+			{
+				Bits = Bits << 8 | (Coded != End ? *Coded++ : 0);
+				NbBits += 8;
+			}
+			const uint16_t Entry (Table [(Bits >> (NbBits - KMaxCodeLength)) & ((1u << KMaxCodeLength) - 1)]);
+			if (Entry == 0 || unsigned (Entry >> 8) > NbLeft) return false;
+			Bytes [n] = uint8_t (Entry);
+			NbBits -= Entry >> 8;
+			NbLeft -= Entry >> 8;
+		}
+
+		/* Les parties */
+		Games.resize (Header.NbGames);
+		const uint8_t * Cursor (Bytes.data ());
+		const uint8_t * const BytesEnd (Bytes.data () + Bytes.size ());
+		uint32_t Seed (0);
+		for (uint32_t g (0); g < Header.NbGames; ++g)
+		{
+			CReplay & Replay (Games [g]);
+			uint32_t Delta, NbActions;
+			if (! GetVarint (Cursor, BytesEnd, Delta) || ! GetVarint (Cursor, BytesEnd, Replay.Rules)
+				|| ! GetVarint (Cursor, BytesEnd, Replay.Level.Size) || ! GetVarint (Cursor, BytesEnd, Replay.Level.MaxTimes)
+				|| ! GetVarint (Cursor, BytesEnd, Replay.Level.NbCandies) || ! GetVarint (Cursor, BytesEnd, Replay.Score)
+				|| ! GetVarint (Cursor, BytesEnd, NbActions) || NbActions > size_t (BytesEnd - Cursor))
+				return false;
+			Seed += uint32_t (UnZigZag (Delta));
+			Replay.Id = Header.FirstId + g;
+			Replay.Seed = Seed;
+
+			Replay.Actions.resize (NbActions);
+			int64_t Cell (0);
+			for (uint32_t & Action : Replay.Actions)
+			{
+				if (! GetVarint (Cursor, BytesEnd, Action)) return false;
+				if (Action < KReplayMove) continue;
+				Cell += UnZigZag ((Action - KReplayMove) / 9);
+				if (Cell < 0 || Cell >= 99 * 99) return false;
+				Action = KReplayMove + uint32_t (Cell) * 9 + (Action - KReplayMove) % 9;
+			}
+		}
+		return Cursor == BytesEnd;
+
+	} // DecodeReplayBlock ()
+
+#ifndef _WIN32
+
+	/** @brief An archive of replays, opened to read or to append */
+	class CReplayArchive
+	{
+		int File = -1;
+		bool Writing = false;
+		vector <CReplayBlockEntry> Index;
+		vector <CReplay> Tail;			// Parties pas encore écrites : le dernier bloc, pas plein
+		uint64_t TailOffset = 0;		// Où écrire le prochain bloc
+		uint64_t NbGames = 0;
+		vector <uint8_t> Block, Bytes;
+
+		/** @brief Reads the index from the end of the file, false if it does not match the blocks */
+		bool ReadIndex (uint64_t FileSize)
+		{
+			CReplayFooter Footer;
+			if (FileSize < 8 + sizeof (Footer) || pread (File, &Footer, sizeof (Footer), FileSize - sizeof (Footer)) != ssize_t (sizeof (Footer))
+				|| memcmp (Footer.Magic, "KCRI", 4) || Footer.Version != KReplayVersion
+				|| Footer.IndexOffset + uint64_t (Footer.NbBlocks) * sizeof (CReplayBlockEntry) + sizeof (Footer) != FileSize)
+				return false;
+			Index.resize (Footer.NbBlocks);
+			const ssize_t Length (Index.size () * sizeof (CReplayBlockEntry));
+			if (pread (File, Index.data (), Length, Footer.IndexOffset) != Length || Fnv1a (Index.data (), Length) != Footer.Checksum)
+				return false;
+
+			/* Chaque bloc doit être celui que décrit l'index */
+			uint64_t Offset (8), Id (0);
+			for (const CReplayBlockEntry & Entry : Index)
+			{
+				CReplayBlockHeader Header;
+				if (Entry.Offset != Offset || Entry.FirstId != Id
+					|| pread (File, &Header, sizeof (Header), Offset) != ssize_t (sizeof (Header)) || memcmp (Header.Magic, "KCRB", 4)
+					|| Header.FirstId != Id || Header.NbGames != Entry.NbGames || Header.NbCoded != Entry.NbCoded)
+					return false;
+				Offset += sizeof (Header) + Entry.NbCoded;
+				Id += Entry.NbGames;
+			}
+			return Offset == Footer.IndexOffset;
+		}
+
+		/** @brief Rebuilds the index from the blocks, up to the first one damaged */
+		void ScanBlocks (uint64_t FileSize)
+		{
+			Index.clear ();
+			uint64_t Offset (8), Id (0);
+			CReplayBlockHeader Header;
+			while (Offset + sizeof (Header) <= FileSize && pread (File, &Header, sizeof (Header), Offset) == ssize_t (sizeof (Header))
+				   && ! memcmp (Header.Magic, "KCRB", 4) && Header.FirstId == Id && Offset + sizeof (Header) + Header.NbCoded <= FileSize)
+			{
+				Block.resize (Header.NbCoded);
+				if (pread (File, Block.data (), Block.size (), Offset + sizeof (Header)) != ssize_t (Block.size ())
+					|| ReplayBlockChecksum (Header, Block.data ()) != Header.Checksum)
+					break;
+				Index.push_back (CReplayBlockEntry {Offset, Id, Header.NbGames, Header.NbCoded});
+				Offset += sizeof (Header) + Header.NbCoded;
+				Id += Header.NbGames;
+			}
+		}
+
+		/** @brief Writes the games of Tail as a block at TailOffset */
+		bool WriteTail ()
+		{
+			EncodeReplayBlock (Tail, Block, Bytes);
+			if (pwrite (File, Block.data (), Block.size (), TailOffset) != ssize_t (Block.size ())) return false;
+			Index.push_back (CReplayBlockEntry {TailOffset, Tail [0].Id, uint32_t (Tail.size ()), uint32_t (Block.size () - sizeof (CReplayBlockHeader))});
+			TailOffset += Block.size ();
+			Tail.clear ();
+			return true;
+		}
+
+	  public:
+		~CReplayArchive () { Close (); }
+
+		/**
+		*@brief Opens an archive
+		*@param Path the file
+		*@param Append true to add games, the archive is created if needed
+		*/
+		bool Open (const string & Path, bool Append)
+		{
+			Close ();
+			File = open (Path.c_str (), Append ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+			if (File < 0) return false;
+			Writing = Append;
+
+			struct stat Status;
+			fstat (File, &Status);
+			char Magic [8] = {0};
+			const uint32_t Version (KReplayVersion);
+			if (Status.st_size == 0 && Append)
+			{
+				memcpy (Magic, "KCRA", 4);
+				memcpy (Magic + 4, &Version, 4);
+				if (pwrite (File, Magic, 8, 0) != 8) return false;
+			}
+			else if (pread (File, Magic, 8, 0) != 8 || memcmp (Magic, "KCRA", 4) || memcmp (Magic + 4, &Version, 4))
+			{
+				close (File);
+				File = -1;
+				return false;
+			}
+			if (! ReadIndex (Status.st_size)) ScanBlocks (Status.st_size);
+
+			NbGames = Index.empty () ? 0 : Index.back ().FirstId + Index.back ().NbGames;
+			TailOffset = Index.empty () ? 8 : Index.back ().Offset + sizeof (CReplayBlockHeader) + Index.back ().NbCoded;
+
+			/* Le dernier bloc, pas plein, sera réécrit avec les parties suivantes */
+			if (Append && ! Index.empty () && Index.back ().NbGames < KReplaysPerBlock)
+			{
+				const unsigned Last (Index.size () - 1);
+				if (! ReadBlock (Last, Tail)) Tail.clear ();
+				TailOffset = Index.back ().Offset;
+				NbGames = Index.back ().FirstId + Tail.size ();
+				Index.pop_back ();
+			}
+			return true;
+		}
+
+		/** @brief Appends a game, numbered after the others */
+		bool Append (CReplay & Replay)
+		{
+			if (! Writing) return false;
+			Replay.Id = NbGames++;
+			Tail.push_back (Replay);
+			return Tail.size () < KReplaysPerBlock || WriteTail ();
+		}
+
+		/** @brief Writes the last block and the index, then closes the file */
+		bool Close ()
+		{
+			if (File < 0) return true;
+			bool Written (true);
+			if (Writing)
+			{
+				CReplayFooter Footer;
+				if (! Tail.empty ()) Written = WriteTail ();
+				Footer.IndexOffset = TailOffset;
+				Footer.NbBlocks = Index.size ();
+				Footer.Checksum = Fnv1a (Index.data (), Index.size () * sizeof (CReplayBlockEntry));
+				memcpy (Footer.Magic, "KCRI", 4);
+				Footer.Version = KReplayVersion;
+				const ssize_t Length (Index.size () * sizeof (CReplayBlockEntry));
+				Written = Written && pwrite (File, Index.data (), Length, TailOffset) == Length
+						  && pwrite (File, &Footer, sizeof (Footer), TailOffset + Length) == ssize_t (sizeof (Footer))
+						  && ftruncate (File, TailOffset + Length + sizeof (Footer)) == 0;
+			}
+			close (File);
+			File = -1;
+			Index.clear ();
+			Tail.clear ();
+			return Written;
+		}
+
+		/** @brief How many games, including those not written yet */
+		uint64_t Size () const { return NbGames; }
+
+		unsigned NbBlocks () const { return Index.size (); }
+
+		const CReplayBlockEntry & Entry (unsigned b) const { return Index [b]; }
+
+		/**
+		*@brief Reads and decodes a block, from any thread
+		*@param b the number of the block
+		*@param Games its games
+		*/
+		bool ReadBlock (unsigned b, vector <CReplay> & Games) const
+		{
+			static thread_local vector <uint8_t> Data, Buffer;
+			Data.resize (sizeof (CReplayBlockHeader) + Index [b].NbCoded);
+			return pread (File, Data.data (), Data.size (), Index [b].Offset) == ssize_t (Data.size ())
+				   && DecodeReplayBlock (Data.data (), Data.size (), Games, Buffer) && Games.size () == Index [b].NbGames;
+		}
+
+		/**
+		*@brief Finds a game by its number, decoding only its block
+		*@param Id the number
+		*@param Replay the game
+		*/
+		bool Find (uint64_t Id, CReplay & Replay) const
+		{
+			const auto Found (upper_bound (Index.begin (), Index.end (), Id,
+										   [] (uint64_t Value, const CReplayBlockEntry & Entry) { return Value < Entry.FirstId; }));
+			if (Found == Index.begin ()) return false;
+			const unsigned b (Found - Index.begin () - 1);
+			static thread_local vector <CReplay> Games;
+			if (Id >= Index [b].FirstId + Index [b].NbGames || ! ReadBlock (b, Games)) return false;
+			Replay = Games [Id - Index [b].FirstId];
+			return true;
+		}
+	};
+
+	/**
+    *@brief Appends a game to an archive, opened for this game only
+    *@param Path the archive
+    *@param Replay the game
+    */
+	bool ArchiveReplay (const string & Path, CReplay & Replay)
+	{
+		CReplayArchive Archive;
+		return Archive.Open (Path, true) && Archive.Append (Replay) && Archive.Close ();
+
+	} // ArchiveReplay ()
+
+	/**
+    *@brief Shows a game of an archive and plays it again (mode --replay)
+    *@param Path the archive
+    *@param Id the number of the game
+    */
+	int RunReplay (const string & Path, uint64_t Id)
+	{
+		CReplayArchive Archive;
+		CReplay Replay;
+		if (! Archive.Open (Path, false))
+		{
+			cerr << Path << " : archive illisible" << endl;
+			return 1;
+		}
+		if (! Archive.Find (Id, Replay))
+		{
+			cerr << Path << " : pas de partie " << Id << " (" << Archive.Size () << " parties)" << endl;
+			return 1;
+		}
+		cout << "Partie " << Id << " : graine " << Replay.Seed << ", règles "
+			 << (Replay.Rules < KRuleSets.size () ? KRuleSets [Replay.Rules].Id : "inconnues") << ", grille " << Replay.Level.Size
+			 << 'x' << Replay.Level.Size << ", " << Replay.Level.MaxTimes << " coups, " << Replay.Level.NbCandies << " numéros, score "
+			 << Replay.Score << endl << "Actions :";
+		const char Directions [9] = { KeyUpLeft, KeyUp, KeyUpRight, KeyLeft, '?', KeyRight, KeyDownLeft, KeyDown, KeyDownRight };
+		for (uint32_t Action : Replay.Actions)
+			if (Action == KReplayUndo)
+				cout << " u;";
+			else if (Action == KReplayRedo)
+				cout << " r;";
+			else
+				cout << ' ' << (Action - KReplayMove) / 9 / max (1u, Replay.Level.Size) + 1 << ' '
+					 << (Action - KReplayMove) / 9 % max (1u, Replay.Level.Size) + 1 << ' ' << Directions [(Action - KReplayMove) % 9] << ';';
+		cout << endl;
+
+		CSession Session;
+		CHistory History (1u << 30, size_t (1) << 40);	// Sans limite : une annulation enregistrée a réussi
+		const bool Same (PlayReplay (Replay, Session, History));
+		cout << "Rejouée : score " << Session.Score << (Same ? ", le même" : ", différent de celui enregistré") << endl;
+		for (const CVLine & Row : Session.Grid)
+		{
+			for (unsigned Cell : Row) cout << ' ' << Cell;
+			cout << endl;
+		}
+		return Same ? 0 : 1;
+
+	} // RunReplay ()
+
+	/**
+    *@brief Decodes every block of an archive on every core, and plays each game again if asked (mode --replays)
+    *@param Path the archive
+    *@param NbThreads how many threads, 0 for one per core
+    *@param Check true to play the games again and check their scores
+    */
+	int RunReplays (const string & Path, unsigned NbThreads, bool Check)
+	{
+		CReplayArchive Archive;
+		if (! Archive.Open (Path, false))
+		{
+			cerr << Path << " : archive illisible" << endl;
+			return 1;
+		}
+		if (NbThreads == 0) NbThreads = max (1u, thread::hardware_concurrency ());
+
+		atomic <unsigned> NextBlock (0);
+		atomic <uint64_t> NbGames (0), NbActions (0), NbFailed (0), Bytes (0);
+		const chrono::steady_clock::time_point Start (chrono::steady_clock::now ());
+		vector <thread> Threads;
+		for (unsigned t (0); t < NbThreads; ++t)
+			Threads.push_back (thread ([&]
+			{
+				vector <CReplay> Games;
+				CSession Session;
+				CHistory History (1u << 30, size_t (1) << 40);	// Sans limite : une annulation enregistrée a réussi
+				for (unsigned b; (b = NextBlock++) < Archive.NbBlocks ();)
+				{
+					Bytes += sizeof (CReplayBlockHeader) + Archive.Entry (b).NbCoded;
+					if (! Archive.ReadBlock (b, Games))
+					{
+						NbFailed += Archive.Entry (b).NbGames;
+						continue;
+					}
+					uint64_t Actions (0), Failed (0);
+					for (const CReplay & Replay : Games)
+					{
+						Actions += Replay.Actions.size ();
+						if (Check && ! PlayReplay (Replay, Session, History)) ++Failed;
+					}
+					NbGames += Games.size ();
+					NbActions += Actions;
+					NbFailed += Failed;
+				}
+			}));
+		for (thread & Thread : Threads) Thread.join ();
+
+		const double Seconds (ElapsedNs (Start) / 1e9);
+		cout << NbGames << " parties, " << NbActions << " actions, " << Archive.NbBlocks () << " blocs, " << fixed << setprecision (2)
+			 << (NbActions ? double (Bytes) / NbActions : 0.) << " octets par action" << endl
+			 << (Check ? "Rejouées" : "Décodées") << " sur " << NbThreads << " threads : " << setprecision (0) << NbGames / Seconds * 60
+			 << " parties/min" << endl;
+		if (NbFailed != 0)
+		{
+			cerr << NbFailed << (Check ? " parties illisibles ou rejouées différemment" : " parties illisibles") << endl;
+			return 1;
+		}
+		return 0;
+
+	} // RunReplays ()
+
+	/*	DIFFUSION AUX SPECTATEURS
+
+		Avec --broadcast <fichier>, les parties publient leur état dans un anneau d'images en mémoire partagée : le fichier
+		(de préférence dans /dev/shm) est projeté en mémoire par la partie et par chaque spectateur (--watch <fichier>).
+		Il n'y a qu'un écrivain et il ne lit jamais rien des lecteurs : publier une image coûte la même chose qu'il y ait
+		zéro ou cent spectateurs, et un lecteur lent ne ralentit personne, il perd des images.
+
+		Chaque case de l'anneau porte un numéro de séquence (seqlock) : impair pendant l'écriture de l'image n, puis
+		2 n + 2. Un lecteur recopie l'image et relit le numéro : s'il a changé, l'image a été écrasée pendant la copie et
+		elle est perdue. Après une perte, il attend la prochaine image complète : il y en a une au début de chaque partie,
+		après un mélange, une annulation ou un coup rejoué, et toutes les KKeyFrameInterval images. Les autres images ne
+		contiennent que les cases changées par le coup, avec le score, les coups restants et le coup joué. */
+
+	const uint32_t KBroadcastVersion = 1;
+	const unsigned KBroadcastSlots = 256;
+	const unsigned KFrameBytes = 2048;		// Une image complète contient une case par octet : grilles jusqu'à 45x45
+	const unsigned KKeyFrameInterval = 16;
+
+	enum CFrameKind : uint8_t { KFrameKey, KFrameDelta, KFrameEnd };
+
+	/** @brief An image of the game broadcast to the spectators */
+	struct CFrame
+	{
+		uint32_t Game;			// Numéro de la partie diffusée
+		uint32_t Score;
+		uint32_t Points;		// Points du dernier coup
+		uint16_t Size;
+		uint16_t NbMoves;
+		uint16_t MaxTimes;
+		uint16_t NbCells;		// Image complète : Size * Size cases ; image partielle : nombre de cases changées
+		uint16_t MoveRow;		// Dernier coup joué, si MoveDirection n'est pas '\0'
+		uint16_t MoveColumn;
+		char MoveDirection;
+		CFrameKind Kind;
+		uint8_t Cells [KFrameBytes];	// Complète : les cases ligne après ligne ; partielle : (indice sur 2 octets, valeur)
+	};
+
+	/** @brief A slot of the ring */
+	struct CFrameSlot
+	{
+		atomic <uint64_t> Sequence;
+		CFrame Frame;
+	};
+
+	/** @brief The shared file */
+	struct CBroadcastRing
+	{
+		char Magic [4];
+		uint32_t Version;
+		uint32_t NbSlots;
+		uint32_t SlotBytes;
+		atomic <uint64_t> Head;		// Nombre d'images publiées
+		CFrameSlot Slots [KBroadcastSlots];
+	};
+
+	static_assert (ATOMIC_LLONG_LOCK_FREE == 2, "the ring needs lock-free 64 bit atomics to be shared between processes");
+
+	/** @brief Number of bytes of a frame that are copied */
+	inline size_t FrameBytes (const CFrame & Frame)
+	{
+		return offsetof (CFrame, Cells) + (Frame.Kind == KFrameDelta ? 3 * Frame.NbCells : Frame.Kind == KFrameKey ? Frame.NbCells : 0);
+
+	} // FrameBytes ()
+
+	/** @brief The writer of the ring : the game being played */
+	class CBroadcaster
+	{
+		CBroadcastRing * Ring;
+		CMat Last;				// Grille de la dernière image publiée
+		uint32_t Game;
+		unsigned SinceKey;		// Images partielles depuis la dernière image complète
+		CFrame Frame;
+
+		void Write ()
+		{
+			const uint64_t Number (Ring -> Head.load (memory_order_relaxed));
+			CFrameSlot & Slot (Ring -> Slots [Number % KBroadcastSlots]);
+			Slot.Sequence.store (2 * Number + 1, memory_order_relaxed);
+			atomic_thread_fence (memory_order_release);
+			memcpy (&Slot.Frame, &Frame, FrameBytes (Frame));
+			Slot.Sequence.store (2 * Number + 2, memory_order_release);
+			Ring -> Head.store (Number + 1, memory_order_release);
+		}
+
+	  public:
+		CBroadcaster () : Ring (NULL), Game (0), SinceKey (0) {}
+		~CBroadcaster () { if (Ring != NULL) munmap (Ring, sizeof (CBroadcastRing)); }
+
+		/**
+		*@brief Creates the ring, or takes over an existing one : the spectators already attached keep watching
+		*@param Path the shared file
+		*/
+		bool Open (const string & Path)
+		{
+			const int Fd (open (Path.c_str (), O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+			if (Fd < 0) return false;
+			void * Map (ftruncate (Fd, sizeof (CBroadcastRing)) == 0
+						? mmap (NULL, sizeof (CBroadcastRing), PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0) : MAP_FAILED);
+			close (Fd);
+			if (Map == MAP_FAILED) return false;
+
+			Ring = static_cast <CBroadcastRing *> (Map);
+			if (memcmp (Ring -> Magic, "KCBC", 4) != 0 || Ring -> Version != KBroadcastVersion)
+			{
+				Ring -> Version = KBroadcastVersion;
+				Ring -> NbSlots = KBroadcastSlots;
+				Ring -> SlotBytes = sizeof (CFrameSlot);
+				Ring -> Head.store (0);
+				memcpy (Ring -> Magic, "KCBC", 4);
+			}
+
+			/* Les parties continuent la numérotation de l'écrivain précédent */
+			const uint64_t Head (Ring -> Head.load ());
+			Game = Head != 0 ? Ring -> Slots [(Head - 1) % KBroadcastSlots].Frame.Game : 0;
+			return true;
+		}
+
+		/**
+		*@brief Publishes the state of the game after a step of its loop
+		*@param Session the game
+		*@param Move the move played by the step, NULL if it did not play one
+		*@param Points the points of that move
+		* The first frame of a game, and the frames after a reshuffle or an undo, are complete
+		*/
+		void Publish (const CSession & Session, const CMove * Move = NULL, unsigned Points = 0)
+		{
+			if (Ring == NULL || Session.Size * Session.Size > KFrameBytes) return;
+
+			if (Session.Step == KStepStarted) ++Game;
+			Frame.Game = Game;
+			Frame.Score = Session.Score;
+			Frame.Points = Points;
+			Frame.Size = Session.Size;
+			Frame.NbMoves = Session.NbMoves;
+			Frame.MaxTimes = Session.MaxTimes;
+			Frame.MoveRow = Move != NULL ? Move -> Pos.first : 0;
+			Frame.MoveColumn = Move != NULL ? Move -> Pos.second : 0;
+			Frame.MoveDirection = Move != NULL ? Move -> Direction : '\0';
+
+			/* Image partielle : les cases qui diffèrent de la dernière image, si elles tiennent dans l'image */
+			const unsigned Size (Session.Size);
+			bool Key (Move == NULL || Session.Reshuffled || Last.size () != Size || ++SinceKey >= KKeyFrameInterval);
+			Frame.Kind = KFrameDelta;
+			Frame.NbCells = 0;
+			for (unsigned c (0); ! Key && c < Size * Size; ++c)
+			{
+				const unsigned Value (Session.Grid [c / Size][c % Size]);
+				if (Value == Last [c / Size][c % Size]) continue;
+				if (3u * (Frame.NbCells + 1u) > KFrameBytes)
+				{
+					Key = true;
+					break;
+				}
+				Frame.Cells [3 * Frame.NbCells] = c & 0xFF;
+				Frame.Cells [3 * Frame.NbCells + 1] = c >> 8;
+				Frame.Cells [3 * Frame.NbCells + 2] = Value;
+				++Frame.NbCells;
+			}
+			if (Key)
+			{
+				Frame.Kind = KFrameKey;
+				Frame.NbCells = Size * Size;
+				for (unsigned c (0); c < Size * Size; ++c)
+					Frame.Cells [c] = Session.Grid [c / Size][c % Size];
+				SinceKey = 0;
+			}
+
+			Last = Session.Grid;
+			Write ();
+		}
+
+		/** @brief Tells the spectators that the game is over */
+		void End (const CSession & Session)
+		{
+			if (Ring == NULL) return;
+			Frame.Kind = KFrameEnd;
+			Frame.Score = Session.Score;
+			Frame.NbMoves = Session.NbMoves;
+			Frame.NbCells = 0;
+			Write ();
+		}
+	};
+
+	/** @brief Broadcast of the games, opened by --broadcast (publishing does nothing until then) */
+	CBroadcaster Broadcast;
+
+	/**
+    *@brief Spectator (mode --watch) : shows the games broadcast in the ring
+    *@param Path the shared file
+    *@param Seconds how long to watch, 0 until the program is stopped
+    */
+	int RunWatch (const string & Path, unsigned Seconds)
+	{
+		const int Fd (open (Path.c_str (), O_RDONLY | O_CLOEXEC));
+		struct stat Status;
+		void * Map (Fd >= 0 && fstat (Fd, &Status) == 0 && Status.st_size >= off_t (sizeof (CBroadcastRing))
+					? mmap (NULL, sizeof (CBroadcastRing), PROT_READ, MAP_SHARED, Fd, 0) : MAP_FAILED);
+		if (Fd >= 0) close (Fd);
+		const CBroadcastRing * Ring (Map == MAP_FAILED ? NULL : static_cast <const CBroadcastRing *> (Map));
+		if (Ring == NULL || memcmp (Ring -> Magic, "KCBC", 4) != 0 || Ring -> Version != KBroadcastVersion
+			|| Ring -> NbSlots != KBroadcastSlots || Ring -> SlotBytes != sizeof (CFrameSlot))
+		{
+			cerr << Path << " : aucune partie diffusée" << endl;
+			if (Ring != NULL) munmap (Map, sizeof (CBroadcastRing));
+			return 1;
+		}
+
+		/* On reprend les images encore dans l'anneau, pour trouver au plus vite une image complète */
+		const uint64_t Start (Ring -> Head.load (memory_order_acquire));
+		uint64_t Cursor (Start > KBroadcastSlots - 1 ? Start - (KBroadcastSlots - 1) : 0);
+		uint64_t Dropped (0);
+		bool Synced (false), Changed (false), Over (false);
+		CMat Grid;
+		CFrame Frame {}, Shown {};
+		const chrono::steady_clock::time_point Begin (chrono::steady_clock::now ());
+
+		while (Seconds == 0 || ElapsedNs (Begin) < Seconds * 1000000000ull)
+		{
+			const uint64_t Head (Ring -> Head.load (memory_order_acquire));
+			if (Head < Cursor)	// La partie a été relancée : l'anneau repart de zéro
+			{
+				Cursor = 0;
+				Synced = false;
+			}
+			if (Head - Cursor > KBroadcastSlots - 1)
+			{
+				Dropped += Head - (KBroadcastSlots - 1) - Cursor;
+				Cursor = Head - (KBroadcastSlots - 1);
+				Synced = false;
+			}
+
+			for (; Cursor < Head; ++Cursor)
+			{
+				const CFrameSlot & Slot (Ring -> Slots [Cursor % KBroadcastSlots]);
+				const uint64_t Sequence (Slot.Sequence.load (memory_order_acquire));
+				bool Valid (Sequence == 2 * Cursor + 2);
+				if (Valid)
+				{
+					memcpy (&Frame, &Slot.Frame, sizeof (Frame));
+					atomic_thread_fence (memory_order_acquire);
+					Valid = Slot.Sequence.load (memory_order_relaxed) == Sequence && FrameBytes (Frame) <= sizeof (Frame)
+						 && (Frame.Kind != KFrameKey || Frame.NbCells == unsigned (Frame.Size) * Frame.Size);
+				}
+				if (! Valid)
+				{
+					++Dropped;
+					Synced = false;
+					continue;
+				}
+
+				if (Frame.Kind == KFrameKey)
+				{
+					Grid.assign (Frame.Size, CVLine (Frame.Size));
+					for (unsigned c (0); c < Frame.NbCells; ++c)
+						Grid [c / Frame.Size][c % Frame.Size] = Frame.Cells [c];
+					Synced = true;
+				}
+				else if (Frame.Kind == KFrameDelta && Synced)
+				{
+					for (unsigned k (0); k < Frame.NbCells; ++k)
+					{
+						const unsigned c (Frame.Cells [3 * k] | Frame.Cells [3 * k + 1] << 8);
+						if (c < unsigned (Frame.Size) * Frame.Size && Frame.Size == Grid.size ())
+							Grid [c / Frame.Size][c % Frame.Size] = Frame.Cells [3 * k + 2];
+					}
+				}
+				else if (Frame.Kind == KFrameDelta)
+					continue;	// Pas encore d'image complète depuis la dernière perte
+
+				Over = Frame.Kind == KFrameEnd;
+				Shown = Frame;
+				Changed = true;
+			}
+
+			/* Seule la dernière image lue est affichée */
+			if (Changed && Synced)
+			{
+				string Notice ("Spectateur : partie " + to_string (Shown.Game) + ", coup " + to_string (Shown.NbMoves) + "/"
+							   + to_string (Shown.MaxTimes) + ", score " + to_string (Shown.Score));
+				if (Over)
+					Notice += " - partie terminée";
+				else if (Shown.MoveDirection != '\0')
+					Notice += "\nDernier coup : ligne " + to_string (Shown.MoveRow + 1) + ", colonne " + to_string (Shown.MoveColumn + 1)
+							+ ", direction " + Shown.MoveDirection + ", " + to_string (Shown.Points) + " points";
+				if (Dropped != 0) Notice += "\nImages perdues : " + to_string (Dropped);
+				DisplayGrid (Grid, Notice);
+				Changed = false;
+			}
+			else
+				this_thread::sleep_for (chrono::milliseconds (10));
+		}
+
+		munmap (Map, sizeof (CBroadcastRing));
+		return 0;
+
+	} // RunWatch ()
+
+	/*	BOTS EXTERNES
+
+		Avec --bot <fichier>, le jeu héberge les parties d'un bot qui tourne dans un autre processus, dans n'importe quel
+		langage qui sait appeler du C : KittyBot.h décrit le fichier partagé et donne au bot de quoi s'y attacher. Le bot
+		pousse ses requêtes (nouvelle partie, coup, annulation, coup rejoué, indice) dans une file, le jeu répond à chacune,
+		dans l'ordre, par l'état de la partie dans une autre file. Chaque file n'a qu'un écrivain et qu'un lecteur : elle
+		n'a besoin que de deux compteurs, chacun sur sa ligne de cache, et chaque côté garde la dernière valeur lue de
+		celui de l'autre pour ne le relire que quand la file semble vide ou pleine. Tant que le bot joue, le jeu attend la
+		requête suivante en boucle active, sans appel système : un aller-retour prend quelques microsecondes. Quand le bot
+		ne joue plus, l'attente passe par de courtes pauses, et le jeu s'arrête au bout du délai d'inactivité. */
+
+	static_assert (unsigned (KBotStarted) == KStepStarted && unsigned (KBotPlayed) == KStepPlayed
+				   && unsigned (KBotHinted) == KStepHinted && unsigned (KBotNoHint) == KStepNoHint,
+				   "the steps of KittyBot.h are the ones of CStepResult");
+	static_assert (unsigned (KBotNotOver) == KNotOver && unsigned (KBotNoCandiesLeft) == KNoCandiesLeft,
+				   "the ends of KittyBot.h are the ones of CGameEnd");
+
+	/** @brief Wait of the game for the bot : busy, then yielding the core, then short sleeps once the bot is idle */
+	class CBotWait
+	{
+		chrono::steady_clock::time_point Since;
+		unsigned Spins;
+		const unsigned MaxSpins;	// Aucune sur un seul cœur : le bot ne peut répondre que si on lui laisse la main
+		const unsigned Timeout;
+
+	  public:
+		explicit CBotWait (unsigned IdleTimeout)
+			: Spins (0), MaxSpins (thread::hardware_concurrency () > 1 ? KBotSpins : 0), Timeout (IdleTimeout) {}
+
+		void Reset () { Spins = 0; }
+
+		/** @brief Waits a little, false once the bot has been idle for the whole timeout */
+		bool operator () ()
+		{
+			if (Spins == 0) Since = chrono::steady_clock::now ();
+			if (++Spins < MaxSpins)
+			{
+				BotPause ();
+				return true;
+			}
+			const double Waited (ElapsedNs (Since));
+			if (Waited < 1e7)
+				this_thread::yield ();
+			else
+				this_thread::sleep_for (chrono::microseconds (50));
+			return Waited < Timeout * 1e9;
+		}
+	};
+
+	/**
+    *@brief Writes the state of a game for the bot
+    *@param State the slot of the queue
+    *@param Session the game
+    *@param Game the number of the game
+    *@param Points the points earned by the request
+    */
+	void WriteBotState (CBotState & State, const CSession & Session, uint32_t Game, unsigned Points)
+	{
+		State.Game = Game;
+		State.Score = Session.Score;
+		State.Points = Points;
+		State.Size = Session.Size;
+		State.NbMoves = Session.NbMoves;
+		State.MaxTimes = Session.MaxTimes;
+		State.NbCandies = Session.NbCandies;
+		State.HintRow = Session.Step == KStepHinted ? Session.Hinted.Pos.first : 0;
+		State.HintColumn = Session.Step == KStepHinted ? Session.Hinted.Pos.second : 0;
+		State.HintDirection = Session.Step == KStepHinted ? Session.Hinted.Direction : '\0';
+		State.Step = Session.Step;
+		State.End = Session.End;
+		State.Reshuffled = Session.Reshuffled;
+		for (unsigned c (0); c < Session.Size * Session.Size; ++c)
+			State.Cells [c] = Session.Grid [c / Session.Size][c % Session.Size];
+
+	} // WriteBotState ()
+
+	/**
+    *@brief Hosts the games of a bot in another process (mode --bot)
+    *@param Path the shared file
+    *@param IdleTimeout how many seconds without a request before stopping
+    * Reports how many games of each level the bot finished, and its mean score
+    */
+	int RunBotHost (const string & Path, unsigned IdleTimeout)
+	{
+		const int Fd (open (Path.c_str (), O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+		void * Map (Fd >= 0 && ftruncate (Fd, sizeof (CBotChannel)) == 0
+					? mmap (NULL, sizeof (CBotChannel), PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0) : MAP_FAILED);
+		if (Fd >= 0) close (Fd);
+		if (Map == MAP_FAILED)
+		{
+			cerr << Path << " : " << strerror (errno) << endl;
+			return 1;
+		}
+
+		/* Le canal est remis à zéro : le Magic, écrit en dernier, dit aux bots qu'il est prêt */
+		CBotChannel & Channel (*static_cast <CBotChannel *> (Map));
+		memset (&Channel, 0, sizeof (Channel));
+		Channel.Version = KBotVersion;
+		Channel.NbSlots = KBotSlots;
+		Channel.StateBytes = sizeof (CBotState);
+		Channel.Host = getpid ();
+		atomic_thread_fence (memory_order_release);
+		memcpy (Channel.Magic, "KCBT", 4);
+
+		CSession Session;
+		CHistory History (UndoDepth, size_t (UndoMemoryKb) * 1024);
+		Session.Rules = &KRuleSets [CurrentRules];
+		Session.History = &History;
+
+		uint64_t RequestsHead (0), StatesTail (0), NbRequests (0), NbMoves (0);
+		uint32_t Game (0);
+		array <uint64_t, KLevels.size ()> NbFinished {}, Scores {};
+		unsigned Level (0);
+		CBotWait Wait (IdleTimeout);
+		cout << "Parties hébergées dans " << Path << " (" << KRuleSets [CurrentRules].Name << "), en attente d'un bot..." << endl;
+		const chrono::steady_clock::time_point Start (chrono::steady_clock::now ());
+
+		for (bool Running (true); Running; )
+		{
+			while (Running && ! BotCanPop (&Channel.Requests, &RequestsHead))
+				Running = Wait ();
+			if (! Running) break;
+			Wait.Reset ();
+
+			const CBotRequest Request (Channel.RequestSlots [Channel.Requests.Tail % KBotSlots]);
+			BotPop (&Channel.Requests);
+			++NbRequests;
+
+			const unsigned Before (Session.Score);
+			const CMove Move {CPosition (Request.Row, Request.Column), Request.Direction};
+			switch (Request.Action)
+			{
+				case KBotNew:
+					if (Request.Level < 1 || Request.Level > KLevels.size ())
+					{
+						Session.Step = KStepRejected;
+						break;
+					}
+					Level = Request.Level - 1;
+					NewSession (Session, KLevels [Level], Request.Seed);
+					++Game;
+					break;
+
+				case KBotMove:
+				case KBotUndo:
+				case KBotRedo:
+				case KBotHint:
+					if (Session.Size == 0)
+					{
+						Session.Step = KStepRejected;
+						break;
+					}
+					ResumePlay (Session, CPlayInput {Request.Action == KBotMove ? KPlayMove : Request.Action == KBotUndo ? KPlayUndo
+													 : Request.Action == KBotRedo ? KPlayRedo : KPlayHint, Move});
+					if (Session.Step == KStepPlayed) ++NbMoves;
+					if (Session.Step == KStepPlayed && Session.End != KNotOver)
+					{
+						++NbFinished [Level];
+						Scores [Level] += Session.Score;
+					}
+					break;
+
+				case KBotQuit:
+					Running = false;
+					continue;
+
+				default:
+					Session.Step = KStepRejected;
+			}
+
+			if (Session.Step == KStepStarted || Session.Step == KStepPlayed || Session.Step == KStepUndone
+				|| Session.Step == KStepRedone)
+			{
+				Broadcast.Publish (Session, Session.Step == KStepPlayed ? &Move : NULL, Session.Score - Before);
+				if (Session.End != KNotOver) Broadcast.End (Session);
+			}
+
+			/* Le bot ne lit plus ses réponses : on attend qu'il fasse de la place */
+			while (Running && ! BotCanPush (&Channel.States, &StatesTail))
+				Running = Wait ();
+			if (! Running) break;
+			Wait.Reset ();
+			WriteBotState (Channel.StateSlots [Channel.States.Head % KBotSlots], Session, Game,
+						   Session.Step == KStepPlayed ? Session.Score - Before : 0);
+			BotPush (&Channel.States);
+		}
+
+		memset (Channel.Magic, 0, 4);
+		munmap (Map, sizeof (CBotChannel));
+
+		cout << NbRequests << " requêtes, " << Game << " parties, " << NbMoves << " coups en " << fixed << setprecision (1)
+			 << ElapsedNs (Start) / 1e9 << " s" << endl;
+		for (unsigned l (0); l < KLevels.size (); ++l)
+			if (NbFinished [l] != 0)
+				cout << "Niveau " << l + 1 << " : " << NbFinished [l] << " parties terminées, score moyen "
+					 << double (Scores [l]) / NbFinished [l] << endl;
+		return 0;
+
+	} // RunBotHost ()
+
+	/**
+    *@brief Bot playing through KittyBot.h (mode --bot-bench) : plays the hints of the game, and measures the round trips
+    *@param Path the shared file of a game started with --bot
+    *@param NbGames how many games to play
+    *@param Level the level of the games
+    */
+	int RunBotBench (const string & Path, unsigned NbGames, unsigned Level)
+	{
+		CBot Bot;
+		if (BotOpen (&Bot, Path.c_str ()) != 0)
+		{
+			cerr << Path << " : aucune partie hébergée (lancer d'abord --bot " << Path << ")" << endl;
+			return 1;
+		}
+
+		vector <float> Latencies; // Échantillon des allers-retours, en microsecondes
+		Latencies.reserve (1 << 20);
+		uint64_t NbRequests (0), NbMoves (0), Scores (0);
+		bool Stopped (false);
+
+		/* Une requête, puis l'attente de sa réponse : le bot la lit, puis la rend avec BotRelease () */
+		auto Ask = [&] (const CBotRequest & Request) -> const CBotState *
+		{
+			const chrono::steady_clock::time_point Sent (chrono::steady_clock::now ());
+			while (! BotSend (&Bot, &Request)) BotPause ();
+			const CBotState * State (BotWait (&Bot));
+			++NbRequests;
+			if (Latencies.size () < Latencies.capacity ()) Latencies.push_back (ElapsedNs (Sent) / 1000);
+			Stopped = State == NULL;
+			return State;
+		};
+
+		const chrono::steady_clock::time_point Start (chrono::steady_clock::now ());
+		for (unsigned g (0); g < NbGames && ! Stopped; ++g)
+		{
+			const CBotState * State (Ask (CBotRequest {KBotNew, 0, uint8_t (Level), 0, 0, 0, g + 1}));
+			bool Over (State == NULL || State -> Step != KBotStarted || State -> End != KBotNotOver);
+			if (State != NULL) BotRelease (&Bot);
+
+			while (! Over)
+			{
+				State = Ask (CBotRequest {KBotHint, 0, 0, 0, 0, 0, 0});
+				if (State == NULL) break;
+				const CBotRequest Move {KBotMove, State -> HintDirection, 0, 0, State -> HintRow, State -> HintColumn, 0};
+				const bool Hinted (State -> Step == KBotHinted);
+				BotRelease (&Bot);
+				if (! Hinted) break;
+
+				State = Ask (Move);
+				if (State == NULL) break;
+				++NbMoves;
+				Over = State -> End != KBotNotOver;
+				if (Over) Scores += State -> Score;
+				BotRelease (&Bot);
+			}
+		}
+		const double Seconds (ElapsedNs (Start) / 1e9);
+		BotClose (&Bot);
+		if (Stopped)
+		{
+			cerr << "La partie hébergée s'est arrêtée" << endl;
+			return 1;
+		}
+
+		sort (Latencies.begin (), Latencies.end ());
+		auto Percentile = [&] (double P) { return Latencies.empty () ? 0.f : Latencies [unsigned (P * (Latencies.size () - 1))]; };
+
+		cout << fixed << setprecision (0)
+			 << "Parties        : " << NbGames << ", score moyen " << double (Scores) / max (NbGames, 1u) << endl
+			 << "Coups joués    : " << NbMoves << " (" << NbMoves / Seconds << " coups/s)" << endl
+			 << "Requêtes       : " << NbRequests / Seconds << " req/s" << endl
+			 << setprecision (2)
+			 << "Aller-retour   : p50 " << Percentile (0.5) << " us, p99 " << Percentile (0.99) << " us, max " << Percentile (1) << " us" << endl;
+		return 0;
+
+	} // RunBotBench ()
+
+#endif // _WIN32
+
+	/**
+    *@brief Scripted front-end of the game loop (mode --script) : plays a game whose actions are read from a script
+    *@param Script one action per line : "u", "r", "i", or moves "ligne colonne direction" separated by ';'
+    *@param Level the level
+    *@param Seed the seed of the grid
+    *@return 0 if every action of the script was accepted
+    * Each step is written on one line, then the final score and grid
+    */
+	int RunScript (istream & Script, const CLevel & Level, uint32_t Seed)
+	{
+		CSession Session;
+		CHistory History (UndoDepth, size_t (UndoMemoryKb) * 1024);
+		Session.Rules = &KRuleSets [CurrentRules];
+		Session.History = &History;
+		NewSession (Session, Level, Seed);
+		#ifndef _WIN32
+			Broadcast.Publish (Session);
+		#endif
+
+		CMoveBatch Batch;
+		CParseError Error;
+		string Line;
+		bool Awaiting (Session.End == KNotOver);
+		if (Session.Reshuffled) cout << "grille mélangée" << endl;
+		for (unsigned NbLine (1); Awaiting && getline (Script, Line); ++NbLine)
+		{
+			if (Line == "u" || Line == "r" || Line == "i")
+			{
+				const unsigned Before (Session.Score);
+				Awaiting = ResumePlay (Session, CPlayInput {Line == "u" ? KPlayUndo : Line == "r" ? KPlayRedo : KPlayHint, CMove ()});
+				#ifndef _WIN32
+					if (Session.Step == KStepUndone || Session.Step == KStepRedone) Broadcast.Publish (Session);
+				#endif
+				if (Session.Step == KStepHinted)
+					cout << "indice : " << Session.Hinted.Pos.first + 1 << ' ' << Session.Hinted.Pos.second + 1 << ' '
+						 << Session.Hinted.Direction << endl;
+				else if (Session.Step == KStepUndone || Session.Step == KStepRedone)
+					cout << (Session.Step == KStepUndone ? "annulé" : "rejoué") << " : score " << Before << " -> " << Session.Score << endl;
+				else
+				{
+					cerr << "ligne " << NbLine << " : " << (Line == "i" ? "aucun indice" : "rien à faire") << endl;
+					return 1;
+				}
+				continue;
+			}
+
+			if (! ParseMoves (Line.data (), Line.size (), true, Session.Size, Session.Rules -> IsValidDirection, Batch, Error))
+			{
+				cerr << "ligne " << NbLine << ", colonne " << Error.Column + 1 << " : " << Error.Message << endl;
+				return 1;
+			}
+			while (Awaiting && Batch.Pending ())
+			{
+				const CMove & Move (Batch.Moves [Batch.Next++]);
+				const unsigned Before (Session.Score);
+				Awaiting = ResumePlay (Session, CPlayInput {KPlayMove, Move});
+				#ifndef _WIN32
+					if (Session.Step == KStepPlayed) Broadcast.Publish (Session, &Move, Session.Score - Before);
+				#endif
+				if (Session.Step != KStepPlayed)
+				{
+					cerr << "ligne " << NbLine << ", coup " << Batch.Next << " : mouvement impossible" << endl;
+					return 1;
+				}
+				cout << Move.Pos.first + 1 << ' ' << Move.Pos.second + 1 << ' ' << Move.Direction << " : +"
+					 << Session.Score - Before << ", score " << Session.Score << endl;
+				if (Session.Reshuffled) cout << "grille mélangée" << endl;
+				if (Awaiting && Batch.Pending () && Session.Reshuffled)
+				{
+					cerr << "ligne " << NbLine << " : grille mélangée après le coup " << Batch.Next << ", coups suivants ignorés" << endl;
+					return 1;
+				}
+			}
+		}
+
+		#ifndef _WIN32
+			Broadcast.End (Session);
+		#endif
+		cout << "Score final : " << Session.Score << " en " << Session.NbMoves << (Session.NbMoves > 1 ? " coups" : " coup")
+			 << (Session.End == KNotOver ? ", partie inachevée" : "") << endl;
+		for (const CVLine & Row : Session.Grid)
+		{
+			for (unsigned Cell : Row) cout << ' ' << Cell;
+			cout << endl;
+		}
+		return 0;
+
+	} // RunScript ()
+
+	/*	DIFFICULTÉ ADAPTATIVE
+
+		La partie adaptative choisit la taille, le nombre de coups et le nombre de numéros de la partie suivante d'après les
+		derniers scores du joueur. KDifficulties donne, pour chaque ensemble de paramètres, les centiles des scores d'un
+		joueur glouton (qui joue toujours le coup qui rapporte le plus), calculés une fois pour toutes par simulation avec
+		--difficulty-table et recopiés ici : le jeu ne simule rien. Le score d'une partie est placé parmi ceux du joueur
+		glouton sur les mêmes paramètres ; la moyenne de ces rangs sur les dernières parties mesure le joueur, quels que
+		soient les paramètres qu'il a joués. La partie suivante est la plus difficile où un joueur de ce rang atteint
+		l'objectif, KAdaptiveGoal points. Le rang des dernières parties est gardé dans "adaptive.txt". */
+
+	/** @brief Number of quantiles of the scores in the table */
+	const unsigned KNbQuantiles = 11;
+
+	/** @brief Quantiles of the scores in the table, in percents */
+	constexpr uint8_t KQuantiles [KNbQuantiles] = { 1, 10, 20, 30, 40, 50, 60, 70, 80, 90, 99 };
+
+	/** @brief A parameter set of the adaptive mode, and the scores of the greedy player on it */
+	struct CDifficulty
+	{
+		uint8_t Size;
+		uint8_t MaxTimes;
+		uint8_t NbCandies;
+		uint16_t Scores [KNbQuantiles];	// Score de chaque centile de KQuantiles
+	};
+
+	/** @brief The parameter sets, from the easiest to the hardest (median points per move) : 10000 games each, written by
+	           --difficulty-table 10000 */
+	constexpr CDifficulty KDifficulties [] = {
+		{ 10, 10, 4, {  241,  348,  404,  451,  500,  548,  604,  672,  761,  908, 1412 } },
+		{ 10, 13, 4, {  256,  363,  420,  468,  516,  568,  630,  704,  803,  976, 1520 } },
+		{  9,  9, 4, {  172,  240,  277,  310,  342,  377,  415,  464,  526,  640, 1048 } },
+		{  9, 12, 4, {  192,  269,  308,  342,  374,  406,  442,  490,  550,  655,  990 } },
+		{ 10, 10, 5, {  126,  180,  210,  238,  262,  288,  320,  358,  404,  480,  752 } },
+		{  8,  8, 4, {   88,  158,  180,  196,  216,  230,  250,  282,  308,  372,  494 } },
+		{  8, 11, 4, {  150,  196,  221,  246,  266,  282,  303,  330,  360,  394,  524 } },
+		{  9,  9, 5, {   94,  138,  164,  184,  204,  224,  246,  271,  306,  367,  586 } },
+		{  7,  7, 4, {   64,   96,  108,  130,  150,  162,  180,  208,  222,  271,  354 } },
+		{ 10, 13, 5, {  144,  196,  226,  250,  274,  298,  325,  360,  408,  486,  800 } },
+		{  9, 12, 5, {  112,  156,  180,  198,  216,  235,  256,  280,  317,  372,  606 } },
+		{  8,  8, 5, {   84,  106,  126,  132,  144,  156,  174,  196,  218,  243,  318 } },
+		{ 10, 10, 6, {   78,  120,  141,  159,  174,  192,  213,  236,  268,  318,  536 } },
+		{  7, 10, 4, {  100,  122,  147,  161,  168,  178,  190,  202,  222,  264,  366 } },
+		{  6,  6, 4, {   36,   58,   73,   84,   95,  102,  114,  126,  144,  160,  252 } },
+		{ 10, 13, 6, {  101,  144,  162,  180,  198,  216,  236,  258,  290,  340,  526 } },
+		{  8, 11, 5, {   92,  120,  147,  158,  175,  182,  192,  210,  226,  282,  364 } },
+		{  9,  9, 6, {   62,   90,  108,  120,  132,  144,  160,  177,  198,  235,  374 } },
+		{  7,  7, 5, {   46,   64,   78,   86,   94,  104,  109,  123,  136,  168,  276 } },
+		{  9, 12, 6, {   90,  116,  130,  144,  156,  168,  183,  200,  222,  257,  388 } },
+		{  8,  8, 6, {   48,   70,   84,   92,  102,  112,  122,  137,  164,  196,  301 } },
+		{  7, 10, 5, {   64,   86,  100,  114,  126,  132,  141,  152,  174,  198,  276 } },
+		{  6,  9, 4, {   68,   84,   92,  100,  106,  112,  120,  132,  144,  162,  274 } },
+		{  8, 11, 6, {   66,   84,  102,  114,  124,  136,  146,  158,  176,  214,  372 } },
+		{  6,  6, 5, {   36,   44,   54,   58,   68,   72,   80,   90,  102,  130,  194 } },
+		{  5,  5, 4, {   30,   34,   48,   48,   52,   60,   66,   75,   81,   90,  142 } },
+		{  7,  7, 6, {   42,   57,   60,   68,   78,   83,   94,  102,  114,  138,  208 } },
+		{  7, 10, 6, {   60,   78,   82,   86,   96,  104,  108,  116,  128,  144,  222 } },
+		{  5,  5, 5, {   30,   30,   30,   34,   48,   48,   48,   52,   60,   72,  108 } },
+		{  6,  9, 5, {   54,   58,   72,   72,   80,   84,   91,   96,  108,  120,  160 } },
+		{  6,  6, 6, {   36,   36,   40,   54,   54,   54,   62,   72,   76,   90,  130 } },
+		{  6,  9, 6, {   54,   54,   58,   68,   72,   72,   76,   84,   90,  102,  138 } },
+		{  5,  8, 4, {   36,   42,   52,   54,   56,   60,   66,   72,   78,   90,  146 } },
+		{  5,  5, 6, {   30,   30,   30,   30,   34,   34,   46,   48,   48,   56,   78 } },
+		{  5,  8, 5, {   36,   40,   42,   44,   48,   52,   54,   57,   66,   78,  114 } },
+		{  5,  8, 6, {   30,   36,   36,   40,   42,   42,   48,   48,   54,   60,   84 } },
+	};
+
+	/** @brief Score to reach in an adaptive game */
+	const unsigned KAdaptiveGoal = 150;
+
+	/** @brief How many games measure the player */
+	const unsigned KAdaptiveWindow = 5;
+
+	const string KAdaptiveFile ("./adaptive.txt");
+
+	/**
+    *@brief Rank of a score among the games of the greedy player, interpolated between the quantiles of the table
+    *@param Set the parameter set of the game
+    *@param Score the score
+    *@return the percentage of the games of the greedy player with a lower score
+    */
+	double ScorePercentile (const CDifficulty & Set, unsigned Score)
+	{
+		if (Score <= Set.Scores [0])
+			return Set.Scores [0] == 0 ? KQuantiles [0] : KQuantiles [0] * double (Score) / Set.Scores [0];
+		for (unsigned q (1); q < KNbQuantiles; ++q)
+			if (Score <= Set.Scores [q])
+				return KQuantiles [q - 1] + (KQuantiles [q] - KQuantiles [q - 1]) * double (Score - Set.Scores [q - 1])
+											/ (Set.Scores [q] - Set.Scores [q - 1]);
+		return 100;
+
+	} // ScorePercentile ()
+
+	/**
+    *@brief Score of the greedy player at a given rank on a parameter set, the reverse of ScorePercentile
+    *@param Set the parameter set
+    *@param Percentile the rank, in percents
+    */
+	double ScoreAtPercentile (const CDifficulty & Set, double Percentile)
+	{
+		if (Percentile <= KQuantiles [0]) return Set.Scores [0] * Percentile / KQuantiles [0];
+		for (unsigned q (1); q < KNbQuantiles; ++q)
+			if (Percentile <= KQuantiles [q])
+				return Set.Scores [q - 1] + (Set.Scores [q] - Set.Scores [q - 1]) * (Percentile - KQuantiles [q - 1])
+											/ (KQuantiles [q] - KQuantiles [q - 1]);
+		return Set.Scores [KNbQuantiles - 1];
+
+	} // ScoreAtPercentile ()
+
+	/** @brief Ranks of the last adaptive games, the most recent last */
+	typedef vector <double> CAdaptiveHistory;
+
+	/** @brief Reads the ranks of the last adaptive games, none if the file is missing */
+	CAdaptiveHistory LoadAdaptiveHistory ()
+	{
+		CAdaptiveHistory Ranks;
+		ifstream File (KAdaptiveFile);
+		double Rank;
+		while (File >> Rank)
+			if (Rank >= 0 && Rank <= 100) Ranks.push_back (Rank);
+		if (Ranks.size () > KAdaptiveWindow) Ranks.erase (Ranks.begin (), Ranks.end () - KAdaptiveWindow);
+		return Ranks;
+
+	} // LoadAdaptiveHistory ()
+
+	/**
+    *@brief Adds the rank of a game to the last ones, and writes them
+    *@param Ranks the ranks of the last games
+    *@param Rank the rank of the game
+    */
+	void SaveAdaptiveHistory (CAdaptiveHistory & Ranks, double Rank)
+	{
+		Ranks.push_back (Rank);
+		if (Ranks.size () > KAdaptiveWindow) Ranks.erase (Ranks.begin ());
+		ofstream File (KAdaptiveFile);
+		for (double Last : Ranks) File << fixed << setprecision (1) << Last << endl;
+
+	} // SaveAdaptiveHistory ()
+
+	/** @brief Rank of the player : mean of the last games, the middle before the first game */
+	double PlayerRank (const CAdaptiveHistory & Ranks)
+	{
+		if (Ranks.empty ()) return 50;
+		double Sum (0);
+		for (double Rank : Ranks) Sum += Rank;
+		return Sum / Ranks.size ();
+
+	} // PlayerRank ()
+
+	/**
+    *@brief Chooses the parameters of the next adaptive game : the set where a player of this rank is expected to score the
+    *       least while still reaching the goal, or the most if the goal is out of reach everywhere
+    *@param Rank the rank of the player
+    *@return the index in KDifficulties
+    */
+	unsigned ChooseDifficulty (double Rank)
+	{
+		const unsigned NbSets (sizeof (KDifficulties) / sizeof (KDifficulties [0]));
+		unsigned Chosen (0);
+		double ChosenScore (0);
+		for (unsigned s (0); s < NbSets; ++s)
+		{
+			const double Score (ScoreAtPercentile (KDifficulties [s], Rank));
+			const bool Reached (Score >= KAdaptiveGoal), ChosenReached (ChosenScore >= KAdaptiveGoal);
+			if (s == 0 || (Reached && (! ChosenReached || Score < ChosenScore)) || (! Reached && ! ChosenReached && Score > ChosenScore))
+			{
+				Chosen = s;
+				ChosenScore = Score;
+			}
+		}
+		return Chosen;
+
+	} // ChooseDifficulty ()
+
+
+
+
+
+	/* Fonction principale contenant le jeu */
+    /**
+    *@brief Kitty Crush, the game itself
+    *@param OptionsChoices to check your choosen options
+    *@param LoadExistingSave if you choose to load a save
+    *@param Slot the save slot : the one loaded, or the one the new game is saved to
+    *@param Puzzle the puzzle to play, NULL for a game on a random grid
+    */
+	void Game (const array <unsigned, 2> & OptionsChoices, bool LoadExistingSave, unsigned Slot, const CPuzzle * Puzzle = NULL)
+	{
+		CSession Session;		// La partie, que la boucle de jeu fait avancer
+
+		unsigned & Size (Session.Size);				// Taille de la grille (à la fois ligne et colonnes) !!
+		unsigned & MaxTimes (Session.MaxTimes); 	// Nombre maximal de coups autorisés
+		unsigned & NbCandies (Session.NbCandies); 	// Combien de numéros différents sont présents dans la grille
+		unsigned & BestScore (Session.BestScore);   // Meilleur score du niveau, lu dans le tableau des scores
+		unsigned & Score (Session.Score);
+		unsigned & NbMoves (Session.NbMoves);
+
+		/* Il est possible de les modifier pour faire des niveaux de difficulté */
+		Size = 6;
+		MaxTimes = 6;
+		NbCandies = 4;
+
+		/* Options choisies */
+		unsigned InputMode (OptionsChoices [0]);	// 0 : saisie "à l'ancienne" où on demande les ligne colonne etc une à la fois, 1 : saisie sur 1 ligne
+
+		bool InputLineFirst; 	// true : la commande est du type "ligne colonne direction", false : "colonne ligne direction"
+		InputLineFirst = OptionsChoices [1] == 0 ? true : false; // 0 : ligne en premier, 1 : colonne en premier
+
+
+		CMat & Grid (Session.Grid);
+		CReplay Replay;				// La partie, archivée à la fin si c'est une nouvelle partie
+		bool Recorded (false);
+		unsigned RuleSet (Puzzle != NULL ? 0 : CurrentRules);	// Indice dans KRuleSets, celui de la sauvegarde pour une partie chargée
+		bool Adaptive (false);		// Paramètres choisis d'après les dernières parties, voir ChooseDifficulty ()
+		CAdaptiveHistory Ranks;
+		string Notice;				// Affiché sous la grille au prochain tour : DisplayGrid efface l'écran
+		if (Puzzle != NULL)
+		{
+			Size = Puzzle -> Level.Size;
+			MaxTimes = Puzzle -> Level.MaxTimes;
+			NbCandies = Puzzle -> Level.NbCandies;
+			Grid = Puzzle -> Grid;
+		}
+		else if (! LoadExistingSave)
+		{
+			unsigned ChoixLevel;
+			do {
+				ClearScreen ();
+				cout << '\t' << "Choisir un niveau de difficulté : " << endl << endl
+					 << "1 - Facile    : 6x6, 6 coups maximum, 4 numéros différents" << endl
+					 << "2 - Moyen     : 8x8, 9 coups maximum, 4 numéros différents" << endl
+					 << "3 - Difficile : 6x6, 8 coups maximum, 5 numéros différents" << endl
+					 << "4 - Expert    : 8x8, 11 coups maximum, 5 numéros différents" << endl
+					 << "5 - Adaptatif : adapté à vos dernières parties, " << KAdaptiveGoal << " points à atteindre" << endl << endl
+					 << "6 - Règles : " << KRuleSets [CurrentRules].Name << endl << endl;
+
+				MenuPrompt (ChoixLevel, KLevels.size () + 2);
+				if (ChoixLevel == KLevels.size () + 2) ChooseRules ();
+
+			} while (ChoixLevel == KLevels.size () + 2);
+
+			/* Les centiles de KDifficulties sont ceux des règles classiques : une partie adaptative se joue avec elles */
+			Adaptive = ChoixLevel == KLevels.size () + 1;
+			if (Adaptive)
+			{
+				RuleSet = 0;
+				Ranks = LoadAdaptiveHistory ();
+				const CDifficulty & Set (KDifficulties [ChooseDifficulty (PlayerRank (Ranks))]);
+				Replay.Level = { Set.Size, Set.MaxTimes, Set.NbCandies };
+				Notice = "Partie adaptative : " + to_string (KAdaptiveGoal) + " points à atteindre en " + to_string (Set.MaxTimes)
+					   + " coups\n";
+			}
+			else
+				Replay.Level = KLevels [ChoixLevel - 1];
+			Size = Replay.Level.Size;
+			MaxTimes = Replay.Level.MaxTimes;
+			NbCandies = Replay.Level.NbCandies;
+
+			/* La grille et ses mélanges viennent de la même graine, comme pour NewSession : la partie peut être archivée */
+			Recorded = true;
+			Replay.Seed = time (NULL);
+			Replay.Rules = RuleSet;
+			Session.Rand = CRandom (Replay.Seed);
+			InitGrid (Grid, Size, NbCandies, Session.Rand);
+		}
+		else
+		{
+			if (const CSaveError Error = LoadSave (Slot, Grid, KeyTab, Score, BestScore, NbMoves, Size, MaxTimes, RuleSet, NbCandies, Adaptive))
+			{
+			    cout << "Sauvegarde corrompue : " << SaveErrorText (Error) << endl
+			         << "Lancement d'une nouvelle partie..." << endl;
+
+				#ifdef _WIN32
+					Sleep (3000);
+				#else
+					sleep (3);
+				#endif
+
+				Size = 6;
+				MaxTimes = 6;
+				NbCandies = 4;
+				RuleSet = CurrentRules;
+				Adaptive = false;
+			    InitGrid (Grid, Size, NbCandies);
+			    Score = 0;
+			    BestScore = 0;
+			    NbMoves = 0;
+		    }
+			else if (Adaptive)
+				Ranks = LoadAdaptiveHistory ();	// Le rang de la partie s'y ajoutera à la fin
+	    }
+
+		/* Puzzles et parties adaptatives : règles classiques ; une partie chargée garde les règles de sa sauvegarde */
+		const CRuleSet & Rules (KRuleSets [RuleSet]);
+		#ifndef _WIN32
+			if (Rules.Classic && ! Adaptive) BestScore = max (BestScore, BestScoreOf (LevelOf (Size, MaxTimes, NbCandies)));
+		#endif
+
+		CHistory History (UndoDepth, size_t (UndoMemoryKb) * 1024);
+		string Input;				// Ligne saisie, garde sa mémoire d'un tour à l'autre
+		CMoveBatch Batch;			// Coups saisis sur une même ligne, pas encore joués
+
+		/* Le moteur décrit chaque coup dans Events ; l'affichage des réactions en chaîne, le journal des coups et les
+		   statistiques le lisent chacun de leur côté */
+		CEventStream Events (Grid.size () * Grid [0].size ());
+		CStepRenderer Renderer (Events);
+		CMoveJournal Journal (Events, "./journal.bin", LoadExistingSave);
+		CTelemetry Telemetry (Events);
+		Renderer.Reset (Grid);
+
+		if (! Recorded) Session.Rand = CRandom (time (NULL));	// Pour mélanger la grille quand elle est bloquée
+		Session.Rules = &Rules;
+		Session.StopWhenBlocked = Puzzle != NULL;
+		Session.History = &History;
+		Session.Events = &Events;
+
+		/* Le terminal est le front-end de la boucle de jeu : il montre chaque pas, puis lit l'action suivante */
+		ClearScreen ();
+		bool Awaiting (StartPlay (Session));
+		#ifndef _WIN32
+			Broadcast.Publish (Session);
+		#endif
+		while (Awaiting)
+		{
+			if (Session.Reshuffled)
+			{
+				if (Batch.Pending ())
+				{
+					Notice += "Plus aucun coup ne rapportait de points : les coups suivants de la ligne sont ignorés\n";
+					Batch.Clear ();
+				}
+				Notice += "Aucun coup ne rapportait de points : la grille a été mélangée\n";
+				Renderer.Reset (Grid);
+				Save (Slot, Grid, NbMoves, Score, BestScore, Size, KeyTab, MaxTimes, RuleSet, NbCandies, Adaptive);
+			}
+
+			/* Tant qu'il reste des coups de la même ligne à jouer, la grille n'est pas réaffichée */
+			if (! Batch.Pending ())
+			{
+				DisplayGrid (Grid, Notice);
+				Notice.clear ();
+				cout << "Il vous reste " << MaxTimes - NbMoves
+					 << (MaxTimes - NbMoves > 1 ? " coups" : " coup") << " à jouer." << endl // Affiche coup au singulier quand il n'en reste qu'un...
+					 << "Votre score est de " << Score << endl << endl;
+			}
+
+			CPosition CaseSelect;	// Position de la case sélectionnée par le joueur
+			char Direction;
+			char Command ('\0');	// 'u' : annuler le dernier coup, 'r' : le rejouer, 'i' : indice, 'm' : coup suivant de Batch
+
+			if (Batch.Pending ())
+				Command = 'm';
+
+			else if (InputMode == 0)
+			{
+				cout << "Saisir les coordonnées de la case à déplacer puis la case adjacente avec laquelle l'échanger" << endl;
+				#ifdef _WIN32
+					cout << "ou bien saisir CTRL+Z puis Entrée pour abandonner et revenir au menu" << endl;
+				#else
+					cout << "ou bien saisir CTRL+D pour abandonner et revenir au menu" << endl;
+				#endif
+				DisplayMovementKeys ();
+				if (Rules.Keys != NULL) cout << Rules.Keys << endl;
+
+				do {
+					do {
+
+						string Message;
+						unsigned NumFirst;
+						unsigned NumSecond;
+
+						Message = InputLineFirst ? "Ligne : " : "Colonne : ";
+						SaisieLigneColOuCommande (NumFirst, Command, Grid, Message, Batch, InputLineFirst, Rules.IsValidDirection);
+						if (cin.eof () || Command != '\0') break;
+
+						Message = InputLineFirst ? "Colonne : " : "Ligne : ";
+						SaisieLigneCol (NumSecond, Grid, Message);
+						if (cin.eof ()) break;
+
+						if (InputLineFirst)
+						{
+							CaseSelect.first = NumFirst - 1;  // L'utilisateur entre un nombre entre 1 et taille de la grille, il faut donc lui enlever 1
+							CaseSelect.second = NumSecond - 1;
+						}
+						else
+						{
+							CaseSelect.second = NumFirst - 1;
+							CaseSelect.first = NumSecond - 1;
+						}
+
+						if (! IsValidPosition (Grid, CaseSelect))
+							cout << endl << "Sélectionnez une case non vide" << endl;
+
+					} while (! IsValidPosition (Grid, CaseSelect));
+					if (cin.eof () || Command != '\0') break;
+
+					SaisieCin (Direction, "Erreur de saisie", "Direction : ");
+					if (cin.eof ()) break;
+					while (! Rules.IsValidDirection (Direction))
+					{
+						cout << "Direction invalide" << endl;
+						SaisieCin (Direction, "Erreur de saisie", "Direction : ");
+					}
+
+					if (! Rules.IsValidMove (Grid, CaseSelect, Direction))
+						cout << "Mouvement impossible" << endl << endl;
+
+				} while (! Rules.IsValidMove (Grid, CaseSelect, Direction));
+
+			} // InputMode == 0
+
+			else
+			{
+				cout << "Saisir, séparées d'au moins un espace, "
+					 << (InputLineFirst ? "la ligne et la colonne" : "la colonne et la ligne")
+					 << " de la case sélectionnée et la direction vers laquelle l'échanger" << endl;
+				#ifdef _WIN32
+					cout << "ou bien saisir CTRL+Z puis Entrée pour abandonner et revenir au menu" << endl;
+				#else
+					cout << "ou bien saisir CTRL+D pour abandonner et revenir au menu" << endl;
+				#endif
+
+				DisplayMovementKeys ();
+				if (Rules.Keys != NULL) cout << Rules.Keys << endl;
+
+				if (NbMoves == 0)
+					cout << "ex : 2 3 z --> la case en colonne 2 et ligne 3 échange avec celle du haut" << endl // Mini tuto au début du jeu
+						 << "     2 3 z; 4 1 s --> plusieurs coups à la suite, séparés par des ';'" << endl;
+
+				for (;;)
+				{
+					getline (cin, Input);  // On récupère la ligne saisie dans Input
+					if (cin.eof ()) break;
+					if (Input == "u" || Input == "r" || Input == "i")
+					{
+						Command = Input [0];
+						break;
+					}
+
+					/* Les coups sont lus sans rien copier ; ils sont vérifiés sur la grille au moment d'être joués */
+					CParseError Error;
+					if (ParseMoves (Input.data (), Input.size (), InputLineFirst, Grid.size (), Rules.IsValidDirection, Batch, Error))
+					{
+						Command = 'm';
+						break;
+					}
+					DisplayParseError (Input, Error);
+				}
+
+			} // InputMode == 1
+
+			if (cin.eof ()) break;
+
+			CPlayInput Action {KPlayMove, CMove {CaseSelect, Direction}};
+			unsigned Number (0);	// Numéro dans la ligne du coup pris dans Batch
+			if (Command == 'm')
+			{
+				Number = Batch.Next + 1;
+				Action.Move = Batch.Moves [Batch.Next++];
+			}
+			else if (Command != '\0')
+				Action.Action = Command == 'u' ? KPlayUndo : Command == 'r' ? KPlayRedo : KPlayHint;
+
+			const unsigned Before (Score);
+			Awaiting = ResumePlay (Session, Action);
+			#ifndef _WIN32
+				if (Session.Step == KStepPlayed || Session.Step == KStepUndone || Session.Step == KStepRedone || Session.Reshuffled)
+					Broadcast.Publish (Session, Session.Step == KStepPlayed ? &Action.Move : NULL, Score - Before);
+				if (Recorded) RecordStep (Replay, Session, Action);
+			#endif
+
+			switch (Session.Step)
+			{
+				case KStepRejected:
+				{
+					/* Un coup de la ligne n'est vérifié que sur la grille laissée par les précédents */
+					const CMove & Move (Action.Move);
+					const unsigned First ((InputLineFirst ? Move.Pos.first : Move.Pos.second) + 1);
+					const unsigned Second ((InputLineFirst ? Move.Pos.second : Move.Pos.first) + 1);
+					Notice += "Coup " + to_string (Number) + " (" + to_string (First) + " " + to_string (Second) + " " + Move.Direction
+							+ ") : " + (IsValidPosition (Grid, Move.Pos) ? "mouvement impossible" : "case vide")
+							+ (Batch.Pending () ? ", les coups suivants sont ignorés" : "") + '\n';
+					Batch.Clear ();
+					Save (Slot, Grid, NbMoves, Score, BestScore, Size, KeyTab, MaxTimes, RuleSet, NbCandies, Adaptive);
+					break;
+				}
+
+				case KStepHinted:
+					Notice = "Indice : ligne " + to_string (Session.Hinted.Pos.first + 1) + ", colonne "
+						   + to_string (Session.Hinted.Pos.second + 1) + ", direction " + Session.Hinted.Direction + '\n';
+					break;
+
+				case KStepUndone:
+				case KStepRedone:
+					Renderer.Reset (Grid);
+					Save (Slot, Grid, NbMoves, Score, BestScore, Size, KeyTab, MaxTimes, RuleSet, NbCandies, Adaptive);
+					break;
+
+				case KStepNothingToUndo:
+					Notice = "Aucun coup à annuler\n";
+					break;
+
+				case KStepNothingToRedo:
+					Notice = "Aucun coup à rejouer\n";
+					break;
+
+				case KStepPlayed:
+					/* Une variante ne publie pas ses suppressions, et les coups d'une ligne sont joués sans afficher leurs étapes :
+					   il n'y a rien à rejouer */
+					if (Rules.Classic && ! Batch.Pending ())
+						Renderer.Consume (Grid);
+					else
+						Renderer.Reset (Grid);
+					Journal.Consume ();
+					Telemetry.Consume ();
+					for (const CMatchGroup & Group : Session.Groups)
+						if (KShapeRules [Group.Shape].Bonus != 0)
+							Notice += string (KShapeRules [Group.Shape].Name) + " de " + to_string (Group.Value) + " : "
+									+ to_string (KShapeRules [Group.Shape].Bonus) + " points de bonus !\n";
+					if (! Batch.Pending () || ! Awaiting)	// Une seule sauvegarde pour tous les coups d'une ligne
+						Save (Slot, Grid, NbMoves, Score, BestScore, Size, KeyTab, MaxTimes, RuleSet, NbCandies, Adaptive);
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		#ifndef _WIN32
+			Broadcast.End (Session);
+			if (Recorded && ! ArchiveReplay (KReplayArchive, Replay))
+				Notice += "La partie n'a pas pu être archivée dans " + KReplayArchive + '\n';
+		#endif
+		if (Session.End == KBlocked || Session.End == KNoCandiesLeft)
+		{
+			if (Batch.Pending ())
+				Notice += "Plus aucun coup ne rapportait de points : les coups suivants de la ligne sont ignorés\n";
+			Notice += Session.End == KBlocked ? "Plus aucun coup ne rapporte de points\n"
+											  : "Il ne reste plus assez de numéros pour marquer des points\n";
+		}
+
+		if (! cin.eof ())
+		{
+			DisplayGrid (Grid, Notice);
+			cout << "Jeu terminé ! Votre score final est de " << Score << endl;
+			if (Rules.Classic)
+				cout << Telemetry.NbRemovals << " suppressions (" << Telemetry.NbCellsCleared << " cases) en "
+					 << Telemetry.NbMoves << " coups, plus longue réaction en chaîne : " << Telemetry.LongestChain
+					 << ", meilleur coup : " << Telemetry.BestMove << " points" << endl;
+			else
+				cout << "Règles : " << Rules.Name << ", meilleur coup : " << Telemetry.BestMove << " points" << endl;
+			/* Les scores des variantes, des puzzles et des parties adaptatives ne sont pas comparables : seuls ceux des parties
+			   classiques des quatre niveaux sont enregistrés */
+			if (Puzzle != NULL)
+			{
+				cout << (Puzzle -> Exact ? "Meilleur score possible : " : "Score à atteindre : ") << Puzzle -> Best
+					 << ", par exemple en jouant";
+				for (const CMove & Move : Puzzle -> Solution)
+					cout << " (" << Move.Pos.first + 1 << ", " << Move.Pos.second + 1 << ", " << Move.Direction << ")";
+				cout << endl;
+			}
+			else if (Rules.Classic && ! Adaptive && Score > BestScore)
+				cout << "Nouveau record pour ce niveau !" << endl;
+			if (Adaptive && Session.End != KNotOver)
+			{
+				const unsigned NbSets (sizeof (KDifficulties) / sizeof (KDifficulties [0]));
+				unsigned Set (0);
+				while (Set + 1 < NbSets && (KDifficulties [Set].Size != Size || KDifficulties [Set].MaxTimes != MaxTimes
+											|| KDifficulties [Set].NbCandies != NbCandies))
+					++Set;
+				const double Rank (ScorePercentile (KDifficulties [Set], Score));
+				SaveAdaptiveHistory (Ranks, Rank);
+				const CDifficulty & Next (KDifficulties [ChooseDifficulty (PlayerRank (Ranks))]);
+				cout << (Score >= KAdaptiveGoal ? "Objectif atteint" : "Objectif manqué") << " : meilleur que "
+					 << unsigned (Rank) << " % des parties sur cette grille" << endl
+					 << "Prochaine partie adaptative : " << unsigned (Next.Size) << "x" << unsigned (Next.Size) << ", "
+					 << unsigned (Next.MaxTimes) << " coups maximum, " << unsigned (Next.NbCandies) << " numéros différents"
+					 << endl;
+			}
+			#ifndef _WIN32
+				if (Puzzle == NULL && Rules.Classic && ! Adaptive) RecordScore (LevelOf (Size, MaxTimes, NbCandies), Score);
+			#endif
+			cout << endl << "Tapez Entrée pour revenir au menu";
+			string B;
+			getline (cin, B);
+		}
+
+		cin.clear ();
+
+	} // Game ()
+
+
+#ifndef _WIN32
+
+	/*	CONTRE LA MONTRE
+
+		Une partie en temps limité plutôt qu'en nombre de coups. La boucle avance par pas fixes de KTickMs : entre deux pas,
+		poll () attend soit une touche, soit l'heure du pas suivant, sans attente active. Le terminal passe en mode brut pour
+		que les touches arrivent une à une : la ligne en cours de saisie est affichée par le jeu, sous la grille.
+		Un coup est joué dès que sa ligne est validée ; à chaque pas on met à jour le compte à rebours et le minuteur de combo,
+		puis on dessine une image en une seule écriture. La grille n'est redessinée que si elle a changé, sinon seules les
+		lignes d'état le sont. Un coup qui marque dans les KComboMs du précédent multiplie ses points par la longueur de la
+		combo. On mesure la durée de chaque image et le délai entre la validation d'un coup et l'image qui le montre. */
+
+	const unsigned KTickMs = 33;		// Environ 30 images par seconde
+	const unsigned KComboMs = 3000;
+
+	/** @brief Puts the terminal in raw mode while it exists, if the input is a terminal */
+	struct CRawTerminal
+	{
+		termios Saved;
+		bool Raw;
+
+		CRawTerminal () : Raw (isatty (0) && tcgetattr (0, &Saved) == 0)
+		{
+			if (! Raw) return;
+			termios Mode (Saved);
+			Mode.c_lflag &= ~(ICANON | ECHO);
+			Mode.c_cc [VMIN] = 0;
+			Mode.c_cc [VTIME] = 0;
+			tcsetattr (0, TCSANOW, &Mode);
+			cout << "\033[?25l" << flush;	// Cache le curseur
+		}
+
+		~CRawTerminal ()
+		{
+			if (! Raw) return;
+			tcsetattr (0, TCSANOW, &Saved);
+			cout << "\033[?25h" << flush;
+		}
+	};
+
+	/**
+    *@brief Same as DisplayGrid, into a string
+    *@param Frame the grid is appended to it
+    *@param Grid the grid
+    */
+	void AppendGrid (string & Frame, const CMat & Grid)
+	{
+		char Number [16];
+
+		Frame += "    \033[" + KJauneBG + "m\033[" + KNoir + "m";
+		for (unsigned j (0); j < Grid [0].size (); ++j)
+		{
+			snprintf (Number, sizeof (Number), "%2u", j + 1);
+			Frame += Number;
+		}
+		Frame += " \033[" + KReset + "m\n\n";
+
+		for (unsigned i (0); i < Grid.size (); ++i)
+		{
+			snprintf (Number, sizeof (Number), "%2u ", i + 1);
+			Frame += "\033[" + KJauneBG + "m\033[" + KNoir + "m" + Number + "\033[" + KReset + "m ";
+			for (unsigned Cell : Grid [i])
+			{
+				snprintf (Number, sizeof (Number), "%2u", Cell);
+				Frame += Cell != KImpossible ? Number : "  ";
+			}
+			Frame += '\n';
+		}
+		Frame += '\n';
+
+	} // AppendGrid ()
+
+	/**
+    *@brief Time-attack game
+    *@param Level the size and the numbers of the grid (MaxTimes is not used)
+    *@param Seconds the duration of the game
+    *@param InputLineFirst true if the moves are typed "line column direction"
+    *@param Size the size of the grid, 0 for the one of the level
+    */
+	int RunTimeAttack (const CLevel & Level, unsigned Seconds, bool InputLineFirst, unsigned Size = 0)
+	{
+		typedef chrono::steady_clock CClock;
+
+		if (Size == 0) Size = Level.Size;
+		if (Size < 3 || Size > 99 || Level.NbCandies < 3)
+		{
+			cerr << "Taille invalide : entre 3 et 99" << endl;
+			return 1;
+		}
+
+		const CRuleSet & Rules (KRuleSets [CurrentRules]);
+		CRandom Rand (time (NULL));
+		CMat Grid;
+		InitGrid (Grid, Size, Level.NbCandies, Rand);
+		CRunIndex Index;
+		Index.Rebuild (Grid);
+		if (! HasScoringMove (Rules, Index, Grid))
+		{
+			if (! ReshuffleGrid (Rules, Grid, Rand))
+				InitGrid (Grid, Size, Level.NbCandies, Rand);
+			Index.Rebuild (Grid);
+		}
+		CVMatchGroup Groups;
+		CEventStream Events (Size * Size);
+		CTelemetry Telemetry (Events);
+
+		unsigned Score (0), NbMoves (0), Combo (0), MissedTicks (0);
+		string Input, Notice, Frame;
+		vector <float> FrameTimes, Latencies;		// En microsecondes
+		vector <CClock::time_point> PendingMoves;	// Validation des coups pas encore montrés
+		FrameTimes.reserve (Seconds * (1000 / KTickMs) + 16);
+
+		const CClock::duration Tick = chrono::milliseconds (KTickMs);
+		const CClock::time_point Start (CClock::now ()), Deadline (Start + chrono::seconds (Seconds));
+		CClock::time_point NextTick (Start), ComboEnd (Start);
+		bool GridChanged (true), Quit (false);
+
+		{
+			CRawTerminal Terminal;
+
+			while (! Quit)
+			{
+				CClock::time_point Now (CClock::now ());
+
+				/* Entre deux pas : on attend une touche, au plus jusqu'au pas suivant */
+				if (Now < NextTick)
+				{
+					pollfd In {0, POLLIN, 0};
+					const int Timeout (chrono::duration_cast <chrono::milliseconds> (NextTick - Now + chrono::microseconds (999)).count ());
+					if (poll (&In, 1, Timeout) <= 0) continue;
+
+					char Keys [256];
+					const ssize_t NbKeys (read (0, Keys, sizeof (Keys)));
+					if (NbKeys <= 0)
+					{
+						Quit = NbKeys == 0;	// Fin de l'entrée
+						continue;
+					}
+					Now = CClock::now ();
+
+					for (ssize_t k (0); k < NbKeys; ++k)
+					{
+						if (Keys [k] == 127 || Keys [k] == '\b')
+						{
+							if (! Input.empty ()) Input.pop_back ();
+							continue;
+						}
+						if (Keys [k] != '\n' && Keys [k] != '\r')
+						{
+							if (isprint (static_cast <unsigned char> (Keys [k])) && Input.size () < 32) Input += Keys [k];
+							continue;
+						}
+
+						/* Ligne validée : q pour abandonner, i pour un indice, sinon un coup */
+						unsigned First, Second;
+						char Direction;
+						CMove Suggested;
+						if (Input == "q")
+							Quit = true;
+						else if (Input == "i")
+							Notice = Hint (Rules, Index, Grid, Suggested) ? "Indice : ligne " + to_string (Suggested.Pos.first + 1) + ", colonne "
+															+ to_string (Suggested.Pos.second + 1) + ", direction " + Suggested.Direction : "";
+						else if (sscanf (Input.c_str (), "%u %u %c", &First, &Second, &Direction) != 3 || First == 0 || Second == 0)
+							Notice = "Erreur de saisie";
+						else
+						{
+							const CPosition Pos (InputLineFirst ? make_pair (First - 1, Second - 1) : make_pair (Second - 1, First - 1));
+							if (! IsValidPosition (Grid, Pos) || ! Rules.IsValidDirection (Direction) || ! Rules.IsValidMove (Grid, Pos, Direction))
+								Notice = "Mouvement impossible";
+							else
+							{
+								unsigned Points (0);
+								PlayMove (Rules, Index, Grid, Pos, Direction, Points, Groups, &Events);
+								Telemetry.Consume ();
+								++NbMoves;
+
+								const CClock::time_point Played (CClock::now ());
+								Combo = Points == 0 ? 0 : Played < ComboEnd ? Combo + 1 : 1;
+								if (Points != 0) ComboEnd = Played + chrono::milliseconds (KComboMs);
+								Score += Points * max (Combo, 1u);
+								Notice = Points == 0 ? "Aucun point" : "+" + to_string (Points) + (Combo > 1 ? " x" + to_string (Combo) : "");
+
+								/* Plus aucun coup ne marque : la grille est mélangée, ou remplacée s'il ne reste pas assez de numéros */
+								if (! HasScoringMove (Rules, Index, Grid))
+								{
+									if (! ReshuffleGrid (Rules, Grid, Rand))
+										InitGrid (Grid, Size, Level.NbCandies, Rand);
+									Index.Rebuild (Grid);
+								}
+								GridChanged = true;
+								PendingMoves.push_back (Now);
+							}
+						}
+						Input.clear ();
+					}
+					continue;
+				}
+
+				/* Pas de la boucle. Si on a pris du retard, les pas manqués sont sautés plutôt que rattrapés */
+				if (Now - NextTick >= Tick)
+				{
+					MissedTicks += (Now - NextTick) / Tick;
+					NextTick = Now;
+				}
+				NextTick += Tick;
+				if (Now >= Deadline) break;
+				if (Now >= ComboEnd) Combo = 0;
+
+				const double Left (chrono::duration <double> (Deadline - Now).count ());
+				const double ComboLeft (Combo == 0 ? 0 : chrono::duration <double> (ComboEnd - Now).count ());
+				char Status [128];
+				snprintf (Status, sizeof (Status), "Temps : %5.1f s   Score : %u   Coups : %u   Combo : x%u (%.1f s)",
+						  Left, Score, NbMoves, max (Combo, 1u), ComboLeft);
+
+				Frame.clear ();
+				if (GridChanged)
+				{
+					Frame += "\033[H\033[2J";
+					AppendGrid (Frame, Grid);
+				}
+				else
+					Frame += "\033[" + to_string (Size + 4) + ";1H\033[J";	// Début des lignes d'état, sous la grille
+				Frame += Status;
+				Frame += "\n" + Notice + "\n\n"
+					   + (InputLineFirst ? "ligne colonne direction" : "colonne ligne direction") + ", i : indice, q : abandonner\n> "
+					   + Input + "_";
+				if (write (1, Frame.data (), Frame.size ()) < 0) break;
+				GridChanged = false;
+
+				const CClock::time_point Drawn (CClock::now ());
+				FrameTimes.push_back (chrono::duration <float, micro> (Drawn - Now).count ());
+				for (const CClock::time_point & Validated : PendingMoves)
+					Latencies.push_back (chrono::duration <float, micro> (Drawn - Validated).count ());
+				PendingMoves.clear ();
+			}
+		}
+
+		sort (FrameTimes.begin (), FrameTimes.end ());
+		sort (Latencies.begin (), Latencies.end ());
+		auto Percentile = [] (const vector <float> & Values, double P) { return Values.empty () ? 0.f : Values [unsigned (P * (Values.size () - 1))]; };
+
+		cout << "\033[H\033[2J";
+		DisplayGrid (Grid);
+		cout << (Quit ? "Partie abandonnée" : "Temps écoulé !") << " Score : " << Score << " en " << NbMoves << " coups, "
+			 << Telemetry.NbRemovals << " suppressions, plus longue réaction en chaîne : " << Telemetry.LongestChain << endl
+			 << fixed << setprecision (0)
+			 << "Images         : " << FrameTimes.size () << ", " << MissedTicks << " pas manqués" << endl
+			 << "Durée image    : p50 " << Percentile (FrameTimes, 0.5) << " us, p99 " << Percentile (FrameTimes, 0.99)
+			 << " us, max " << Percentile (FrameTimes, 1) << " us" << endl
+			 << "Délai d'un coup: p50 " << Percentile (Latencies, 0.5) / 1000 << " ms, p99 " << Percentile (Latencies, 0.99) / 1000
+			 << " ms, max " << Percentile (Latencies, 1) / 1000 << " ms" << endl;
+		cout.unsetf (ios::floatfield);
+		return 0;
+
+	} // RunTimeAttack ()
+
+	/**
+    *@brief Time-attack menu : chooses the level, then plays
+    *@param OptionsChoices the options, for the order of the line and the column
+    */
+	void TimeAttack (const array <unsigned, 2> & OptionsChoices)
+	{
+		unsigned ChoixLevel;
+		do {
+			ClearScreen ();
+			cout << '\t' << "Contre la montre : marquer le plus de points en " << 60 << " secondes" << endl << endl;
+			for (unsigned l (0); l < KLevels.size (); ++l)
+				cout << l + 1 << " - " << KLevels [l].Size << "x" << KLevels [l].Size << ", "
+					 << KLevels [l].NbCandies << " numéros différents" << endl;
+			cout << KLevels.size () + 1 << " - Règles : " << KRuleSets [CurrentRules].Name << endl << endl;
+
+			MenuPrompt (ChoixLevel, KLevels.size () + 1);
+			if (ChoixLevel == KLevels.size () + 1) ChooseRules ();
+
+		} while (ChoixLevel == KLevels.size () + 1);
+		RunTimeAttack (KLevels [ChoixLevel - 1], 60, OptionsChoices [1] == 0);
+
+		cout << endl << "Tapez Entrée pour revenir au menu";
+		string B;
+		getline (cin, B);
+
+	} // TimeAttack ()
+
+#endif
+
+	/**
+    *@brief Compares the specialized kernels with the generic ones on the sizes of the levels (mode --bench)
+    */
+	int RunBenchmark ()
+	{
+		const unsigned NbBoards (2000);
+		const unsigned NbRounds (50);
+		const unsigned NbCandies (4);
+		bool SameResults (true);
+
+		CRandom Rand (time (NULL));
+		for (unsigned Size : {6u, 8u})
+		{
+			/* Grilles aléatoires, avec des suites pour que ArrangeGrid ait du travail */
+			vector <CMat> Boards (NbBoards, CMat (Size, CVLine (Size)));
+			for (CMat & Board : Boards)
+				for (CVLine & Line : Board)
+					for (unsigned & Cell : Line)
+						Cell = (Rand () % NbCandies) + 1;
+
+			CMat Work (Size, CVLine (Size));
+			unsigned ScoreGeneric (0), ScoreFixed (0);
+
+			chrono::steady_clock::time_point Start (chrono::steady_clock::now ());
+			for (unsigned Round (0); Round < NbRounds; ++Round)
+				for (const CMat & Board : Boards)
+				{
+					for (unsigned i (0); i < Size; ++i) Work [i] = Board [i];
+					CDynBoard Dyn {Work};
+					ArrangeBoard (Dyn, ScoreGeneric);
+				}
+			double GenericArrange (ElapsedNs (Start) / (NbRounds * NbBoards));
+
+			Start = chrono::steady_clock::now ();
+			for (unsigned Round (0); Round < NbRounds; ++Round)
+				for (const CMat & Board : Boards)
+				{
+					for (unsigned i (0); i < Size; ++i) Work [i] = Board [i];
+					ArrangeGrid (Work, ScoreFixed);
+				}
+			double FixedArrange (ElapsedNs (Start) / (NbRounds * NbBoards));
+
+			/* Génération des coups sur des grilles de départ (sans suite) */
+			for (CMat & Board : Boards)
+				InitGrid (Board, Size, NbCandies, Rand);
+
+			CVMove Moves;
+			Moves.reserve (2 * Size * Size);
+			unsigned long NbGeneric (0), NbFixed (0);
+
+			Start = chrono::steady_clock::now ();
+			for (unsigned Round (0); Round < NbRounds; ++Round)
+				for (const CMat & Board : Boards)
+				{
+					for (unsigned i (0); i < Size; ++i) Work [i] = Board [i];
+					CDynBoard Dyn {Work};
+					ListBoardScoringMoves (Dyn, Moves);
+					NbGeneric += Moves.size ();
+				}
+			double GenericMoves (ElapsedNs (Start) / (NbRounds * NbBoards));
+
+			Start = chrono::steady_clock::now ();
+			for (unsigned Round (0); Round < NbRounds; ++Round)
+				for (const CMat & Board : Boards)
+				{
+					ListScoringMoves (Board, Moves);
+					NbFixed += Moves.size ();
+				}
+			double FixedMoves (ElapsedNs (Start) / (NbRounds * NbBoards));
+
+			SameResults = SameResults && ScoreGeneric == ScoreFixed && NbGeneric == NbFixed;
+
+			cout << "Grille " << Size << "x" << Size << endl
+				 << "  ArrangeGrid      : générique " << setw (8) << fixed << setprecision (1) << GenericArrange << " ns, spécialisé "
+				 << setw (8) << FixedArrange << " ns (x" << setprecision (2) << GenericArrange / FixedArrange << ")" << endl
+				 << "  Coups possibles  : générique " << setw (8) << setprecision (1) << GenericMoves << " ns, spécialisé "
+				 << setw (8) << FixedMoves << " ns (x" << setprecision (2) << GenericMoves / FixedMoves << ")" << endl;
+
+			/* Évaluation des feuilles d'un solveur : chaque échange possible joué sur sa propre copie de la grille */
+			CVMove AllMoves;
+			for (unsigned i (0); i < Size; ++i)
+				for (unsigned j (0); j < Size; ++j)
+				{
+					if (j + 1 < Size) AllMoves.push_back (CMove {make_pair (i, j), KeyRight});
+					if (i + 1 < Size) AllMoves.push_back (CMove {make_pair (i, j), KeyDown});
+				}
+			vector <unsigned> Expected (AllMoves.size ()), Points;
+			unsigned long PointsOneByOne (0);
+
+			Start = chrono::steady_clock::now ();
+			for (const CMat & Board : Boards)
+				for (unsigned m (0); m < AllMoves.size (); ++m)
+				{
+					for (unsigned i (0); i < Size; ++i) Work [i] = Board [i];
+					MakeAMove (Work, AllMoves [m].Pos, AllMoves [m].Direction);
+					Expected [m] = 0;
+					ArrangeGrid (Work, Expected [m]);
+					PointsOneByOne += Expected [m];
+				}
+			const double OneByOne (ElapsedNs (Start) / (NbBoards * AllMoves.size ()));
+			cout << "  Feuilles         : une à une " << setw (7) << setprecision (1) << OneByOne << " ns";
+
+			for (CBatchKernel Kernel : {KScalarKernel, KVectorKernel, KAvx2Kernel})
+			{
+				if (Kernel > BestBatchKernel ()) break;
+
+				unsigned long PointsBatch (0);
+				Start = chrono::steady_clock::now ();
+				for (const CMat & Board : Boards)
+				{
+					EvaluateMoves (Board, AllMoves, Points, Kernel);
+					for (unsigned Value : Points) PointsBatch += Value;
+				}
+				const double Batch (ElapsedNs (Start) / (NbBoards * AllMoves.size ()));
+				SameResults = SameResults && PointsBatch == PointsOneByOne;
+				cout << ", " << KBatchKernelNames [Kernel] << " " << setprecision (1) << Batch << " ns (x" << setprecision (2)
+					 << OneByOne / Batch << ")";
+			}
+			cout << endl;
+		}
+
+		if (! SameResults)
+		{
+			cerr << "Erreur : les noyaux spécialisés et génériques ne donnent pas le même résultat" << endl;
+			return 1;
+		}
+		return 0;
+
+	} // RunBenchmark ()
+
+	/*	MODE SERVEUR
+
+		Un seul processus héberge autant de parties que de connexions. Chaque connexion possède sa propre partie (CSession),
+		la boucle d'événements epoll traite toutes les connexions sur un seul thread. Le protocole est en texte, une requête
+		et une réponse par ligne :
+
+			N <niveau> <graine>				nouvelle partie			-> OK <taille> <coups max> <nb numéros>
+			M <ligne> <colonne> <direction>	jouer un coup			-> OK <points gagnés> <score> <coups restants>
+			S								état de la partie		-> E <taille> <score> <coups joués> <coups max> <cases>
+			H								indice					-> H <ligne> <colonne> <direction> <longueur de la suite>
+			W								sauvegarde				-> W <sauvegarde cryptée, même format que dans saves/, sans l'en-tête>
+			Q								fermer la connexion
+
+		Toute requête invalide reçoit "ERR <raison>". Les parties inactives trop longtemps sont fermées. Quand un coup laisse
+		une grille où plus aucun échange ne rapporte de points, elle est mélangée : la requête S donne la nouvelle grille. */
+
+#ifdef __linux__
+
+	/** @brief Maximum length of a request line */
+	const unsigned KMaxRequest = 64;
+
+	/** @brief Maximum amount of unsent answers before a client that does not read is disconnected */
+	const size_t KMaxPendingOutput = 1 << 16;
+
+	/** @brief Set by SIGINT / SIGTERM to stop the server */
+	volatile sig_atomic_t ServerStop (0);
+
+	/**
+    *@brief Builds a socket address : a number is a TCP port on localhost, anything else is a Unix socket path
+    *@param Address the address given on the command line
+    *@param Addr the socket address to fill
+    *@param Len the length of the address
+    */
+	int MakeSocketAddress (const string & Address, sockaddr_storage & Addr, socklen_t & Len)
+	{
+		memset (&Addr, 0, sizeof (Addr));
+
+		if (! Address.empty () && Address.find_first_not_of ("0123456789") == string::npos)
+		{
+			sockaddr_in & Inet (reinterpret_cast <sockaddr_in &> (Addr));
+			Inet.sin_family = AF_INET;
+			Inet.sin_port = htons (strtoul (Address.c_str (), NULL, 10));
+			Inet.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+			Len = sizeof (Inet);
+			return AF_INET;
+		}
+
+		sockaddr_un & Unix (reinterpret_cast <sockaddr_un &> (Addr));
+		if (Address.size () >= sizeof (Unix.sun_path)) return -1;
+		Unix.sun_family = AF_UNIX;
+		strcpy (Unix.sun_path, Address.c_str ());
+		Len = sizeof (Unix);
+		return AF_UNIX;
+
+	} // MakeSocketAddress ()
+
+	/**
+    *@brief Raises the limit of open files as high as allowed, one descriptor being used per session
+    */
+	void RaiseFileLimit ()
+	{
+		rlimit Limit;
+		if (getrlimit (RLIMIT_NOFILE, &Limit) == 0 && Limit.rlim_cur < Limit.rlim_max)
+		{
+			Limit.rlim_cur = Limit.rlim_max;
+			setrlimit (RLIMIT_NOFILE, &Limit);
+		}
+
+	} // RaiseFileLimit ()
+
+	/**
+    *@brief Reads an unsigned number in a request and moves the cursor after it
+    *@param Cursor the position in the request
+    *@param Value the number read
+    */
+	bool ParseNumber (const char * & Cursor, unsigned & Value)
+	{
+		while (*Cursor == ' ') ++Cursor;
+		if (! isdigit (*Cursor)) return false;
+
+		Value = 0;
+		for (; isdigit (*Cursor); ++Cursor)
+		{
+			const unsigned Digit (*Cursor - '0');
+			if (Value > (numeric_limits <uint32_t>::max () - Digit) / 10) return false;
+			Value = Value * 10 + Digit;
+		}
+		return true;
+
+	} // ParseNumber ()
+
+	/**
+    *@brief Answers a request of the protocol
+    *@param Session the session of the connection
+    *@param Request the request line, without the line feed
+    *@param Out the answer is appended to it
+    *@return false if the connection must be closed
+    */
+	bool HandleRequest (CSession & Session, const char * Request, string & Out)
+	{
+		const char * Cursor (Request + 1);
+		unsigned First, Second;
+		char Buffer [64];
+
+		switch (Request [0])
+		{
+			case 'N':
+				if (! ParseNumber (Cursor, First) || ! ParseNumber (Cursor, Second) || First < 1 || First > KLevels.size ())
+				{
+					Out += "ERR niveau invalide\n";
+					break;
+				}
+				NewSession (Session, KLevels [First - 1], Second);
+				snprintf (Buffer, sizeof (Buffer), "OK %u %u %u\n", Session.Size, Session.MaxTimes, Session.NbCandies);
+				Out += Buffer;
+				break;
+
+			case 'M':
+			{
+				if (Session.Size == 0)
+				{
+					Out += "ERR pas de partie\n";
+					break;
+				}
+				if (! ParseNumber (Cursor, First) || ! ParseNumber (Cursor, Second))
+				{
+					Out += "ERR coup invalide\n";
+					break;
+				}
+				while (*Cursor == ' ') ++Cursor;
+
+				const unsigned Before (Session.Score);
+				if (First == 0 || Second == 0 || ! PlaySessionMove (Session, make_pair (First - 1, Second - 1), *Cursor))
+				{
+					Out += Session.End != KNotOver ? "ERR partie terminee\n" : "ERR coup invalide\n";
+					break;
+				}
+				snprintf (Buffer, sizeof (Buffer), "OK %u %u %u\n", Session.Score - Before, Session.Score, Session.MaxTimes - Session.NbMoves);
+				Out += Buffer;
+				break;
+			}
+
+			case 'S':
+				if (Session.Size == 0)
+				{
+					Out += "ERR pas de partie\n";
+					break;
+				}
+				snprintf (Buffer, sizeof (Buffer), "E %u %u %u %u ", Session.Size, Session.Score, Session.NbMoves, Session.MaxTimes);
+				Out += Buffer;
+				for (const CVLine & Line : Session.Grid)
+					for (unsigned Cell : Line)
+						Out += char ('0' + Cell);
+				Out += '\n';
+				break;
+
+			case 'H':
+			{
+				if (Session.Size == 0)
+				{
+					Out += "ERR pas de partie\n";
+					break;
+				}
+				CMove Move;
+				if (! Session.Index.Hint (Move))
+				{
+					Out += "ERR aucun coup\n";
+					break;
+				}
+				snprintf (Buffer, sizeof (Buffer), "H %u %u %c %u\n", Move.Pos.first + 1, Move.Pos.second + 1, Move.Direction,
+						  Session.Index.SwapRunLength (Move.Pos, Move.Direction));
+				Out += Buffer;
+				break;
+			}
+
+			case 'W':
+			{
+				if (Session.Size == 0)
+				{
+					Out += "ERR pas de partie\n";
+					break;
+				}
+				static thread_local string SaveBuffer;
+				EncodeSave (SaveBuffer, Session.Grid, Session.NbMoves, Session.Score, Session.BestScore, Session.Size, KeyTab, Session.MaxTimes);
+				Out += "W ";
+				Out += SaveBuffer;
+				Out += '\n';
+				break;
+			}
+
+			case 'Q':
+				return false;
+
+			default:
+				Out += "ERR commande inconnue\n";
+		}
+		return true;
+
+	} // HandleRequest ()
+
+	/** @brief A client of the server and its game */
+	struct CConnection
+	{
+		int Fd;
+		char In [KMaxRequest];
+		unsigned InSize = 0;
+		string Out;
+		size_t OutPos = 0;
+		time_t LastActivity;
+		CSession Session;
+	};
+
+	/**
+    *@brief Sends as much of the pending answers as the socket accepts
+    *@param Connection the client
+    *@return false if the connection is broken
+    */
+	bool FlushConnection (CConnection & Connection)
+	{
+		while (Connection.OutPos < Connection.Out.size ())
+		{
+			ssize_t Sent (send (Connection.Fd, Connection.Out.data () + Connection.OutPos, Connection.Out.size () - Connection.OutPos, MSG_NOSIGNAL));
+			if (Sent < 0)
+				return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+			Connection.OutPos += Sent;
+		}
+		Connection.Out.clear ();
+		Connection.OutPos = 0;
+		return true;
+
+	} // FlushConnection ()
+
+	/**
+    *@brief Reads the requests of a client and answers them
+    *@param Connection the client
+    *@param NbRequests increased by the number of requests handled
+    *@return false if the connection must be closed
+    */
+	bool ServeConnection (CConnection & Connection, unsigned long & NbRequests)
+	{
+		for (;;)
+		{
+			ssize_t Received (recv (Connection.Fd, Connection.In + Connection.InSize, KMaxRequest - Connection.InSize, 0));
+			if (Received == 0) return false;
+			if (Received < 0)
+			{
+				if (errno == EINTR) continue;
+				if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+				return false;
+			}
+
+			/* Traite toutes les lignes complètes, garde le reste pour la prochaine lecture */
+			unsigned Begin (0), End (Connection.InSize + Received);
+			for (unsigned i (Connection.InSize); i < End; ++i)
+			{
+				if (Connection.In [i] != '\n') continue;
+
+				Connection.In [i] = '\0';
+				if (i > Begin && Connection.In [i - 1] == '\r') Connection.In [i - 1] = '\0';
+				++NbRequests;
+				if (! HandleRequest (Connection.Session, Connection.In + Begin, Connection.Out))
+					return false;
+				Begin = i + 1;
+			}
+			memmove (Connection.In, Connection.In + Begin, End - Begin);
+			Connection.InSize = End - Begin;
+
+			if (Connection.InSize == KMaxRequest) return false; // Requête trop longue
+		}
+		return Connection.Out.size () - Connection.OutPos < KMaxPendingOutput;
+
+	} // ServeConnection ()
+
+	/**
+    *@brief Runs the game server until SIGINT or SIGTERM (mode --server)
+    *@param Address Unix socket path, or TCP port on localhost
+    *@param IdleTimeout seconds of inactivity after which a session is closed
+    */
+	int RunServer (const string & Address, unsigned IdleTimeout)
+	{
+		sockaddr_storage Addr;
+		socklen_t Len;
+		int Family (MakeSocketAddress (Address, Addr, Len));
+		if (Family < 0)
+		{
+			cerr << "Adresse invalide : " << Address << endl;
+			return 1;
+		}
+
+		signal (SIGPIPE, SIG_IGN);
+		signal (SIGINT, [] (int) { ServerStop = 1; });
+		signal (SIGTERM, [] (int) { ServerStop = 1; });
+		RaiseFileLimit ();
+
+		if (Family == AF_UNIX) unlink (Address.c_str ());
+		int Listener (socket (Family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+		int One (1);
+		if (Listener < 0 || setsockopt (Listener, SOL_SOCKET, SO_REUSEADDR, &One, sizeof (One)) < 0 || bind (Listener, reinterpret_cast <sockaddr *> (&Addr), Len) < 0 || listen (Listener, SOMAXCONN) < 0)
+		{
+			cerr << "Impossible d'écouter sur " << Address << " : " << strerror (errno) << endl;
+			return 1;
+		}
+
+		int Epoll (epoll_create1 (EPOLL_CLOEXEC));
+		epoll_event Event;
+		Event.events = EPOLLIN;
+		Event.data.fd = Listener;
+		epoll_ctl (Epoll, EPOLL_CTL_ADD, Listener, &Event);
+
+		vector <unique_ptr <CConnection>> Connections; // Indexé par descripteur de fichier
+		vector <unique_ptr <CConnection>> Spare; // Connexions fermées, réutilisées avec leur grille et leurs tampons
+		unsigned NbSessions (0);
+		unsigned long NbRequests (0);
+		time_t LastSweep (time (NULL));
+
+		auto Close = [&] (int Fd)
+		{
+			close (Fd); // Retire aussi le descripteur de l'epoll
+			CConnection & Connection (*Connections [Fd]);
+			Connection.InSize = 0;
+			Connection.Out.clear ();
+			Connection.OutPos = 0;
+			Connection.Session.Size = 0;
+			Spare.push_back (move (Connections [Fd]));
+			--NbSessions;
+		};
+
+		cout << "Serveur KittyCrush en écoute sur " << Address << endl;
+
+		const int KMaxEvents (512);
+		epoll_event Events [KMaxEvents];
+		while (! ServerStop)
+		{
+			int NbEvents (epoll_wait (Epoll, Events, KMaxEvents, 1000));
+			time_t Now (time (NULL));
+
+			for (int e (0); e < NbEvents; ++e)
+			{
+				int Fd (Events [e].data.fd);
+				if (Fd == Listener)
+				{
+					int Client;
+					while ((Client = accept4 (Listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+					{
+						if (Family == AF_INET) setsockopt (Client, IPPROTO_TCP, TCP_NODELAY, &One, sizeof (One));
+						if (unsigned (Client) >= Connections.size ()) Connections.resize (Client + 1024);
+						if (Spare.empty ())
+							Connections [Client].reset (new CConnection);
+						else
+						{
+							Connections [Client] = move (Spare.back ());
+							Spare.pop_back ();
+						}
+						Connections [Client] -> Fd = Client;
+						Connections [Client] -> LastActivity = Now;
+						++NbSessions;
+
+						Event.events = EPOLLIN | EPOLLRDHUP;
+						Event.data.fd = Client;
+						epoll_ctl (Epoll, EPOLL_CTL_ADD, Client, &Event);
+					}
+					continue;
+				}
+
+				CConnection & Connection (*Connections [Fd]);
+				bool HadPending (Connection.OutPos < Connection.Out.size ());
+				Connection.LastActivity = Now;
+
+				/* Les réponses déjà prêtes partent même si la connexion doit être fermée (requête Q) */
+				bool KeepOpen (! (Events [e].events & (EPOLLERR | EPOLLHUP))
+							   && (! (Events [e].events & (EPOLLIN | EPOLLRDHUP)) || ServeConnection (Connection, NbRequests)));
+				if (! FlushConnection (Connection) || ! KeepOpen)
+				{
+					Close (Fd);
+					continue;
+				}
+
+				/* On ne surveille l'écriture que si des réponses n'ont pas pu partir */
+				bool Pending (Connection.OutPos < Connection.Out.size ());
+				if (Pending != HadPending)
+				{
+					Event.events = EPOLLIN | EPOLLRDHUP | (Pending ? uint32_t (EPOLLOUT) : 0u);
+					Event.data.fd = Fd;
+					epoll_ctl (Epoll, EPOLL_CTL_MOD, Fd, &Event);
+				}
+			}
+
+			/* Ferme les parties inactives, au plus une fois par seconde */
+			if (Now != LastSweep)
+			{
+				LastSweep = Now;
+				for (unique_ptr <CConnection> & Connection : Connections)
+					if (Connection && unsigned (Now - Connection -> LastActivity) > IdleTimeout)
+						Close (Connection -> Fd);
+			}
+		}
+
+		cout << endl << "Arrêt du serveur : " << NbSessions << " parties ouvertes, " << NbRequests << " requêtes traitées" << endl;
+		close (Epoll);
+		close (Listener);
+		if (Family == AF_UNIX) unlink (Address.c_str ());
+		return 0;
+
+	} // RunServer ()
+
+	/** @brief A simulated player of the load generator */
+	struct CLoadClient
+	{
+		int Fd;
+		CRandom Rand;
+		unsigned Size;
+		char In [KMaxRequest];
+		unsigned InSize;
+		chrono::steady_clock::time_point Sent;
+
+		CLoadClient (int Socket, uint32_t Seed) : Fd (Socket), Rand (Seed), Size (0), InSize (0) {}
+	};
+
+	/**
+    *@brief Sends the next request of a simulated player : a random move, or a new game when the last one is over
+    *@param Client the simulated player
+    *@param NewGame true to start a new game
+    */
+	bool SendLoadRequest (CLoadClient & Client, bool NewGame)
+	{
+		char Request [KMaxRequest];
+		int Length;
+
+		if (NewGame)
+			Length = snprintf (Request, sizeof (Request), "N %u %u\n", unsigned (Client.Rand () % KLevels.size ()) + 1, Client.Rand ());
+		else
+		{
+			/* Une case et une direction qui restent dans la grille */
+			const char Directions [] = {KeyUp, KeyDown, KeyLeft, KeyRight};
+			unsigned Line (Client.Rand () % Client.Size), Column (Client.Rand () % Client.Size);
+			char Direction (Directions [Client.Rand () % 4]);
+			if ((Direction == KeyUp && Line == 0) || (Direction == KeyDown && Line + 1 == Client.Size)) Direction = KeyLeft;
+			if ((Direction == KeyLeft && Column == 0) || (Direction == KeyRight && Column + 1 == Client.Size))
+				Direction = Column == 0 ? KeyRight : KeyLeft;
+			Length = snprintf (Request, sizeof (Request), "M %u %u %c\n", Line + 1, Column + 1, Direction);
+		}
+
+		Client.Sent = chrono::steady_clock::now ();
+		return send (Client.Fd, Request, Length, MSG_NOSIGNAL) == Length;
+
+	} // SendLoadRequest ()
+
+	/**
+    *@brief Load generator for the server (mode --loadgen) : many simulated players each keeping one request in flight
+    *@param Address the address of the server
+    *@param NbClients how many simultaneous sessions
+    *@param Duration how many seconds to run
+    */
+	int RunLoadGenerator (const string & Address, unsigned NbClients, unsigned Duration)
+	{
+		sockaddr_storage Addr;
+		socklen_t Len;
+		int Family (MakeSocketAddress (Address, Addr, Len));
+		if (Family < 0)
+		{
+			cerr << "Adresse invalide : " << Address << endl;
+			return 1;
+		}
+		RaiseFileLimit ();
+
+		int Epoll (epoll_create1 (EPOLL_CLOEXEC));
+		vector <CLoadClient> Clients;
+		Clients.reserve (NbClients);
+
+		for (unsigned c (0); c < NbClients; ++c)
+		{
+			int Fd (socket (Family, SOCK_STREAM | SOCK_CLOEXEC, 0));
+			if (Fd < 0 || connect (Fd, reinterpret_cast <sockaddr *> (&Addr), Len) < 0)
+			{
+				cerr << "Connexion " << c + 1 << " impossible : " << strerror (errno) << endl;
+				return 1;
+			}
+			int One (1);
+			if (Family == AF_INET) setsockopt (Fd, IPPROTO_TCP, TCP_NODELAY, &One, sizeof (One));
+			fcntl (Fd, F_SETFL, O_NONBLOCK);
+
+			Clients.push_back (CLoadClient (Fd, c * 2654435761u + 1));
+			epoll_event Event;
+			Event.events = EPOLLIN;
+			Event.data.u32 = c;
+			epoll_ctl (Epoll, EPOLL_CTL_ADD, Fd, &Event);
+			SendLoadRequest (Clients.back (), true);
+		}
+		cout << NbClients << " sessions ouvertes sur " << Address << ", charge pendant " << Duration << " s..." << endl;
+
+		unsigned long NbMoves (0), NbGames (0), NbErrors (0);
+		vector <float> Latencies; // Échantillon des temps de réponse, en microsecondes
+		Latencies.reserve (1 << 20);
+
+		const chrono::steady_clock::time_point Start (chrono::steady_clock::now ());
+		const chrono::steady_clock::time_point End (Start + chrono::seconds (Duration));
+		const int KMaxEvents (512);
+		epoll_event Events [KMaxEvents];
+
+		while (chrono::steady_clock::now () < End)
+		{
+			int NbEvents (epoll_wait (Epoll, Events, KMaxEvents, 100));
+			for (int e (0); e < NbEvents; ++e)
+			{
+				CLoadClient & Client (Clients [Events [e].data.u32]);
+				ssize_t Received (recv (Client.Fd, Client.In + Client.InSize, KMaxRequest - 1 - Client.InSize, 0));
+				if (Received <= 0)
+				{
+					if (Received < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+					cerr << "Connexion fermée par le serveur" << endl;
+					return 1;
+				}
+				Client.InSize += Received;
+				Client.In [Client.InSize] = '\0';
+
+				char * LineEnd (strchr (Client.In, '\n'));
+				if (LineEnd == NULL) continue;
+				*LineEnd = '\0';
+
+				if (Latencies.size () < Latencies.capacity ())
+					Latencies.push_back (ElapsedNs (Client.Sent) / 1000);
+
+				/* Réponse à une nouvelle partie : "OK taille ...", à un coup : "OK gain score restants" ou "ERR ..." */
+				bool NewGame (false);
+				unsigned A, B, C;
+				if (Client.Size == 0)
+				{
+					NewGame = sscanf (Client.In, "OK %u", &Client.Size) != 1;
+					++NbGames;
+				}
+				else if (sscanf (Client.In, "OK %u %u %u", &A, &B, &C) == 3)
+				{
+					++NbMoves;
+					NewGame = C == 0;
+				}
+				else
+				{
+					++NbErrors;
+					NewGame = strstr (Client.In, "terminee") != NULL;
+				}
+				if (NewGame) Client.Size = 0;
+
+				Client.InSize = 0;
+				if (! SendLoadRequest (Client, NewGame))
+				{
+					cerr << "Envoi impossible : " << strerror (errno) << endl;
+					return 1;
+				}
+			}
+		}
+
+		const double Seconds (ElapsedNs (Start) / 1e9);
+		sort (Latencies.begin (), Latencies.end ());
+		auto Percentile = [&] (double P) { return Latencies.empty () ? 0.f : Latencies [unsigned (P * (Latencies.size () - 1))]; };
+
+		cout << fixed << setprecision (0)
+			 << "Coups joués    : " << NbMoves << " (" << NbMoves / Seconds << " coups/s)" << endl
+			 << "Refusés        : " << NbErrors << endl
+			 << "Parties        : " << NbGames << endl
+			 << "Requêtes       : " << (NbMoves + NbErrors + NbGames) / Seconds << " req/s" << endl
+			 << setprecision (1)
+			 << "Temps réponse  : p50 " << Percentile (0.5) << " us, p99 " << Percentile (0.99) << " us, max " << Percentile (1) << " us" << endl;
+
+		for (CLoadClient & Client : Clients)
+			close (Client.Fd);
+		close (Epoll);
+		return 0;
+
+	} // RunLoadGenerator ()
+
+#endif // __linux__
+
+	/**
+    *@brief Checks that playing does not allocate once a session is warmed up (mode --check-alloc)
+    * Plays new games, moves, state and save requests on every level, and fails if any of them allocates
+    */
+	int RunAllocationCheck ()
+	{
+		const unsigned NbGames (20000);
+		CSession Session;
+		CVMove Moves;
+		Moves.reserve (2 * 8 * 8);
+		string Buffer;
+		#ifdef __linux__
+			string Out;
+			char Request [KMaxRequest];
+		#endif
+		CRandom Rand (1);
+
+		unsigned long NbMoves (0), Before (0);
+		for (unsigned Game (0); Game < NbGames + KLevels.size (); ++Game)
+		{
+			/* Les premières parties, une par niveau, servent à atteindre la taille définitive de chaque tampon */
+			if (Game == KLevels.size ()) Before = NbAllocations;
+
+			NewSession (Session, KLevels [Game % KLevels.size ()], Rand ());
+			while (Session.NbMoves < Session.MaxTimes)
+			{
+				Session.Index.ListScoringMoves (Moves);
+				if (Moves.empty ()) break;
+				const CMove & Move (Moves [Rand () % Moves.size ()]);
+				PlaySessionMove (Session, Move.Pos, Move.Direction);
+				EncodeSave (Buffer, Session.Grid, Session.NbMoves, Session.Score, Session.BestScore, Session.Size, KeyTab, Session.MaxTimes);
+				++NbMoves;
+
+				#ifdef __linux__
+					/* Même chemin que le serveur */
+					Out.clear ();
+					snprintf (Request, sizeof (Request), "M %u %u %c", Rand () % Session.Size + 1, Rand () % Session.Size + 1, KeyLeft);
+					HandleRequest (Session, Request, Out);
+					HandleRequest (Session, "S", Out);
+					HandleRequest (Session, "W", Out);
+				#endif
+			}
+		}
+
+		const unsigned long NbFound (NbAllocations - Before);
+		cout << NbGames << " parties, " << NbMoves << " coups : " << NbFound << " allocations" << endl;
+		if (NbFound != 0)
+		{
+			cerr << "Erreur : le traitement d'un coup ne doit faire aucune allocation" << endl;
+			return 1;
+		}
+		return 0;
+
+	} // RunAllocationCheck ()
+
+	/*	VÉRIFICATION DES MOTEURS
+
+		Le mode --check-engines joue des parties au hasard sur tous les cœurs en faisant avancer côte à côte, coup par coup,
+		le moteur de référence et ceux du jeu : noyaux spécialisés ou génériques (PlayMove), index des suites (PlayMove avec
+		CRunIndex) et les événements qu'il publie, liste des coups qui rapportent et évaluation par lots (EvaluateMoves).
+		Après chaque coup, grilles et scores doivent être identiques ; en fin de partie, la sauvegarde doit être celle
+		qu'écrivait le Save d'origine et se relire à l'identique. Les formes n'existaient pas dans le moteur d'origine : la
+		référence trouve les groupes avec FindMatchGroups, comme le jeu, mais les supprime case par case avec RemovalInRow
+		avant de chercher les suites comme le faisait ArrangeGrid. L'évaluation par lots garde la suppression d'origine, sans
+		les formes : elle est comparée à ArrangeGrid d'origine.
+
+		À la première différence, tout s'arrête et la partie est écrite dans un fichier de rejeu, réduite si possible à la
+		grille d'avant le coup fautif et à ce seul coup ; --check-replay la rejoue en montrant ce que donne chaque moteur.
+		Format du rejeu (texte) : "KCRP 1", "hauteur largeur coups" (coups permis dans la partie, pour
+		sa sauvegarde), une ligne par rangée de la grille, le nombre de coups, puis
+		un coup par ligne : "ligne colonne bas|droite", numérotées à partir de 0. */
+
+	/** @brief Sizes checked : those of the levels, and others that go through the generic kernels */
+	const array <CLevel, 6> KCheckedLevels {{ {6, 6, 4}, {8, 9, 4}, {6, 8, 5}, {8, 11, 5}, {7, 12, 4}, {11, 15, 6} }};
+
+	/** @brief Every engine of the game, played in lockstep with the reference one */
+	class CEngineCheck
+	{
+		CMat RefGrid, Generic, Indexed, Replayed, Copy;
+		unsigned RefScore, GenericScore, IndexScore;
+		CRunIndex Index;
+		CEventStream Events;
+		CEventReader Reader;
+		CVMatchGroup Groups;
+		vector <unsigned> Cells;
+		CVMove Moves;
+		vector <unsigned> Points;
+
+		/** @brief Plays a move on the reference grid with the original functions, the groups of the move being removed first */
+		void PlayReference (const CMove & Move)
+		{
+			MakeAMove (RefGrid, Move.Pos, Move.Direction);
+			const CPosition Changed [2] = {Move.Pos, NeighbourOf (Move.Pos, Move.Direction)};
+			FindMatchGroups (RefGrid, Changed, 2, Groups, Cells);
+
+			unsigned PointsEarned (0), ComboMeter (0);
+			for (const CMatchGroup & Group : Groups)
+			{
+				RefScore += KShapeRules [Group.Shape].Bonus;
+				for (unsigned i (1); i <= Group.NbCells; ++i)
+					PointsEarned += i;
+				++ComboMeter;
+			}
+
+			/* Case par case en partant du haut, comme une suite d'une case dans sa ligne : seules les cases du dessus tombent */
+			const unsigned Width (RefGrid [0].size ());
+			sort (Cells.begin (), Cells.end ());
+			for (unsigned Cell : Cells)
+				Reference::RemovalInRow (RefGrid, make_pair (Cell / Width, Cell % Width), 1);
+
+			CPosition Pos;
+			unsigned HowMany;
+			while (Reference::AtLeastThreeInARow (RefGrid, Pos, HowMany))
+			{
+				Reference::RemovalInRow (RefGrid, Pos, HowMany);
+				++ComboMeter;
+				for (unsigned i (1); i <= HowMany; ++i)
+					PointsEarned += i;
+			}
+			while (Reference::AtLeastThreeInAColumn (RefGrid, Pos, HowMany))
+			{
+				Reference::RemovalInColumn (RefGrid, Pos, HowMany);
+				++ComboMeter;
+				for (unsigned i (1); i <= HowMany; ++i)
+					PointsEarned += i;
+			}
+			RefScore += PointsEarned * ComboMeter;
+		}
+
+	  public:
+		const char * Engine;	// Le moteur qui diffère de la référence, NULL tant qu'il n'y en a pas
+
+		CEngineCheck () : RefScore (0), GenericScore (0), IndexScore (0), Reader (Events), Engine (NULL) {}
+
+		const CMat & Grid () const { return RefGrid; }
+
+		/** @brief Starts a game on the grid */
+		void Start (const CMat & Grid)
+		{
+			RefGrid = Generic = Indexed = Replayed = Grid;
+			RefScore = GenericScore = IndexScore = 0;
+			Index.Rebuild (Indexed);
+			Events.Fit (Grid.size () * Grid [0].size ());
+			Reader.Skip ();
+			Engine = NULL;
+		}
+
+		/**
+		*@brief Checks the scoring moves of the grid : each must score with the reference engine, as many points as the batches say
+		*@return the scoring moves, empty if the check failed
+		*/
+		const CVMove & CheckPosition ()
+		{
+			ListScoringMoves (RefGrid, Moves);
+			EvaluateMoves (RefGrid, Moves, Points);
+			for (unsigned m (0); m < Moves.size (); ++m)
+			{
+				unsigned Expected (0);
+				Copy = RefGrid;
+				MakeAMove (Copy, Moves [m].Pos, Moves [m].Direction);
+				Reference::ArrangeGrid (Copy, Expected);
+				if (Expected == 0 || Points [m] != Expected)
+				{
+					Engine = Expected == 0 ? "liste des coups (ListScoringMoves)" : "évaluation par lots (EvaluateMoves)";
+					Moves.clear ();
+					break;
+				}
+			}
+			return Moves;
+		}
+
+		/**
+		*@brief Plays a valid move with every engine
+		*@return false if one of them differs from the reference
+		*/
+		bool Step (const CMove & Move)
+		{
+			const unsigned Before (RefScore);
+			PlayReference (Move);
+
+			PlayMove (Generic, Move.Pos, Move.Direction, GenericScore);
+			PlayMove (Index, Indexed, Move.Pos, Move.Direction, IndexScore, Groups, &Events);
+
+			/* Les événements rejoués sur la grille d'avant le coup redonnent celle d'après, s'ils n'ont pas été écrasés */
+			CEvent Batch [32];
+			const uint64_t Dropped (Reader.Dropped);
+			unsigned Announced (0);
+			for (unsigned NbRead; (NbRead = Reader.Read (Batch, 32)) != 0;)
+				for (unsigned e (0); e < NbRead; ++e)
+				{
+					ApplyEvent (Replayed, Batch [e]);
+					if (Batch [e].Kind == KScoreChanged) Announced += Batch [e].Value;
+				}
+			const bool Complete (Reader.Dropped == Dropped);
+
+			if (Generic != RefGrid || GenericScore != RefScore)
+				Engine = "noyaux (PlayMove)";
+			else if (Indexed != RefGrid || IndexScore != RefScore)
+				Engine = "index des suites (CRunIndex)";
+			else if (Complete && (Replayed != RefGrid || Announced != RefScore - Before))
+				Engine = "événements (ApplyEvent)";
+			if (! Complete) Replayed = RefGrid;
+			return Engine == NULL;
+		}
+
+		/**
+		*@brief Checks the save of the game : same text as the original Save, read back to the same game
+		*@return false if it differs
+		*/
+		bool CheckSave (unsigned Turn, unsigned MaxTimes, string & Buffer)
+		{
+			const unsigned Size (RefGrid.size ());
+			EncodeSave (Buffer, RefGrid, Turn, RefScore, RefScore, Size, KeyTab, MaxTimes);
+			ostringstream Original;
+			Reference::Save (Original, RefGrid, Turn, RefScore, RefScore, Size, KeyTab, MaxTimes);
+
+			unsigned Score (0), BestScore (0), LoadedTurn (0), LoadedSize (0), LoadedMaxTimes (0);
+			if (Buffer != Original.str ())
+				Engine = "sauvegarde (EncodeSave)";
+			else if (max (RefScore, max (Turn, MaxTimes)) <= RealMax
+					 && (DecodeSave (Buffer, Copy, KeyTab, Score, BestScore, LoadedTurn, LoadedSize, LoadedMaxTimes)
+						 || Copy != RefGrid || Score != RefScore || LoadedTurn != Turn || LoadedMaxTimes != MaxTimes))
+				Engine = "chargement (DecodeSave)";
+			return Engine == NULL;
+		}
+
+		/** @brief Shows the grid and the score of every engine */
+		void Report (ostream & Out) const
+		{
+			const pair <const char *, const CMat *> Grids [] = { {"référence", &RefGrid}, {"noyaux", &Generic},
+																 {"index des suites", &Indexed}, {"événements", &Replayed} };
+			const unsigned Scores [] = {RefScore, GenericScore, IndexScore, RefScore};
+			for (unsigned e (0); e < 4; ++e)
+			{
+				Out << Grids [e].first << " : score " << Scores [e] << endl;
+				for (const CVLine & Line : *Grids [e].second)
+				{
+					for (unsigned Cell : Line) Out << ' ' << Cell;
+					Out << endl;
+				}
+			}
+		}
+	};
+
+	/**
+    *@brief Writes a replay of --check-engines
+    *@param Path the file
+    *@param Grid the grid before the first move
+    *@param Moves the moves
+    *@param MaxTimes the moves allowed in the game
+    */
+	bool WriteReplay (const string & Path, const CMat & Grid, const CVMove & Moves, unsigned MaxTimes)
+	{
+		ofstream File (Path, ios::trunc);
+		File << "KCRP 1" << endl << Grid.size () << ' ' << Grid [0].size () << ' ' << MaxTimes << endl;
+		for (const CVLine & Line : Grid)
+		{
+			for (unsigned j (0); j < Line.size (); ++j) File << (j ? " " : "") << Line [j];
+			File << endl;
+		}
+		File << Moves.size () << endl;
+		for (const CMove & Move : Moves)
+			File << Move.Pos.first << ' ' << Move.Pos.second << ' ' << (Move.Direction == KeyDown ? "bas" : "droite") << endl;
+		return bool (File);
+
+	} // WriteReplay ()
+
+	/**
+    *@brief Reads a replay written by WriteReplay
+    */
+	bool ReadReplay (const string & Path, CMat & Grid, CVMove & Moves, unsigned & MaxTimes)
+	{
+		ifstream File (Path);
+		string Magic;
+		unsigned Version (0), Height (0), Width (0), NbMoves (0);
+		File >> Magic >> Version >> Height >> Width >> MaxTimes;
+		if (! File || Magic != "KCRP" || Version != 1 || Height == 0 || Width == 0 || Height > 64 || Width > 64) return false;
+
+		Grid.assign (Height, CVLine (Width));
+		for (CVLine & Line : Grid)
+			for (unsigned & Cell : Line) File >> Cell;
+		File >> NbMoves;
+		Moves.clear ();
+		for (unsigned m (0); m < NbMoves && File; ++m)
+		{
+			CMove Move;
+			string Direction;
+			File >> Move.Pos.first >> Move.Pos.second >> Direction;
+			Move.Direction = Direction == "bas" ? KeyDown : KeyRight;
+			if (! IsValidPosition (Grid, Move.Pos) || ! IsValidMove (Grid, Move.Pos, Move.Direction)) return false;
+			Moves.push_back (Move);
+		}
+		return bool (File);
+
+	} // ReadReplay ()
+
+	/**
+    *@brief Random valid move : one that scores three times out of four when there is one, otherwise any swap of two cells
+    *@return false if no cell can be swapped
+    */
+	bool RandomCheckMove (const CMat & Grid, const CVMove & Scoring, CRandom & Rand, CMove & Move)
+	{
+		if (! Scoring.empty () && Rand () % 4 != 0)
+		{
+			Move = Scoring [Rand () % Scoring.size ()];
+			return true;
+		}
+		for (unsigned Try (0); Try < 64; ++Try)
+		{
+			Move = CMove {make_pair (Rand () % Grid.size (), Rand () % Grid [0].size ()), Rand () % 2 ? KeyDown : KeyRight};
+			if (IsValidPosition (Grid, Move.Pos) && IsValidMove (Grid, Move.Pos, Move.Direction)) return true;
+		}
+		return false;
+
+	} // RandomCheckMove ()
+
+	/** @brief The first difference found by the threads of --check-engines */
+	struct CDivergence
+	{
+		atomic <bool> Found;
+		CMat Start;			// Grille du début de la partie
+		CVMove Moves;		// Coups joués jusqu'au coup fautif compris
+		uint64_t Game;
+
+		CDivergence () : Found (false), Game (0) {}
+	};
+
+	/**
+    *@brief Plays games on one thread until all of them are checked or a difference is found
+    *@param Next the number of the next game to play, shared by the threads
+    *@param NbMoves how many moves this thread has checked
+    */
+	void CheckEngines (uint64_t NbGames, uint32_t Seed, atomic <uint64_t> & Next, CDivergence & Divergence, uint64_t & NbMoves)
+	{
+		CEngineCheck Check;
+		CMat Start;
+		CVMove Played;
+		CMove Move;
+		string Buffer;
+
+		for (uint64_t Game; ! Divergence.Found.load (memory_order_relaxed) && (Game = Next.fetch_add (1)) < NbGames;)
+		{
+			/* Chaque partie ne dépend que de son numéro : elle se rejoue à l'identique, quel que soit le thread */
+			CRandom Rand (Seed + uint32_t (Game) * 2654435761u);
+			const CLevel & Level (KCheckedLevels [Game % KCheckedLevels.size ()]);
+			InitGrid (Start, Level.Size, Level.NbCandies, Rand);
+			Check.Start (Start);
+			Played.clear ();
+
+			bool Same (true);
+			while (Same && Played.size () < Level.MaxTimes)
+			{
+				const CVMove & Scoring (Check.CheckPosition ());
+				if (Check.Engine != NULL || ! RandomCheckMove (Check.Grid (), Scoring, Rand, Move))
+				{
+					Same = Check.Engine == NULL;
+					break;
+				}
+				Played.push_back (Move);
+				Same = Check.Step (Move);
+				++NbMoves;
+			}
+			if (Same) Same = Check.CheckSave (Played.size (), Level.MaxTimes, Buffer);
+
+			if (! Same && ! Divergence.Found.exchange (true))
+			{
+				Divergence.Start = Start;
+				Divergence.Moves = Played;
+				Divergence.Game = Game;
+			}
+		}
+
+	} // CheckEngines ()
+
+	/**
+    *@brief Replays moves with every engine, the grid after the last one being checked too
+    *@param Check the engines : Check.Engine is not NULL if one of them differs
+    *@param Before set to the grid where the difference appeared
+    *@return the number of moves played without difference
+    */
+	unsigned ReplayMoves (CEngineCheck & Check, const CMat & Start, const CVMove & Moves, CMat & Before)
+	{
+		Check.Start (Start);
+		for (unsigned m (0); ; ++m)
+		{
+			Before = Check.Grid ();
+			Check.CheckPosition ();
+			if (Check.Engine != NULL || m == Moves.size () || ! Check.Step (Moves [m])) return m;
+		}
+
+	} // ReplayMoves ()
 
-    /**
-    *@brief Acts like InitGrid and load save.txt
-    *@param Grid the game grid
-    *@param KeyTab vector who contains every keys
-    *@param Score parameter of the game
-    *@param BestScore parameter of the game
-    *@param Turn parameter of the game
-    *@param Size parameter of the game
-    *@param MaxTimes parameter of the game
+	/**
+    *@brief Lockstep check of the engines against the reference one (mode --check-engines)
+    *@param NbGames how many games to play
+    *@param NbThreads how many threads, 0 for one per core
+    *@param ReplayPath where to write the replay of the first difference
     */
-    bool LoadSave (CMat & Grid,const CVStr & KeyTab, unsigned & Score, unsigned & BestScore, unsigned & Turn, unsigned & Size, unsigned & MaxTimes)
-    /* Le chargement de sauvegarde, il agit comme un InitGrid, sauf qu'il prend les données de la sauvegarde existante et s'en sert */
-    {
-        ifstream SaveFile ("./save.txt") ;
-        if (SaveFile)
-        {
-            unsigned PreviousPos(0), WhereSeparator, WhatSubStr (1) ;
-            unsigned Key ; // La clé de cryptage (1ere ligne du code)
-            unsigned DecryptCurData ; // La sous-str décryptée
-            unsigned PosX (0), PosY (0) ; // La position dans la grille
-            string CryptedSave ;
-            string CurrentData ; // La sous-str sur laquelle on travaille dans la boucle
-            getline(SaveFile,CryptedSave) ; // La sauvegarde complete, illisible  genre (0001010O0010)
-            for (unsigned Pos (0) ; Pos < CryptedSave.size() ; ++Pos)
-            {
-                if (CryptedSave [Pos] == Separator)
-                {
-                    WhereSeparator = CryptedSave.find(Separator, Pos) - PreviousPos ; // Le séparateur est déplacé à la case ou il a trouvé - La case du spéarateur précédent
-                    CurrentData = CryptedSave.substr(Pos - NbZero, NbZero) ; // Le segment de sauvegarde sur lequel nous allons travailler
-                    PreviousPos = WhereSeparator + 1 ; // Pour éviter un problème sur la fonction find
-                    if ( ( CurrentData.size() == NbZero ) && (IsBinary(CurrentData) ) ) // On teste si le segment actuel est binaire
-                    {
-                        if (WhatSubStr == 1)
-                        {
-                            Key = BinToDec(CurrentData) ;
-
-                        } // La premiere donnée n'est pas cryptée en réalité, c'est juste son code binnaire.
-                        else
-                        {
-                            DecryptCurData = Decrypt (CurrentData, Key, KeyTab) ;
-                            //cout << "Decrypte : " << DecryptCurData << endl ;
-                            if (WhatSubStr == 2) // DEUXIEME DONNEE : Le score
-                                Score = DecryptCurData ;
-                            else if (WhatSubStr == 3) // TROISIEME DONNEE : Le meilleur score
-                                BestScore = DecryptCurData ;
-                            else if (WhatSubStr == 4) // QUATRIEME DONNEE : La taille du tableau
-                            {
-                                Size = DecryptCurData ;
-                                Grid = CMat (Size) ;
-                                for (CMat::iterator GridIter (Grid.begin ()); GridIter < Grid.end (); ++GridIter)
-                                    *GridIter = CVLine (Size) ;
-                            }
-                            else if (WhatSubStr == 5 ) // CINQUIEME DONNEE : Le tour
-                                Turn = DecryptCurData ;
-                            else if (WhatSubStr == 6) // SIXIEME DONNEE : Le niveau
-                                MaxTimes = DecryptCurData ;
-                            else if (WhatSubStr > 6 ) // SEPTIEME DONNEE : Le tableau
-                            {
-                                if (DecryptCurData > MaxTimes) // Si la donnée est supérieure à la difficulté, renvoie erreur
-                                    return true;
-                                Grid[PosX][PosY] = DecryptCurData ;
-                                PosY += 1 ;
-                                if (PosY >= Size)
-                                {
-                                    PosY = 0 ;
-                                    PosX += 1 ;
-                                }
-                            }
-                        }
-                        WhatSubStr += 1 ;
-                    }
-                    else
-                        return true ;
-                }
-            }
-        }
-        else
-        {
-            cout << "Sauvegarde Inexistante" << endl ;
-            // S'il n'y a pas de sauvegarde
-            return true;
-        }
+	int RunEngineCheck (uint64_t NbGames, unsigned NbThreads, const string & ReplayPath)
+	{
+		if (NbThreads == 0) NbThreads = max (1u, thread::hardware_concurrency ());
+		const uint32_t Seed (time (NULL));
+		cout << NbGames << " parties, " << NbThreads << " threads, graine " << Seed << endl;
+
+		const chrono::steady_clock::time_point Start (chrono::steady_clock::now ());
+		atomic <uint64_t> Next (0);
+		CDivergence Divergence;
+		vector <uint64_t> NbMoves (NbThreads, 0);
+		vector <thread> Threads;
+		for (unsigned t (0); t < NbThreads; ++t)
+			Threads.push_back (thread ([&, t] { CheckEngines (NbGames, Seed, Next, Divergence, NbMoves [t]); }));
+		for (thread & Thread : Threads) Thread.join ();
+		const double Seconds (ElapsedNs (Start) / 1e9);
+
+		uint64_t Moves (0);
+		for (uint64_t Count : NbMoves) Moves += Count;
+		const uint64_t Games (min (Next.load (), NbGames));
+		cout << Games << " parties, " << Moves << " coups en " << fixed << setprecision (1) << Seconds << " s : "
+			 << setprecision (0) << Games / Seconds << " parties/s, " << Moves / Seconds << " coups/s" << endl;
+		cout.unsetf (ios::floatfield);
+
+		if (! Divergence.Found) return 0;
+
+		/* Le rejeu est réduit à la grille où la différence est apparue, avec le coup fautif s'il y en a un, si cela suffit
+		   à la reproduire ; sinon il reprend la partie jusqu'à ce coup */
+		CEngineCheck Check;
+		CMat Before, Unused;
+		string Buffer;
+		const unsigned MaxTimes (KCheckedLevels [Divergence.Game % KCheckedLevels.size ()].MaxTimes);
+		const unsigned Failed (ReplayMoves (Check, Divergence.Start, Divergence.Moves, Before));
+		if (Check.Engine == NULL) Check.CheckSave (Failed, MaxTimes, Buffer);
+		CVMove Replay (Divergence.Moves.begin (), Divergence.Moves.begin () + min <size_t> (Failed + 1, Divergence.Moves.size ()));
+		CMat ReplayStart (Divergence.Start);
+		for (unsigned Length (0); Length <= 1 && Failed + Length <= Divergence.Moves.size (); ++Length)
+		{
+			const CVMove Short (Divergence.Moves.begin () + Failed, Divergence.Moves.begin () + Failed + Length);
+			CEngineCheck Alone;
+			ReplayMoves (Alone, Before, Short, Unused);
+			if (Alone.Engine != NULL)
+			{
+				ReplayStart = Before;
+				Replay = Short;
+				break;
+			}
+		}
 
-        return false;
+		cerr << "Différence dans la partie " << Divergence.Game << " : " << (Check.Engine != NULL ? Check.Engine : "?") << endl;
+		Check.Report (cerr);
+		if (WriteReplay (ReplayPath, ReplayStart, Replay, MaxTimes))
+			cerr << "Rejeu (" << Replay.size () << (Replay.size () > 1 ? " coups" : " coup") << ") écrit dans " << ReplayPath << endl;
+		else
+			cerr << "Erreur d'écriture dans " << ReplayPath << endl;
+		return 1;
 
-    } // LoadSave ()
+	} // RunEngineCheck ()
 
-    /**
-    *@brief Check if the number is in column or row in a cin
-    *@param Result check if the input isn't superior than grid's size
-    *@param Grid the game's grid
-    *@param Invite An invit before the cin
+	/**
+    *@brief Replays a file written by --check-engines and shows what every engine gives (mode --check-replay)
     */
-	void SaisieLigneCol (unsigned & Result, const CMat & Grid, const string & Invite)
+	int RunReplayCheck (const string & Path)
 	{
-		SaisieCin (Result, "Erreur de saisie", Invite);
-		while (! cin.eof () && (Result < 1 || Result >= Grid.size () + 1)) // Vérifie que le numéro de ligne ou colonne se trouve bien dans la grille
+		CMat Start, Before;
+		CVMove Moves;
+		unsigned MaxTimes;
+		if (! ReadReplay (Path, Start, Moves, MaxTimes))
+		{
+			cerr << Path << " : rejeu invalide" << endl;
+			return 1;
+		}
+
+		CEngineCheck Check;
+		string Buffer;
+		const unsigned Played (ReplayMoves (Check, Start, Moves, Before));
+		if (Check.Engine == NULL && Check.CheckSave (Played, MaxTimes, Buffer))
+		{
+			cout << Moves.size () << (Moves.size () > 1 ? " coups" : " coup") << " rejoués, aucune différence" << endl;
+			Check.Report (cout);
+			return 0;
+		}
+
+		if (Played < Moves.size ())
+			cout << "Coup " << Played + 1 << " (" << Moves [Played].Pos.first << ' ' << Moves [Played].Pos.second << ' '
+				 << (Moves [Played].Direction == KeyDown ? "bas" : "droite") << ") : ";
+		cout << Check.Engine << " diffère" << endl << "grille d'avant :" << endl;
+		for (const CVLine & Line : Before)
+		{
+			for (unsigned Cell : Line) cout << ' ' << Cell;
+			cout << endl;
+		}
+		Check.Report (cout);
+		return 1;
+
+	} // RunReplayCheck ()
+
+	/*	VÉRIFICATION DU CHARGEMENT
+
+		Le mode --fuzz-saves mesure le débit du lecteur de sauvegardes sur des sauvegardes correctes, puis lui donne pendant
+		quelques secondes des sauvegardes abîmées au hasard (chiffres changés, morceaux effacés, recopiés ou coupés), en
+		morceaux de tailles diverses. Une sauvegarde acceptée est réécrite par EncodeSave et relue : elle doit redonner la
+		même partie. C'est la même vérification que le point d'entrée libFuzzer, sans avoir besoin de clang. */
+
+	/**
+    *@brief Reads an input as a save, in pieces of the given size, then writes and reads back what was read
+    *@param Data the input
+    *@param Length its length
+    *@param Piece the size of the pieces given to the reader
+    *@param Error the error of the reader
+    *@return false if the save written from what was read is not read back the same
+    */
+	bool FuzzSave (const char * Data, size_t Length, size_t Piece, CSaveError & Error)
+	{
+		static thread_local CMat Grid, Copy;
+		static thread_local string Buffer;
+		unsigned Score (0), BestScore (0), Turn (0), Size (0), MaxTimes (0);
+		CSaveReader Reader (Grid, KeyTab);
+		for (size_t Pos (0); Pos < Length && ! Reader.Done (); Pos += Piece)
+			Reader.Feed (Data + Pos, min (Piece, Length - Pos));
+		Error = Reader.Finish (Score, BestScore, Turn, Size, MaxTimes);
+		if (Error != KSaveOk) return true;
+
+		unsigned CopyScore (0), CopyBestScore (0), CopyTurn (0), CopySize (0), CopyMaxTimes (0);
+		EncodeSave (Buffer, Grid, Turn, Score, BestScore, Size, KeyTab, MaxTimes);
+		return DecodeSave (Buffer, Copy, KeyTab, CopyScore, CopyBestScore, CopyTurn, CopySize, CopyMaxTimes) == KSaveOk
+			   && Copy == Grid && CopyScore == Score && CopyBestScore == BestScore && CopyTurn == Turn && CopySize == Size
+			   && CopyMaxTimes == MaxTimes;
+
+	} // FuzzSave ()
+
+	/**
+    *@brief Damages a save at random
+    *@param Input the save
+    *@param Rand the random generator
+    */
+	void MutateSave (string & Input, CRandom & Rand)
+	{
+		for (unsigned m (Rand () % 4 + 1); m-- > 0;)
+		{
+			const size_t Pos (Input.empty () ? 0 : Rand () % Input.size ());
+			const size_t Length (min <size_t> (Rand () % 24 + 1, Input.size () - Pos));
+			switch (Rand () % 5)
+			{
+				case 0 :	// Un caractère changé, le plus souvent par un caractère permis
+					if (! Input.empty ()) Input [Pos] = Rand () % 4 != 0 ? "01O\n" [Rand () % 4] : char (Rand ());
+					break;
+				case 1 :
+					Input.erase (Pos, Length);
+					break;
+				case 2 :
+					Input.insert (Rand () % (Input.size () + 1), Input.substr (Pos, Length));
+					break;
+				case 3 :
+					Input.resize (Pos);
+					break;
+				default :
+					Input.insert (Pos, 1, "01O" [Rand () % 3]);
+			}
+		}
+
+	} // MutateSave ()
+
+	/**
+    *@brief Throughput of the save reader, then damaged saves for a while (mode --fuzz-saves)
+    *@param Seconds how long to damage saves
+    *@param Paths the saves to start from, saves of the levels if empty
+    */
+	int RunSaveFuzzer (unsigned Seconds, const vector <string> & Paths)
+	{
+		vector <string> Corpus;
+		for (const string & Path : Paths)
+		{
+			/* Un dossier, un tube ou un périphérique ne sont pas des sauvegardes : la lecture d'un dossier lèverait une exception */
+			#ifndef _WIN32
+				struct stat Status;
+				const bool Exists (stat (Path.c_str (), &Status) == 0);
+				if (! Exists || ! S_ISREG (Status.st_mode))
+				{
+					cerr << Path << " : " << (! Exists ? strerror (errno) : S_ISDIR (Status.st_mode) ? "c'est un dossier" : "pas un fichier")
+						 << endl;
+					return 1;
+				}
+			#endif
+			ifstream File (Path, ios::binary);
+			Corpus.push_back (string ());
+			char Block [4096];
+			while (File.read (Block, sizeof (Block)) || File.gcount () > 0)
+				Corpus.back ().append (Block, File.gcount ());
+			if (! File.eof ())
+			{
+				cerr << "Impossible de lire " << Path << endl;
+				return 1;
+			}
+		}
+		if (Corpus.empty ())
+			for (unsigned l (0); l < KLevels.size (); ++l)
+			{
+				CMat Grid;
+				CRandom Rand (l + 1);
+				InitGrid (Grid, KLevels [l].Size, KLevels [l].NbCandies, Rand);
+				Corpus.push_back (string ());
+				EncodeSave (Corpus.back (), Grid, l, 100 * l, 300, KLevels [l].Size, KeyTab, KLevels [l].MaxTimes);
+			}
+
+		/* Débit sur les sauvegardes telles quelles */
+		CMat Grid;
+		unsigned Score (0), BestScore (0), Turn (0), Size (0), MaxTimes (0), NbCorrect (0);
+		uint64_t Bytes (0);
+		for (const string & Input : Corpus)
+			if (DecodeSave (Input, Grid, KeyTab, Score, BestScore, Turn, Size, MaxTimes) == KSaveOk) ++NbCorrect;
+		chrono::steady_clock::time_point Start (chrono::steady_clock::now ());
+		do {
+			for (const string & Input : Corpus)
+			{
+				DecodeSave (Input, Grid, KeyTab, Score, BestScore, Turn, Size, MaxTimes);
+				Bytes += Input.size ();
+			}
+		} while (ElapsedNs (Start) < 5e8);
+		cout << Corpus.size () << " sauvegardes, " << NbCorrect << " correctes : " << fixed << setprecision (1)
+			 << Bytes / (ElapsedNs (Start) / 1e3) << " Mo/s" << endl;
+
+		/* Sauvegardes abîmées */
+		const uint32_t Seed (time (NULL));
+		CRandom Rand (Seed);
+		array <uint64_t, KSaveTooLong + 1> PerError {};
+		uint64_t NbInputs (0);
+		string Input;
+		Bytes = 0;
+		Start = chrono::steady_clock::now ();
+		do {
+			for (unsigned i (0); i < 1024; ++i)
+			{
+				Input = Corpus [Rand () % Corpus.size ()];
+				MutateSave (Input, Rand);
+				CSaveError Error;
+				if (! FuzzSave (Input.data (), Input.size (), Rand () % 64 + 1, Error))
+				{
+					ofstream ("save-crash.txt", ios::binary) << Input;
+					cerr << "Sauvegarde relue différemment, écrite dans save-crash.txt (graine " << Seed << ")" << endl;
+					return 1;
+				}
+				++PerError [Error];
+				Bytes += Input.size ();
+			}
+			NbInputs += 1024;
+		} while (ElapsedNs (Start) < Seconds * 1e9);
+
+		const double Elapsed (ElapsedNs (Start) / 1e9);
+		cout << NbInputs << " sauvegardes abîmées (graine " << Seed << ") : " << setprecision (0) << NbInputs / Elapsed
+			 << " par seconde, " << setprecision (1) << Bytes / Elapsed / 1e6 << " Mo/s" << endl;
+		for (unsigned e (0); e < PerError.size (); ++e)
+			if (e != KSaveMissing)
+				cout << "  " << SaveErrorText (CSaveError (e)) << " : " << PerError [e] << endl;
+		return 0;
+
+	} // RunSaveFuzzer ()
+
+	/*	JEU DE DONNÉES D'ENTRAÎNEMENT
+
+		Le mode --dataset joue des parties sur tous les cœurs et enregistre chaque décision : la grille, les coups permis, le
+		coup choisi, les points qu'il rapporte et le score final de la partie. Chaque thread écrit ses propres fichiers
+		(shards), sans aucun verrou. Un shard est découpé en groupes de KRowGroupSize décisions ; dans un groupe, chaque
+		colonne est rangée d'un seul bloc, à largeur fixe. Format d'un shard (entiers dans l'ordre de la machine) :
+
+			en-tête			"KCDS", version, nombre de colonnes, taille d'un groupe, puis par colonne : nom (12 octets), largeur
+			groupes			pour chaque colonne, largeur * nombre de lignes octets
+			index			nombre de groupes, puis par groupe : position dans le fichier, nombre de lignes, 4 octets à 0
+			fin				position de l'index, "KCDI", version
+
+		Un lecteur lit la fin puis l'index, et peut ensuite lire un groupe, ou une seule colonne d'un groupe, à la fois. */
+
+	/** @brief One decision of a game */
+	struct CSample
+	{
+		uint8_t Board [64];		// Cases ligne après ligne, les grilles plus petites que 8x8 sont complétées par des 0
+		uint8_t Size;
+		uint8_t Level;			// Indice dans KLevels
+		uint8_t Turn;			// Coups déjà joués
+		uint8_t MoveCell;		// i * 8 + j de la case choisie
+		uint8_t MoveDirection;	// 0 : échange avec la case de droite, 1 : avec celle du dessous
+		uint64_t LegalRight;	// Bit i * 8 + j : la case peut être échangée avec celle de droite
+		uint64_t LegalDown;		// Idem avec celle du dessous
+		uint32_t Points;		// Points rapportés par le coup
+		uint32_t FinalScore;	// Score de la partie à la fin
+		uint64_t Game;			// Numéro de la partie, unique sur tous les threads
+	};
+
+	/** @brief A column of the shards */
+	struct CColumn
+	{
+		const char * Name;
+		unsigned Width;
+		size_t Offset;			// Position du champ dans CSample
+	};
+
+	/** @brief Columns of the shards, in the order of the file */
+	const array <CColumn, 11> KColumns {{
+		{"board", 64, offsetof (CSample, Board)}, {"size", 1, offsetof (CSample, Size)}, {"level", 1, offsetof (CSample, Level)},
+		{"turn", 1, offsetof (CSample, Turn)}, {"move_cell", 1, offsetof (CSample, MoveCell)},
+		{"move_dir", 1, offsetof (CSample, MoveDirection)}, {"legal_right", 8, offsetof (CSample, LegalRight)},
+		{"legal_down", 8, offsetof (CSample, LegalDown)}, {"points", 4, offsetof (CSample, Points)},
+		{"final_score", 4, offsetof (CSample, FinalScore)}, {"game", 8, offsetof (CSample, Game)} }};
+
+	/** @brief Decisions in a group of a shard */
+	const unsigned KRowGroupSize = 65536;
+
+	/** @brief Groups in a shard before the next one is started */
+	const unsigned KRowGroupsPerShard = 64;
+
+	const uint32_t KShardVersion = 1;
+
+	/** @brief Writes decisions into numbered shards, one column buffer per column */
+	class CShardWriter
+	{
+		string Prefix;
+		unsigned NbShards;
+		ofstream File;
+		uint64_t Position;
+		vector <pair <uint64_t, uint32_t> > RowGroups;	// Position et nombre de lignes des groupes du shard
+		array <vector <char>, KColumns.size ()> Columns;
+		unsigned NbRows;
+		bool Failed;
+
+		template <typename T>
+		void WriteValue (const T & Value)
+		{
+			File.write (reinterpret_cast <const char *> (&Value), sizeof (Value));
+			Position += sizeof (Value);
+		}
+
+		void OpenShard ()
+		{
+			ostringstream Name;
+			Name << Prefix << setw (4) << setfill ('0') << NbShards++ << ".kcds";
+			File.open (Name.str (), ios::binary | ios::trunc);
+			Failed = Failed || ! File;
+			Position = 0;
+			RowGroups.clear ();
+
+			File.write ("KCDS", 4);
+			Position += 4;
+			WriteValue (KShardVersion);
+			WriteValue (uint32_t (KColumns.size ()));
+			WriteValue (uint32_t (KRowGroupSize));
+			for (const CColumn & Column : KColumns)
+			{
+				char Name [12] = {};	// Noms de moins de 12 caractères
+				memcpy (Name, Column.Name, strlen (Column.Name));
+				File.write (Name, sizeof (Name));
+				Position += sizeof (Name);
+				WriteValue (uint32_t (Column.Width));
+			}
+		}
+
+		void FlushRowGroup ()
+		{
+			if (NbRows == 0) return;
+			if (! File.is_open ()) OpenShard ();
+
+			/* Une écriture par colonne, de plusieurs centaines de Ko */
+			RowGroups.push_back (make_pair (Position, NbRows));
+			for (unsigned c (0); c < KColumns.size (); ++c)
+			{
+				File.write (Columns [c].data (), size_t (NbRows) * KColumns [c].Width);
+				Position += size_t (NbRows) * KColumns [c].Width;
+			}
+			NbRows = 0;
+			Failed = Failed || ! File;
+
+			if (RowGroups.size () == KRowGroupsPerShard) CloseShard ();
+		}
+
+		void CloseShard ()
+		{
+			if (! File.is_open ()) return;
+
+			const uint64_t IndexPosition (Position);
+			WriteValue (uint64_t (RowGroups.size ()));
+			for (const pair <uint64_t, uint32_t> & RowGroup : RowGroups)
+			{
+				WriteValue (RowGroup.first);
+				WriteValue (RowGroup.second);
+				WriteValue (uint32_t (0));
+			}
+			WriteValue (IndexPosition);
+			File.write ("KCDI", 4);
+			WriteValue (KShardVersion);
+			File.close ();
+			Failed = Failed || ! File;
+		}
+
+	  public:
+		/**
+		*@brief Writes the shards <Prefix>0000.kcds, <Prefix>0001.kcds...
+		*/
+		explicit CShardWriter (const string & FilePrefix) : Prefix (FilePrefix), NbShards (0), Position (0), NbRows (0), Failed (false)
+		{
+			for (unsigned c (0); c < KColumns.size (); ++c)
+				Columns [c].resize (size_t (KRowGroupSize) * KColumns [c].Width);
+		}
+
+		~CShardWriter () { Close (); }
+
+		/** @brief Rows that fit in the current group */
+		unsigned Room () const { return KRowGroupSize - NbRows; }
+
+		/** @brief Adds decisions, Count must not be more than Room () */
+		void Append (const CSample * Samples, unsigned Count)
+		{
+			for (unsigned c (0); c < KColumns.size (); ++c)
+			{
+				const unsigned Width (KColumns [c].Width);
+				char * Out (&Columns [c][size_t (NbRows) * Width]);
+				for (unsigned s (0); s < Count; ++s, Out += Width)
+					memcpy (Out, reinterpret_cast <const char *> (&Samples [s]) + KColumns [c].Offset, Width);
+			}
+			NbRows += Count;
+			if (NbRows == KRowGroupSize) FlushRowGroup ();
+		}
+
+		/** @brief Writes the last group and the index of the current shard */
+		bool Close ()
+		{
+			FlushRowGroup ();
+			CloseShard ();
+			return ! Failed;
+		}
+
+		/** @brief How many shards were started */
+		unsigned Count () const { return NbShards; }
+	};
+
+	/** @brief Reads a shard one group, or one column of a group, at a time */
+	class CShardReader
+	{
+		ifstream File;
+		vector <pair <uint64_t, uint32_t> > RowGroups;
+		vector <unsigned> Widths;
+		vector <string> Names;
+
+		template <typename T>
+		bool ReadValue (T & Value)
+		{
+			return bool (File.read (reinterpret_cast <char *> (&Value), sizeof (Value)));
+		}
+
+	  public:
+		/**
+		*@brief Opens a shard and reads its index
+		*@return false if the file is not a complete shard
+		*/
+		bool Open (const string & Path)
+		{
+			if (File.is_open ()) File.close ();
+			File.clear ();
+			File.open (Path, ios::binary);
+			char Magic [4];
+			uint32_t Version, NbColumns, GroupSize;
+			if (! File.read (Magic, 4) || memcmp (Magic, "KCDS", 4) != 0 || ! ReadValue (Version) || Version != KShardVersion
+				|| ! ReadValue (NbColumns) || NbColumns > 256 || ! ReadValue (GroupSize))
+				return false;
+
+			Widths.clear ();
+			Names.clear ();
+			for (unsigned c (0); c < NbColumns; ++c)
+			{
+				char Name [13] = {};
+				uint32_t Width;
+				if (! File.read (Name, 12) || ! ReadValue (Width)) return false;
+				Names.push_back (Name);
+				Widths.push_back (Width);
+			}
+
+			/* La fin du fichier donne la position de l'index */
+			uint64_t IndexPosition, NbRowGroups;
+			File.seekg (-16, ios::end);
+			if (! ReadValue (IndexPosition) || ! File.read (Magic, 4) || memcmp (Magic, "KCDI", 4) != 0) return false;
+			File.seekg (IndexPosition);
+			if (! ReadValue (NbRowGroups) || NbRowGroups > (uint64_t (1) << 32)) return false;
+
+			RowGroups.clear ();
+			for (uint64_t g (0); g < NbRowGroups; ++g)
+			{
+				uint64_t Position;
+				uint32_t NbRows, Padding;
+				if (! ReadValue (Position) || ! ReadValue (NbRows) || ! ReadValue (Padding)) return false;
+				RowGroups.push_back (make_pair (Position, NbRows));
+			}
+			return true;
+		}
+
+		unsigned NbRowGroups () const { return RowGroups.size (); }
+
+		uint64_t NbSamples () const
+		{
+			uint64_t Total (0);
+			for (const pair <uint64_t, uint32_t> & RowGroup : RowGroups) Total += RowGroup.second;
+			return Total;
+		}
+
+		/** @brief Index of the column named Name, or -1 */
+		int ColumnIndex (const string & Name) const
+		{
+			for (unsigned c (0); c < Names.size (); ++c)
+				if (Names [c] == Name) return c;
+			return -1;
+		}
+
+		/**
+		*@brief Reads a single column of a group
+		*@param Group the index of the group
+		*@param Column the index of the column
+		*@param Data filled with the values of the column, Width bytes per decision
+		*/
+		bool ReadColumn (unsigned Group, unsigned Column, vector <char> & Data)
+		{
+			uint64_t Position (RowGroups [Group].first);
+			for (unsigned c (0); c < Column; ++c)
+				Position += uint64_t (Widths [c]) * RowGroups [Group].second;
+
+			Data.resize (size_t (Widths [Column]) * RowGroups [Group].second);
+			File.seekg (Position);
+			return bool (File.read (Data.data (), Data.size ()));
+		}
+
+		/**
+		*@brief Reads a whole group back into decisions (the shard must have the columns of this version)
+		*/
+		bool ReadRowGroup (unsigned Group, vector <CSample> & Samples)
+		{
+			static thread_local vector <char> Data;
+			Samples.resize (RowGroups [Group].second);
+			for (unsigned c (0); c < KColumns.size (); ++c)
+			{
+				const int Index (ColumnIndex (KColumns [c].Name));
+				if (Index < 0 || Widths [Index] != KColumns [c].Width || ! ReadColumn (Group, Index, Data)) return false;
+				for (unsigned s (0); s < Samples.size (); ++s)
+					memcpy (reinterpret_cast <char *> (&Samples [s]) + KColumns [c].Offset, &Data [size_t (s) * KColumns [c].Width],
+							KColumns [c].Width);
+			}
+			return true;
+		}
+	};
+
+	/** @brief Policies of the dataset generator */
+	enum CPolicy { KRandomPolicy, KScoringPolicy, KGreedyPolicy };
+
+	/**
+    *@brief Finds a policy from its name
+    *@param Name random, scoring or greedy
+    *@param Policy the policy found
+    *@return false, after an error message, if the name is unknown
+    */
+	bool FindPolicy (const string & Name, CPolicy & Policy)
+	{
+		if (Name == "random") Policy = KRandomPolicy;
+		else if (Name == "scoring") Policy = KScoringPolicy;
+		else if (Name == "greedy") Policy = KGreedyPolicy;
+		else
+		{
+			cerr << "Stratégie inconnue : " << Name << " (random, scoring ou greedy)" << endl;
+			return false;
+		}
+		return true;
+
+	} // FindPolicy ()
+
+	/**
+    *@brief Chooses the move of a decision
+    *@param Session the game
+    *@param Policy random : any legal move, scoring : any move that scores, greedy : the move that scores the most
+    *@param Legal the legal moves
+    *@param Moves buffer of the scoring moves
+    *@param Scratch buffer of the grid
+    *@param Rand the random generator of the choices, Session.Rand unless the game must be replayed from its seed alone
+    */
+	CMove ChooseMove (CSession & Session, CPolicy Policy, const CVMove & Legal, CVMove & Moves, CMat & Scratch, CRandom & Rand)
+	{
+		if (Policy != KRandomPolicy)
+		{
+			Session.Index.ListScoringMoves (Moves);
+			if (Policy == KScoringPolicy && ! Moves.empty ())
+				return Moves [Rand () % Moves.size ()];
+
+			unsigned Best (0), BestPoints (0);
+			for (unsigned m (0); m < Moves.size (); ++m)
+			{
+				unsigned Points (0);
+				Scratch = Session.Grid;
+				PlayMove (Scratch, Moves [m].Pos, Moves [m].Direction, Points);
+				if (Points > BestPoints)
+				{
+					BestPoints = Points;
+					Best = m;
+				}
+			}
+			if (! Moves.empty ()) return Moves [Best];
+		}
+		return Legal [Rand () % Legal.size ()];
+
+	} // ChooseMove ()
+
+	/**
+    *@brief Lists the legal moves of a session : both cells are not empty
+    *@param Session the game
+    *@param Legal the moves, towards the right and the bottom
+    */
+	void ListLegalMoves (const CSession & Session, CVMove & Legal)
+	{
+		Legal.clear ();
+		for (unsigned i (0); i < Session.Size; ++i)
+			for (unsigned j (0); j < Session.Size; ++j)
+			{
+				if (Session.Grid [i][j] == KImpossible) continue;
+				if (j + 1 < Session.Size && Session.Grid [i][j + 1] != KImpossible)
+					Legal.push_back (CMove {make_pair (i, j), KeyRight});
+				if (i + 1 < Session.Size && Session.Grid [i + 1][j] != KImpossible)
+					Legal.push_back (CMove {make_pair (i, j), KeyDown});
+			}
+
+	} // ListLegalMoves ()
+
+	/**
+    *@brief Plays games and writes their decisions, on one thread
+    *@param Prefix the prefix of the shards of the thread
+    *@param Thread the index of the thread
+    *@param NbSamples how many decisions to write
+    *@param Policy the policy of the moves
+    */
+	bool GenerateDataset (const string & Prefix, unsigned Thread, uint64_t NbSamples, CPolicy Policy)
+	{
+		CShardWriter Writer (Prefix);
+		CSession Session;
+		CVMove Legal, Moves;
+		CMat Scratch;
+		vector <CSample> Pending;	// Décisions de la partie en cours, écrites quand le score final est connu
+		CRandom Rand (Thread * 2654435761u + 12345);
+
+		uint64_t Written (0), NbGames (0);
+		while (Written < NbSamples)
+		{
+			const unsigned Level (Rand () % KLevels.size ());
+			NewSession (Session, KLevels [Level], Rand ());
+			Pending.clear ();
+
+			while (Session.End == KNotOver)
+			{
+				const unsigned Size (Session.Size);
+				CSample Sample;
+				memset (&Sample, 0, sizeof (Sample));
+				Sample.Size = Size;
+				Sample.Level = Level;
+				Sample.Turn = Session.NbMoves;
+				Sample.Game = (uint64_t (Thread) << 40) | NbGames;
+
+				/* Coups permis : les deux cases sont non vides */
+				Legal.clear ();
+				for (unsigned i (0); i < Size; ++i)
+					for (unsigned j (0); j < Size; ++j)
+					{
+						const unsigned Cell (Session.Grid [i][j]);
+						Sample.Board [i * 8 + j] = Cell;
+						if (Cell == KImpossible) continue;
+						if (j + 1 < Size && Session.Grid [i][j + 1] != KImpossible)
+						{
+							Sample.LegalRight |= uint64_t (1) << (i * 8 + j);
+							Legal.push_back (CMove {make_pair (i, j), KeyRight});
+						}
+						if (i + 1 < Size && Session.Grid [i + 1][j] != KImpossible)
+						{
+							Sample.LegalDown |= uint64_t (1) << (i * 8 + j);
+							Legal.push_back (CMove {make_pair (i, j), KeyDown});
+						}
+					}
+				if (Legal.empty ()) break;
+
+				const CMove Move (ChooseMove (Session, Policy, Legal, Moves, Scratch, Session.Rand));
+				Sample.MoveCell = Move.Pos.first * 8 + Move.Pos.second;
+				Sample.MoveDirection = Move.Direction == KeyRight ? 0 : 1;
+
+				const unsigned Before (Session.Score);
+				if (! PlaySessionMove (Session, Move.Pos, Move.Direction)) break;
+				Sample.Points = Session.Score - Before;
+				Pending.push_back (Sample);
+			}
+			++NbGames;
+
+			for (CSample & Sample : Pending) Sample.FinalScore = Session.Score;
+
+			/* Une partie peut être coupée entre deux groupes, la dernière est tronquée au nombre demandé */
+			unsigned Done (0);
+			const unsigned Count (unsigned (min <uint64_t> (Pending.size (), NbSamples - Written)));
+			while (Done < Count)
+			{
+				const unsigned Part (min (Count - Done, Writer.Room ()));
+				Writer.Append (&Pending [Done], Part);
+				Done += Part;
+			}
+			Written += Count;
+		}
+		return Writer.Close ();
+
+	} // GenerateDataset ()
+
+	/**
+    *@brief Training dataset generator (mode --dataset) : plays games on every core and writes their decisions in shards
+    *@param Directory the directory of the shards
+    *@param NbSamples how many decisions in all
+    *@param PolicyName random, scoring or greedy
+    *@param NbThreads how many threads, 0 for one per core
+    */
+	int RunDatasetGenerator (const string & Directory, uint64_t NbSamples, const string & PolicyName, unsigned NbThreads)
+	{
+		CPolicy Policy;
+		if (! FindPolicy (PolicyName, Policy)) return 1;
+		if (NbThreads == 0) NbThreads = max (1u, thread::hardware_concurrency ());
+
+		cout << NbSamples << " décisions, stratégie " << PolicyName << ", " << NbThreads << " threads, dans " << Directory << endl;
+
+		const chrono::steady_clock::time_point Start (chrono::steady_clock::now ());
+		vector <thread> Threads;
+		vector <char> Succeeded (NbThreads, 0);
+		for (unsigned t (0); t < NbThreads; ++t)
+		{
+			const uint64_t Share (NbSamples / NbThreads + (t < NbSamples % NbThreads ? 1 : 0));
+			ostringstream Prefix;
+			Prefix << Directory << "/shard_" << setw (2) << setfill ('0') << t << '_';
+			const string ThreadPrefix (Prefix.str ());
+			Threads.push_back (thread ([=, &Succeeded] { Succeeded [t] = GenerateDataset (ThreadPrefix, t, Share, Policy); }));
+		}
+		for (thread & Thread : Threads) Thread.join ();
+
+		const double Seconds (ElapsedNs (Start) / 1e9);
+		cout << fixed << setprecision (0) << NbSamples / Seconds << " décisions/s, "
+			 << setprecision (1) << NbSamples * sizeof (CSample) / Seconds / 1e6 << " Mo/s" << endl;
+
+		if (find (Succeeded.begin (), Succeeded.end (), 0) != Succeeded.end ())
+		{
+			cerr << "Erreur d'écriture dans " << Directory << endl;
+			return 1;
+		}
+		return 0;
+
+	} // RunDatasetGenerator ()
+
+	/**
+    *@brief Reads shards group by group and checks them (mode --dataset-read)
+    *@param Paths the shards
+    */
+	int RunDatasetReader (const vector <string> & Paths)
+	{
+		CShardReader Reader;
+		vector <CSample> Samples;
+		uint64_t NbSamples (0), NbErrors (0), TotalPoints (0);
+		array <uint64_t, KLevels.size ()> PerLevel {};
+
+		for (const string & Path : Paths)
+		{
+			if (! Reader.Open (Path))
+			{
+				cerr << Path << " : shard invalide" << endl;
+				return 1;
+			}
+			for (unsigned g (0); g < Reader.NbRowGroups (); ++g)
+			{
+				if (! Reader.ReadRowGroup (g, Samples))
+				{
+					cerr << Path << " : groupe " << g << " illisible" << endl;
+					return 1;
+				}
+				for (const CSample & Sample : Samples)
+				{
+					/* Le coup choisi doit faire partie des coups permis */
+					const uint64_t Legal (Sample.MoveDirection == 0 ? Sample.LegalRight : Sample.LegalDown);
+					if (Sample.Level >= KLevels.size () || ! ((Legal >> Sample.MoveCell) & 1) || Sample.Points > Sample.FinalScore)
+						++NbErrors;
+					else
+						++PerLevel [Sample.Level];
+					TotalPoints += Sample.Points;
+				}
+				NbSamples += Samples.size ();
+			}
+		}
+
+		cout << NbSamples << " décisions, " << NbErrors << " incohérentes, "
+			 << fixed << setprecision (2) << (NbSamples ? double (TotalPoints) / NbSamples : 0.) << " points par coup en moyenne" << endl;
+		for (unsigned l (0); l < KLevels.size (); ++l)
+			cout << "  Niveau " << l + 1 << " : " << PerLevel [l] << endl;
+		return NbErrors == 0 ? 0 : 1;
+
+	} // RunDatasetReader ()
+
+#ifndef _WIN32
+
+	/**
+    *@brief Replay recorder (mode --record) : plays games with a policy and appends each one to an archive as it ends
+    *@param Path the archive, created if needed
+    *@param NbGames how many games
+    *@param Level the level of the games
+    *@param PolicyName random, scoring or greedy
+    */
+	int RunReplayRecorder (const string & Path, uint64_t NbGames, const CLevel & Level, const string & PolicyName)
+	{
+		CPolicy Policy;
+		if (! FindPolicy (PolicyName, Policy)) return 1;
+		CReplayArchive Archive;
+		if (! Archive.Open (Path, true))
 		{
-			cout << "Numéro invalide" << endl;
-			SaisieCin (Result, "Erreur de saisie", Invite);
+			cerr << Path << " : impossible d'ouvrir l'archive" << endl;
+			return 1;
+		}
+		const uint64_t First (Archive.Size ());
+
+		CSession Session;
+		Session.Rules = &KRuleSets [CurrentRules];
+		CVMove Legal, Moves;
+		CMat Scratch;
+		CReplay Replay;
+		CRandom Seeds (time (NULL));
+		CRandom Choices (Seeds ());	// Pas Session.Rand : une partie rejouée ne refait pas les tirages de la stratégie
+		uint64_t NbActions (0);
+		const chrono::steady_clock::time_point Start (chrono::steady_clock::now ());
+		for (uint64_t g (0); g < NbGames; ++g)
+		{
+			Replay.Seed = Seeds ();
+			Replay.Rules = CurrentRules;
+			Replay.Level = Level;
+			Replay.Actions.clear ();
+			NewSession (Session, Level, Replay.Seed);
+			Replay.Score = Session.Score;
+			while (Session.End == KNotOver)
+			{
+				ListLegalMoves (Session, Legal);
+				if (Legal.empty ()) break;
+				const CPlayInput Input {KPlayMove, ChooseMove (Session, Policy, Legal, Moves, Scratch, Choices)};
+				ResumePlay (Session, Input);
+				RecordStep (Replay, Session, Input);
+			}
+			NbActions += Replay.Actions.size ();
+			if (! Archive.Append (Replay))
+			{
+				cerr << Path << " : erreur d'écriture" << endl;
+				return 1;
+			}
+		}
+		if (! Archive.Close ())
+		{
+			cerr << Path << " : erreur d'écriture" << endl;
+			return 1;
 		}
 
-	} // SaisieLigneCol ()
+		const double Seconds (ElapsedNs (Start) / 1e9);
+		struct stat Status;
+		stat (Path.c_str (), &Status);
+		cout << NbGames << " parties archivées (" << First << " à " << First + NbGames - 1 << "), " << NbActions << " actions : "
+			 << fixed << setprecision (0) << NbGames / Seconds << " parties/s" << endl
+			 << Path << " : " << Status.st_size << " octets, " << setprecision (1) << double (Status.st_size) / (First + NbGames)
+			 << " octets par partie" << endl;
+		return 0;
 
+	} // RunReplayRecorder ()
 
+#endif // _WIN32
 
-	/* Fonction principale contenant le jeu */
-    /**
-    *@brief Kitty Crush, the game itself
-    *@param OptionsChoices to check your choosen options
-    *@param LoadExistingSave if you choose to load a save
+	/**
+    *@brief Simulates the parameter sets of the adaptive mode and writes their table, to paste in place of KDifficulties
+    *       (mode --difficulty-table). The sets are written from the easiest to the hardest : median points per move
+    *@param NbGames how many games per set
+    *@param NbThreads how many threads, 0 for one per core
     */
-	void Game (const array <unsigned, 2> & OptionsChoices, bool LoadExistingSave)
+	int RunDifficultyTable (uint64_t NbGames, unsigned NbThreads)
 	{
-		/* Il est possible de les modifier pour faire des niveaux de difficulté */
-		unsigned Size (6);				// Taille de la grille (à la fois ligne et colonnes) !!
-		unsigned MaxTimes (6); 		// Nombre maximal de coups autorisés
-		unsigned NbCandies (4); 		// Combien de numéros différents sont présents dans la grille
-		unsigned BestScore (0);        	// Variable à modifier avec une fonction, variable ARBITRAIRE
-		unsigned Score (0);
-		unsigned NbMoves (0);
+		vector <CLevel> Sets;
+		for (unsigned Size (5); Size <= 10; ++Size)
+			for (unsigned NbCandies (4); NbCandies <= 6; ++NbCandies)
+				for (unsigned MaxTimes : {Size, Size + 3})
+					Sets.push_back (CLevel {Size, MaxTimes, NbCandies});
+		if (NbThreads == 0) NbThreads = max (1u, thread::hardware_concurrency ());
+
+		/* Les threads se partagent les ensembles de paramètres ; chacun est joué par le joueur glouton, règles classiques */
+		vector <array <uint32_t, KNbQuantiles>> Quantiles (Sets.size ());
+		atomic <unsigned> Next (0);
+		const chrono::steady_clock::time_point Start (chrono::steady_clock::now ());
+		vector <thread> Threads;
+		for (unsigned t (0); t < NbThreads; ++t)
+			Threads.push_back (thread ([&]
+			{
+				CSession Session;
+				CVMove Legal, Moves;
+				CMat Scratch;
+				vector <uint32_t> Scores;
+				for (unsigned s; (s = Next++) < Sets.size ();)
+				{
+					CRandom Seeds (s + 1);
+					Scores.clear ();
+					for (uint64_t g (0); g < NbGames; ++g)
+					{
+						NewSession (Session, Sets [s], Seeds ());
+						while (Session.End == KNotOver)
+						{
+							ListLegalMoves (Session, Legal);
+							if (Legal.empty ()) break;
+							ResumePlay (Session, CPlayInput {KPlayMove, ChooseMove (Session, KGreedyPolicy, Legal, Moves, Scratch, Session.Rand)});
+						}
+						Scores.push_back (Session.Score);
+					}
+					sort (Scores.begin (), Scores.end ());
+					for (unsigned q (0); q < KNbQuantiles; ++q)
+						Quantiles [s][q] = Scores [min <size_t> (Scores.size () - 1, Scores.size () * KQuantiles [q] / 100)];
+				}
+			}));
+		for (thread & Thread : Threads) Thread.join ();
 
-		/* Options choisies */
-		unsigned InputMode (OptionsChoices [0]);	// 0 : saisie "à l'ancienne" où on demande les ligne colonne etc une à la fois, 1 : saisie sur 1 ligne
+		vector <unsigned> Order (Sets.size ());
+		for (unsigned s (0); s < Sets.size (); ++s) Order [s] = s;
+		sort (Order.begin (), Order.end (), [&] (unsigned a, unsigned b)
+			  { return Quantiles [a][KNbQuantiles / 2] * Sets [b].MaxTimes > Quantiles [b][KNbQuantiles / 2] * Sets [a].MaxTimes; });
 
-		bool InputLineFirst; 	// true : la commande est du type "ligne colonne direction", false : "colonne ligne direction"
-		InputLineFirst = OptionsChoices [1] == 0 ? true : false; // 0 : ligne en premier, 1 : colonne en premier
+		cout << "\t/* " << NbGames << " parties par ensemble, joueur glouton (--difficulty-table " << NbGames << ") */" << endl
+			 << "\tconstexpr CDifficulty KDifficulties [] = {" << endl;
+		for (unsigned s : Order)
+		{
+			cout << "\t\t{ " << setw (2) << Sets [s].Size << ", " << setw (2) << Sets [s].MaxTimes << ", " << Sets [s].NbCandies << ", {";
+			for (unsigned q (0); q < KNbQuantiles; ++q)
+				cout << (q ? ", " : " ") << setw (4) << Quantiles [s][q];
+			cout << " } }," << endl;
+		}
+		cout << "\t};" << endl;
+		cerr << Sets.size () * NbGames << " parties en " << fixed << setprecision (1) << ElapsedNs (Start) / 1e9 << " s" << endl;
+		return 0;
 
+	} // RunDifficultyTable ()
 
-		CMat Grid;
-		if (! LoadExistingSave)
-		{
-			ClearScreen ();
-			cout << '\t' << "Choisir un niveau de difficulté : " << endl << endl
-				 << "1 - Facile    : 6x6, 6 coups maximum, 4 numéros différents" << endl
-				 << "2 - Moyen     : 8x8, 9 coups maximum, 4 numéros différents" << endl
-				 << "3 - Difficile : 6x6, 8 coups maximum, 5 numéros différents" << endl
-				 << "4 - Expert    : 8x8, 11 coups maximum, 5 numéros différents" << endl << endl;
+#ifdef __linux__
 
-			unsigned ChoixLevel;
-			MenuPrompt (ChoixLevel, 4);
+	/*	BALAYAGE D'ÉQUILIBRAGE
 
-			switch (ChoixLevel)
-			{
-				case 1:
-					Size = 6;
-					MaxTimes = 6;
-					NbCandies = 4;
-					break;
-				case 2:
-					Size = 8;
-					MaxTimes = 9;
-					NbCandies = 4;
-					break;
-				case 3:
-					Size = 6;
-					MaxTimes = 8;
-					NbCandies = 5;
-					break;
-				case 4:
-					Size = 8;
-					MaxTimes = 11;
-					NbCandies = 5;
-					break;
-			}
+		Le mode --sweep joue un grand nombre de parties sur chaque configuration (les niveaux, ou des grilles choisies :
+		taille, coups, numéros) pour mesurer les scores qu'elles donnent. Les graines de chaque configuration sont découpées
+		en tranches (shards), jouées par des processus fils, autant à la fois que de cœurs : un fils qui plante n'emporte
+		que sa tranche. Chaque tranche écrit régulièrement où elle en est dans son fichier de reprise, remplacé d'un coup par
+		rename () : un balayage tué reprend là où il s'était arrêté en relançant la même commande. Comme la partie d'une
+		graine est toujours la même, le rapport est le même qu'avec un balayage d'une traite. Le père fusionne les
+		histogrammes et les totaux des tranches en un seul rapport. Fichiers du répertoire :
 
-			InitGrid (Grid, Size, NbCandies);
-		}
-		else
-		{
-			if (LoadSave (Grid, KeyTab, Score, BestScore, NbMoves, Size, MaxTimes)) // true si sauvegarde corrompue
-			{
-			    cout << "Sauvegarde corrompue" << endl
-			         << "Lancement d'une nouvelle partie..." << endl;
+			sweep.txt			paramètres du balayage, un autre balayage dans le même répertoire est refusé
+			shard_NNNN.ckpt		une CSweepCheckpoint par tranche (entiers dans l'ordre de la machine)
+			report.txt			le rapport, avec les histogrammes complets */
 
-				#ifdef _WIN32
-					Sleep (3000);
-				#else
-					sleep (3);
-				#endif
+	/** @brief Width of a bin of the score histograms */
+	const unsigned KSweepBinWidth = 10;
 
-				Size = 6;
-				MaxTimes = 6;
-				NbCandies = 4;
-			    InitGrid (Grid, Size, NbCandies);
-			    Score = 0;
-			    BestScore = 0;
-			    NbMoves = 0;
-		    }
-	    }
+	/** @brief Bins of the score histograms, the last one also holds every higher score */
+	const unsigned KSweepBins = 1024;
 
-		ClearScreen ();
-		while (NbMoves < MaxTimes)
-		{
-			DisplayGrid (Grid);
-			cout << "Il vous reste " << MaxTimes - NbMoves
-				 << (MaxTimes - NbMoves > 1 ? " coups" : " coup") << " à jouer." << endl // Affiche coup au singulier quand il n'en reste qu'un...
-				 << "Votre score est de " << Score << endl << endl;
+	/** @brief Seconds between two checkpoints of a shard */
+	const unsigned KCheckpointSeconds = 2;
 
-			CPosition CaseSelect;	// Position de la case sélectionnée par le joueur
-			char Direction;
+	const uint32_t KSweepVersion = 1;
 
-			if (InputMode == 0)
-			{
-				cout << "Saisir les coordonnées de la case à déplacer puis la case adjacente avec laquelle l'échanger" << endl;
-				#ifdef _WIN32
-					cout << "ou bien saisir CTRL+Z puis Entrée pour abandonner et revenir au menu" << endl;
-				#else
-					cout << "ou bien saisir CTRL+D pour abandonner et revenir au menu" << endl;
-				#endif
-				DisplayMovementKeys ();
+	/** @brief Totals of the games of a shard, or of a configuration once merged */
+	struct CSweepTotals
+	{
+		uint64_t NbGames;
+		uint64_t SumScores;
+		uint64_t SumSquares;		// Pour l'écart type
+		uint64_t NbMoves;
+		uint64_t NbReshuffles;
+		uint64_t NbEmptied;			// Parties finies faute de numéros pour remplir la grille
+		uint32_t MinScore;			// Sans objet tant que NbGames vaut 0
+		uint32_t MaxScore;
+		uint64_t Histogram [KSweepBins];
+	};
+
+	/** @brief Checkpoint of a shard : the games of the seeds [First, Next) are counted in Totals */
+	struct CSweepCheckpoint
+	{
+		char Magic [4];				// "KCSP"
+		uint32_t Version;
+		uint32_t Config;			// Indice de la configuration
+		uint32_t Padding;
+		uint64_t First;
+		uint64_t Last;
+		uint64_t Next;
+		CSweepTotals Totals;
+	};
+
+	/** @brief Parameters of a sweep */
+	struct CSweep
+	{
+		string Directory;
+		vector <CLevel> Configs;
+		uint64_t NbGames;			// Par configuration
+		unsigned NbShards;			// Par configuration
+		CPolicy Policy;
+	};
 
-				do {
-					do {
+	/**
+    *@brief Adds the totals of a shard to others
+    *@param Into the totals to complete
+    *@param From the totals to add
+    */
+	void MergeTotals (CSweepTotals & Into, const CSweepTotals & From)
+	{
+		if (From.NbGames == 0) return;
+		Into.MinScore = Into.NbGames == 0 ? From.MinScore : min (Into.MinScore, From.MinScore);
+		Into.MaxScore = Into.NbGames == 0 ? From.MaxScore : max (Into.MaxScore, From.MaxScore);
+		Into.NbGames += From.NbGames;
+		Into.SumScores += From.SumScores;
+		Into.SumSquares += From.SumSquares;
+		Into.NbMoves += From.NbMoves;
+		Into.NbReshuffles += From.NbReshuffles;
+		Into.NbEmptied += From.NbEmptied;
+		for (unsigned b (0); b < KSweepBins; ++b)
+			Into.Histogram [b] += From.Histogram [b];
+
+	} // MergeTotals ()
 
-						string Message;
-						unsigned NumFirst;
-						unsigned NumSecond;
+	/**
+    *@brief Seed of a game of the sweep, spread so that neighbouring games do not start alike
+    *@param Config the index of the configuration
+    *@param Game the number of the game in the configuration
+    */
+	uint32_t SweepSeed (unsigned Config, uint64_t Game)
+	{
+		uint64_t Seed ((Game << 8 | Config) * 0x9E3779B97F4A7C15ull);
+		Seed ^= Seed >> 29;
+		return uint32_t (Seed ^ Seed >> 32);
 
-						Message = InputLineFirst ? "Ligne : " : "Colonne : ";
-						SaisieLigneCol (NumFirst, Grid, Message);
-						if (cin.eof ()) break;
+	} // SweepSeed ()
 
-						Message = InputLineFirst ? "Colonne : " : "Ligne : ";
-						SaisieLigneCol (NumSecond, Grid, Message);
-						if (cin.eof ()) break;
+	/**
+    *@brief Path of the checkpoint of a shard
+    *@param Directory the directory of the sweep
+    *@param Shard the number of the shard
+    */
+	string CheckpointPath (const string & Directory, unsigned Shard)
+	{
+		ostringstream Path;
+		Path << Directory << "/shard_" << setw (4) << setfill ('0') << Shard << ".ckpt";
+		return Path.str ();
 
-						if (InputLineFirst)
-						{
-							CaseSelect.first = NumFirst - 1;  // L'utilisateur entre un nombre entre 1 et taille de la grille, il faut donc lui enlever 1
-							CaseSelect.second = NumSecond - 1;
-						}
-						else
-						{
-							CaseSelect.second = NumFirst - 1;
-							CaseSelect.first = NumSecond - 1;
-						}
+	} // CheckpointPath ()
 
-						if (! IsValidPosition (Grid, CaseSelect))
-							cout << endl << "Sélectionnez une case non vide" << endl;
+	/**
+    *@brief The first checkpoint of a shard, before any game
+    *@param Sweep the sweep
+    *@param Shard the number of the shard, over every configuration
+    */
+	CSweepCheckpoint FirstCheckpoint (const CSweep & Sweep, unsigned Shard)
+	{
+		CSweepCheckpoint Checkpoint;
+		memset (&Checkpoint, 0, sizeof (Checkpoint));
+		memcpy (Checkpoint.Magic, "KCSP", 4);
+		Checkpoint.Version = KSweepVersion;
+		Checkpoint.Config = Shard / Sweep.NbShards;
+		const unsigned Part (Shard % Sweep.NbShards);
+		Checkpoint.First = Sweep.NbGames * Part / Sweep.NbShards;
+		Checkpoint.Last = Sweep.NbGames * (Part + 1) / Sweep.NbShards;
+		Checkpoint.Next = Checkpoint.First;
+		return Checkpoint;
+
+	} // FirstCheckpoint ()
 
-					} while (! IsValidPosition (Grid, CaseSelect));
-					if (cin.eof ()) break;
+	/**
+    *@brief Reads the checkpoint of a shard
+    *@param Sweep the sweep
+    *@param Shard the number of the shard
+    *@param Checkpoint the checkpoint read, or the first one of the shard if its file is missing or does not match it
+    *@return false if the file was missing or did not match the shard
+    */
+	bool ReadCheckpoint (const CSweep & Sweep, unsigned Shard, CSweepCheckpoint & Checkpoint)
+	{
+		const CSweepCheckpoint First (FirstCheckpoint (Sweep, Shard));
+		ifstream File (CheckpointPath (Sweep.Directory, Shard), ios::binary);
+		if (File.read (reinterpret_cast <char *> (&Checkpoint), sizeof (Checkpoint)) && ! memcmp (Checkpoint.Magic, "KCSP", 4)
+			&& Checkpoint.Version == KSweepVersion && Checkpoint.Config == First.Config && Checkpoint.First == First.First
+			&& Checkpoint.Last == First.Last && Checkpoint.Next >= First.First && Checkpoint.Next <= First.Last
+			&& Checkpoint.Totals.NbGames == Checkpoint.Next - First.First)
+			return true;
 
-					SaisieCin (Direction, "Erreur de saisie", "Direction : ");
-					if (cin.eof ()) break;
-					while (! IsValidDirection (Direction))
-					{
-						cout << "Direction invalide" << endl;
-						SaisieCin (Direction, "Erreur de saisie", "Direction : ");
-					}
+		Checkpoint = First;
+		return false;
 
-					if (! IsValidMove (Grid, CaseSelect, Direction))
-						cout << "Mouvement impossible" << endl << endl;
+	} // ReadCheckpoint ()
 
-				} while (! IsValidMove (Grid, CaseSelect, Direction));
+	/**
+    *@brief Writes the checkpoint of a shard : to a temporary file, flushed to the disk, then renamed over the previous one
+    *@param Path the path of the checkpoint
+    *@param Checkpoint the checkpoint
+    */
+	bool WriteCheckpoint (const string & Path, const CSweepCheckpoint & Checkpoint)
+	{
+		const string Temporary (Path + ".tmp");
+		const int File (open (Temporary.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0644));
+		if (File < 0) return false;
+		const bool Written (write (File, &Checkpoint, sizeof (Checkpoint)) == ssize_t (sizeof (Checkpoint)) && fsync (File) == 0);
+		close (File);
+		return Written && rename (Temporary.c_str (), Path.c_str ()) == 0;
 
-			} // InputMode == 0
+	} // WriteCheckpoint ()
 
-			else
+	/**
+    *@brief Plays the games left in a shard, in a child process
+    *@param Sweep the sweep
+    *@param Shard the number of the shard
+    *@param Checkpoint where the shard is, completed as the games are played
+    */
+	bool PlaySweepShard (const CSweep & Sweep, unsigned Shard, CSweepCheckpoint & Checkpoint)
+	{
+		const string Path (CheckpointPath (Sweep.Directory, Shard));
+		const CLevel & Config (Sweep.Configs [Checkpoint.Config]);
+		CSweepTotals & Totals (Checkpoint.Totals);
+		CSession Session;
+		Session.Rules = &KRuleSets [CurrentRules];
+		CVMove Legal, Moves;
+		CMat Scratch;
+
+		chrono::steady_clock::time_point Saved (chrono::steady_clock::now ());
+		while (Checkpoint.Next < Checkpoint.Last)
+		{
+			NewSession (Session, Config, SweepSeed (Checkpoint.Config, Checkpoint.Next));
+			while (Session.End == KNotOver)
 			{
-				cout << "Saisir, séparées d'au moins un espace, "
-					 << (InputLineFirst ? "la ligne et la colonne" : "la colonne et la ligne")
-					 << " de la case sélectionnée et la direction vers laquelle l'échanger" << endl;
-				#ifdef _WIN32
-					cout << "ou bien saisir CTRL+Z puis Entrée pour abandonner et revenir au menu" << endl;
-				#else
-					cout << "ou bien saisir CTRL+D pour abandonner et revenir au menu" << endl;
-				#endif
-
-				DisplayMovementKeys ();
+				ListLegalMoves (Session, Legal);
+				if (Legal.empty ()) break;
 
-				if (NbMoves == 0)
-					cout << "ex : 2 3 z --> la case en colonne 2 et ligne 3 échange avec celle du haut" << endl; // Mini tuto au début du jeu
+				ResumePlay (Session, CPlayInput {KPlayMove, ChooseMove (Session, Sweep.Policy, Legal, Moves, Scratch, Session.Rand)});
+				if (Session.Reshuffled) ++Totals.NbReshuffles;
+			}
 
+			Totals.MinScore = Totals.NbGames == 0 ? Session.Score : min <uint32_t> (Totals.MinScore, Session.Score);
+			Totals.MaxScore = max <uint32_t> (Totals.MaxScore, Session.Score);
+			++Totals.NbGames;
+			Totals.SumScores += Session.Score;
+			Totals.SumSquares += uint64_t (Session.Score) * Session.Score;
+			Totals.NbMoves += Session.NbMoves;
+			if (Session.End == KNoCandiesLeft) ++Totals.NbEmptied;
+			++Totals.Histogram [min (Session.Score / KSweepBinWidth, KSweepBins - 1)];
+			++Checkpoint.Next;
+
+			if (ElapsedNs (Saved) >= KCheckpointSeconds * 1e9)
+			{
+				if (! WriteCheckpoint (Path, Checkpoint)) return false;
+				Saved = chrono::steady_clock::now ();
+			}
+		}
+		return WriteCheckpoint (Path, Checkpoint);
 
-				string Input;
-				istringstream iss;
-				bool InputMovement (true);
+	} // PlaySweepShard ()
 
-				while (InputMovement)
-				{
-					getline (cin, Input);  // On récupère la ligne saisie dans Input et on la charge dans iss
-					if (cin.eof ()) break;
-					iss.str (Input);
+	/**
+    *@brief Reads the configurations of a sweep
+    *@param List levels (1 to 4) and grids "size:moves:numbers", separated by ',', empty for every level
+    *@param Configs the configurations read
+    *@return false, after an error message, if one is invalid
+    */
+	bool ParseSweepConfigs (const string & List, vector <CLevel> & Configs)
+	{
+		Configs.clear ();
+		if (List.empty ())
+		{
+			Configs.assign (KLevels.begin (), KLevels.end ());
+			return true;
+		}
+		istringstream Stream (List);
+		string Item;
+		while (getline (Stream, Item, ','))
+		{
+			CLevel Config {0, 0, 0};
+			char Colon1 (0), Colon2 (0);
+			istringstream Fields (Item);
+			if (Item.find (':') == string::npos)
+			{
+				unsigned Level (0);
+				if (Fields >> Level && Level >= 1 && Level <= KLevels.size ()) Config = KLevels [Level - 1];
+			}
+			else
+				Fields >> Config.Size >> Colon1 >> Config.MaxTimes >> Colon2 >> Config.NbCandies;
 
-					InputLineFirst ? iss >> CaseSelect.first >> CaseSelect.second :
-									 iss >> CaseSelect.second >> CaseSelect.first;
+			if (Config.Size < 3 || Config.Size > 99 || Config.MaxTimes == 0 || Config.NbCandies < 3 || Config.NbCandies > RealMax
+				|| (Colon1 != 0 && (Colon1 != ':' || Colon2 != ':')) || ! (Fields >> ws).eof ())
+			{
+				cerr << "Configuration invalide : " << Item << " (un niveau de 1 à " << KLevels.size ()
+					 << ", ou taille:coups:numéros, taille de 3 à 99, de 3 à " << RealMax << " numéros)" << endl;
+				return false;
+			}
+			Configs.push_back (Config);
+		}
+		return ! Configs.empty ();
 
-					--CaseSelect.first; // Les indices commencent à 1 pour l'utilisateur donc il faut enlever 1 au nombre tapé
-					--CaseSelect.second;
+	} // ParseSweepConfigs ()
 
-					iss >> Direction;
+	/**
+    *@brief Writes the report of a sweep, merged from the checkpoints of its shards
+    *@param Sweep the sweep
+    *@param Report the summary of each configuration
+    *@param Histograms the histograms of the scores
+    */
+	void ReportSweep (const CSweep & Sweep, ostream & Report, ostream & Histograms)
+	{
+		for (unsigned c (0); c < Sweep.Configs.size (); ++c)
+		{
+			CSweepTotals Totals;
+			memset (&Totals, 0, sizeof (Totals));
+			for (unsigned s (c * Sweep.NbShards); s < (c + 1) * Sweep.NbShards; ++s)
+			{
+				CSweepCheckpoint Checkpoint;
+				ReadCheckpoint (Sweep, s, Checkpoint);
+				MergeTotals (Totals, Checkpoint.Totals);
+			}
 
+			const CLevel & Config (Sweep.Configs [c]);
+			Report << "Grille " << Config.Size << 'x' << Config.Size << ", " << Config.MaxTimes << " coups, " << Config.NbCandies
+				   << " numéros : " << Totals.NbGames << " parties" << endl;
+			if (Totals.NbGames == 0) continue;
 
-					if (iss.fail ()) // Si l'injection d'une des variables n'a pas pu se faire, càd la commande n'est pas valide, iss passe en fail
-					{
-						cout << "Erreur de saisie" << endl;
-						iss.clear ();
-					}
+			/* Les centiles sont lus dans l'histogramme, à la largeur d'une case près */
+			const double Mean (double (Totals.SumScores) / Totals.NbGames);
+			auto Percentile = [&] (double P)
+			{
+				uint64_t Seen (0);
+				unsigned b (0);
+				while (b + 1 < KSweepBins && (Seen += Totals.Histogram [b]) < P * Totals.NbGames) ++b;
+				ostringstream Bin;
+				Bin << b * KSweepBinWidth << '-' << (b + 1) * KSweepBinWidth - 1;
+				return Bin.str ();
+			};
+			Report << fixed << setprecision (1)
+				   << "  score moyen " << Mean << ", écart type " << sqrt (max (0., double (Totals.SumSquares) / Totals.NbGames - Mean * Mean))
+				   << ", min " << Totals.MinScore << ", p10 " << Percentile (0.1) << ", médiane " << Percentile (0.5)
+				   << ", p90 " << Percentile (0.9) << ", p99 " << Percentile (0.99) << ", max " << Totals.MaxScore << endl
+				   << setprecision (2) << "  coups par partie " << double (Totals.NbMoves) / Totals.NbGames
+				   << ", mélanges par partie " << double (Totals.NbReshuffles) / Totals.NbGames
+				   << ", parties finies faute de numéros " << Totals.NbEmptied << endl;
+
+			Histograms << "Grille " << Config.Size << 'x' << Config.Size << ", " << Config.MaxTimes << " coups, "
+					   << Config.NbCandies << " numéros, scores par tranche de " << KSweepBinWidth << " :" << endl;
+			for (unsigned b (0); b < KSweepBins; ++b)
+				if (Totals.Histogram [b] != 0)
+					Histograms << "  " << b * KSweepBinWidth << (b + 1 == KSweepBins ? "+" : "") << '\t' << Totals.Histogram [b] << endl;
+		}
 
-					/* Si la commande est valide, on teste les valeurs saisies */
-					else if (! IsValidPosition (Grid, CaseSelect))
-						cout << "Case sélectionnée invalide" << endl;
+	} // ReportSweep ()
 
-					else if (! IsValidDirection (Direction))
-						cout << "Direction invalide" << endl;
+	/**
+    *@brief Balance sweep (mode --sweep) : plays the seeds of every configuration in shards, one child process per shard
+    *       and as many at once as cores, with checkpoints to resume a killed sweep, then merges the shards in a report
+    *@param Directory the directory of the checkpoints and of the report
+    *@param NbGames how many games per configuration
+    *@param NbShards how many shards per configuration
+    *@param NbProcesses how many shards at once, 0 for one per core
+    *@param PolicyName random, scoring or greedy
+    *@param ConfigList the configurations, see ParseSweepConfigs ()
+    */
+	int RunSweep (const string & Directory, uint64_t NbGames, unsigned NbShards, unsigned NbProcesses, const string & PolicyName,
+				  const string & ConfigList)
+	{
+		CSweep Sweep;
+		Sweep.Directory = Directory;
+		Sweep.NbGames = NbGames;
+		Sweep.NbShards = NbShards;
+		if (! FindPolicy (PolicyName, Sweep.Policy) || ! ParseSweepConfigs (ConfigList, Sweep.Configs)) return 1;
+		if (NbGames == 0 || NbShards == 0 || NbShards > NbGames)
+		{
+			cerr << "Il faut au moins une partie par tranche" << endl;
+			return 1;
+		}
+		if (NbProcesses == 0) NbProcesses = max (1u, thread::hardware_concurrency ());
 
-					else if (! IsValidMove (Grid, CaseSelect, Direction))
-						cout << "Mouvement impossible" << endl;
+		/* Les reprises ne valent que pour le même balayage */
+		ostringstream Parameters;
+		Parameters << "KCSW " << KSweepVersion << endl << "rules " << KRuleSets [CurrentRules].Id << endl << "policy " << PolicyName
+				   << endl << "games " << NbGames << endl << "shards " << NbShards << endl;
+		for (const CLevel & Config : Sweep.Configs)
+			Parameters << "config " << Config.Size << ' ' << Config.MaxTimes << ' ' << Config.NbCandies << endl;
 
+		if (mkdir (Directory.c_str (), 0755) != 0 && errno != EEXIST)
+		{
+			cerr << "Impossible de créer " << Directory << " : " << strerror (errno) << endl;
+			return 1;
+		}
+		const string ParametersPath (Directory + "/sweep.txt");
+		ifstream Previous (ParametersPath);
+		if (Previous)
+		{
+			if (string (istreambuf_iterator <char> (Previous), istreambuf_iterator <char> ()) != Parameters.str ())
+			{
+				cerr << Directory << " contient un autre balayage, voir " << ParametersPath << endl;
+				return 1;
+			}
+		}
+		else if (! (ofstream (ParametersPath) << Parameters.str ()))
+		{
+			cerr << "Impossible d'écrire " << ParametersPath << endl;
+			return 1;
+		}
 
-					else  // Si toutes les conditions sont remplies, on met InputMovement à false ce qui fait sortir de la boucle
-						InputMovement = false;
+		const unsigned NbAllShards (NbShards * Sweep.Configs.size ());
+		vector <unsigned> Pending;
+		uint64_t NbLeft (0);
+		for (unsigned s (0); s < NbAllShards; ++s)
+		{
+			CSweepCheckpoint Checkpoint;
+			ReadCheckpoint (Sweep, s, Checkpoint);
+			if (Checkpoint.Next == Checkpoint.Last) continue;
+			Pending.push_back (s);
+			NbLeft += Checkpoint.Last - Checkpoint.Next;
+		}
+		cout << Sweep.Configs.size () << " configurations, " << NbGames << " parties chacune, stratégie " << PolicyName << ", "
+			 << NbAllShards << " tranches dont " << Pending.size () << " à jouer (" << NbLeft << " parties), "
+			 << NbProcesses << " processus" << endl;
+
+		/* Un fils par tranche : il relit sa reprise, joue, et meurt avec son père si celui-ci est tué */
+		const chrono::steady_clock::time_point Start (chrono::steady_clock::now ());
+		const pid_t Parent (getpid ());
+		vector <pair <pid_t, unsigned>> Running;
+		unsigned NbStarted (0), NbFinished (0), NbFailed (0);
+		while (NbStarted < Pending.size () || ! Running.empty ())
+		{
+			while (Running.size () < NbProcesses && NbStarted < Pending.size ())
+			{
+				const unsigned Shard (Pending [NbStarted]);
+				cout.flush ();
+				const pid_t Child (fork ());
+				if (Child == 0)
+				{
+					prctl (PR_SET_PDEATHSIG, SIGKILL);
+					if (getppid () != Parent) _exit (1);
+					CSweepCheckpoint Checkpoint;
+					ReadCheckpoint (Sweep, Shard, Checkpoint);
+					_exit (PlaySweepShard (Sweep, Shard, Checkpoint) ? 0 : 1);
+				}
+				if (Child < 0)
+				{
+					if (Running.empty ())
+					{
+						cerr << "fork : " << strerror (errno) << endl;
+						return 1;
+					}
+					break;
 				}
+				Running.push_back (make_pair (Child, Shard));
+				++NbStarted;
+			}
 
-			} // InputMode == 1
+			int Status (0);
+			const pid_t Child (waitpid (-1, &Status, 0));
+			if (Child < 0)
+			{
+				if (errno == EINTR) continue;
+				cerr << "waitpid : " << strerror (errno) << endl;
+				return 1;
+			}
+			const auto Done (find_if (Running.begin (), Running.end (), [Child] (const pair <pid_t, unsigned> & Run) { return Run.first == Child; }));
+			if (Done == Running.end ()) continue;
+			const unsigned Shard (Done -> second);
+			Running.erase (Done);
 
-			if (cin.eof ()) break;
-			MakeAMove (Grid, CaseSelect, Direction);  // On a vérifié précédemment que le mouvement était valide
-			ArrangeGrid (Grid, Score);
-			++NbMoves;
-			Save (Grid, NbMoves, Score, BestScore, Size, KeyTab, MaxTimes);
+			if (WIFEXITED (Status) && WEXITSTATUS (Status) == 0)
+				++NbFinished;
+			else
+			{
+				++NbFailed;
+				cerr << endl << "La tranche " << Shard << " a échoué (" << CheckpointPath (Directory, Shard) << ")" << endl;
+			}
+			cout << "\rTranches finies : " << NbFinished << '/' << Pending.size () << flush;
 		}
+		const double Seconds (ElapsedNs (Start) / 1e9);
+		if (! Pending.empty ())
+			cout << endl << fixed << setprecision (0) << NbLeft / Seconds << " parties/s sur " << NbProcesses << " processus, "
+				 << setprecision (1) << Seconds << " s" << endl;
 
-		if (! cin.eof ())
+		if (NbFailed != 0)
 		{
-			DisplayGrid (Grid);
-			cout << "Jeu terminé ! Votre score final est de " << Score << endl
-				 << "Tapez Entrée pour revenir au menu";
-			string B;
-			getline (cin, B);
+			cerr << NbFailed << " tranches ont échoué, relancez la même commande pour les reprendre" << endl;
+			return 1;
 		}
 
-		cin.clear ();
+		ostringstream Report, Histograms;
+		ReportSweep (Sweep, Report, Histograms);
+		cout << Report.str ();
+		const string ReportPath (Directory + "/report.txt");
+		if (! (ofstream (ReportPath) << Parameters.str () << endl << Report.str () << endl << Histograms.str ()))
+		{
+			cerr << "Impossible d'écrire " << ReportPath << endl;
+			return 1;
+		}
+		cout << "Rapport complet : " << ReportPath << endl;
+		return 0;
 
-	} // Game ()
+	} // RunSweep ()
+
+#endif // __linux__
 
 } // namespace
 
 
 using namespace KittyCrush;
 
-int main ()
+#ifdef KITTY_FUZZ
+
+/* Point d'entrée de libFuzzer, qui remplace main () : clang++ -std=c++11 -g -O1 -fsanitize=fuzzer,address -DKITTY_FUZZ
+   KittyCrush.cxx -o KittyFuzz, puis ./KittyFuzz fuzz/saves. L'entrée est une sauvegarde telle quelle, pour que le
+   recueil serve aussi à --fuzz-saves ; sa longueur choisit la taille des morceaux donnés au lecteur */
+extern "C" int LLVMFuzzerTestOneInput (const uint8_t * Data, size_t Size)
 {
-	DisplayTitleScreen ();
+	CSaveError Error;
+	if (! FuzzSave (reinterpret_cast <const char *> (Data), Size, Size % 61 + 1, Error)) abort ();
+	return 0;
+
+} // LLVMFuzzerTestOneInput ()
 
-	/* Met le jeu en pause pour x secondes */
-	#ifdef _WIN32
-		Sleep (3000);
-	#else
-		sleep (3);
+#else
+
+int main (int argc, char * argv [])
+{
+	/* --rules <variante> choisit les règles des parties, --broadcast <fichier> les diffuse aux spectateurs, puis les autres
+	   arguments sont lus comme d'habitude */
+	while (argc > 2 && (string (argv [1]) == "--rules" || string (argv [1]) == "--broadcast"))
+	{
+		if (string (argv [1]) == "--rules")
+		{
+			CurrentRules = FindRuleSet (argv [2]);
+			if (CurrentRules == KRuleSets.size ())
+			{
+				cerr << "Règles inconnues : " << argv [2] << endl << "Règles possibles :";
+				for (const CRuleSet & Rules : KRuleSets) cerr << ' ' << Rules.Id;
+				cerr << endl;
+				return 1;
+			}
+		}
+		else
+		{
+			#ifndef _WIN32
+				if (! Broadcast.Open (argv [2]))
+				{
+					cerr << "Impossible de diffuser dans " << argv [2] << " : " << strerror (errno) << endl;
+					return 1;
+				}
+			#else
+				cerr << "Diffusion non disponible sous Windows" << endl;
+				return 1;
+			#endif
+		}
+		argv [2] = argv [0];
+		argv += 2;
+		argc -= 2;
+	}
+
+	/* Modes en ligne de commande, sans interface */
+	if (argc > 1 && string (argv [1]) == "--bench")
+		return RunBenchmark ();
+	if (argc > 1 && string (argv [1]) == "--check-alloc")
+		return RunAllocationCheck ();
+	if (argc > 1 && string (argv [1]) == "--check-engines")
+		return RunEngineCheck (argc > 2 ? strtoull (argv [2], NULL, 10) : 1000000, argc > 3 ? strtoul (argv [3], NULL, 10) : 0,
+							   argc > 4 ? argv [4] : "divergence.kcrp");
+	if (argc > 2 && string (argv [1]) == "--check-replay")
+		return RunReplayCheck (argv [2]);
+	if (argc > 1 && string (argv [1]) == "--fuzz-saves")
+		return RunSaveFuzzer (argc > 2 ? strtoul (argv [2], NULL, 10) : 10, vector <string> (argv + min (argc, 3), argv + argc));
+	if (argc > 2 && string (argv [1]) == "--dataset")
+		return RunDatasetGenerator (argv [2], argc > 3 ? strtoull (argv [3], NULL, 10) : 1000000, argc > 4 ? argv [4] : "scoring",
+									argc > 5 ? strtoul (argv [5], NULL, 10) : 0);
+	if (argc > 1 && string (argv [1]) == "--difficulty-table")
+		return RunDifficultyTable (argc > 2 ? strtoull (argv [2], NULL, 10) : 20000, argc > 3 ? strtoul (argv [3], NULL, 10) : 0);
+	if (argc > 2 && string (argv [1]) == "--dataset-read")
+		return RunDatasetReader (vector <string> (argv + 2, argv + argc));
+	if (argc > 6 && string (argv [1]) == "--puzzles")
+	{
+		const unsigned Level (strtoul (argv [3], NULL, 10));
+		if (Level < 1 || Level > KLevels.size ()) return 1;
+		return RunPuzzleGenerator (argv [2], KLevels [Level - 1], strtoul (argv [4], NULL, 10), strtoul (argv [5], NULL, 10),
+								   strtoul (argv [6], NULL, 10), argc > 7 ? strtoul (argv [7], NULL, 10) : 0,
+								   argc > 8 ? strtoul (argv [8], NULL, 10) : 0);
+	}
+	if (argc > 2 && string (argv [1]) == "--script")
+	{
+		const unsigned Level (argc > 3 ? strtoul (argv [3], NULL, 10) : 1);
+		if (Level < 1 || Level > KLevels.size ()) return 1;
+		const uint32_t Seed (argc > 4 ? strtoul (argv [4], NULL, 10) : time (NULL));
+		if (string (argv [2]) == "-") return RunScript (cin, KLevels [Level - 1], Seed);
+		ifstream Script (argv [2]);
+		if (! Script)
+		{
+			cerr << "Impossible d'ouvrir " << argv [2] << endl;
+			return 1;
+		}
+		return RunScript (Script, KLevels [Level - 1], Seed);
+	}
+	if (argc > 3 && string (argv [1]) == "--puzzle")
+	{
+		CPuzzle Puzzle;
+		if (! LoadPuzzle (argv [2], strtoul (argv [3], NULL, 10), Puzzle))
+		{
+			cerr << argv [2] << " : pas de puzzle " << argv [3] << endl;
+			return 1;
+		}
+		Game (array <unsigned, 2> {0, 0}, false, FreeSlot (), &Puzzle);
+		return 0;
+	}
+	#ifndef _WIN32
+		if (argc > 2 && string (argv [1]) == "--record")
+		{
+			const unsigned Level (argc > 4 ? strtoul (argv [4], NULL, 10) : 1);
+			if (Level < 1 || Level > KLevels.size ()) return 1;
+			return RunReplayRecorder (argv [2], argc > 3 ? strtoull (argv [3], NULL, 10) : 100000, KLevels [Level - 1],
+									  argc > 5 ? argv [5] : "scoring");
+		}
+		if (argc > 3 && string (argv [1]) == "--replay")
+			return RunReplay (argv [2], strtoull (argv [3], NULL, 10));
+		if (argc > 2 && string (argv [1]) == "--replays")
+			return RunReplays (argv [2], argc > 3 ? strtoul (argv [3], NULL, 10) : 0, argc > 4 && string (argv [4]) == "check");
+		if (argc > 2 && string (argv [1]) == "--watch")
+			return RunWatch (argv [2], argc > 3 ? strtoul (argv [3], NULL, 10) : 0);
+		if (argc > 2 && string (argv [1]) == "--bot")
+			return RunBotHost (argv [2], argc > 3 ? strtoul (argv [3], NULL, 10) : 300);
+		if (argc > 2 && string (argv [1]) == "--bot-bench")
+		{
+			const unsigned Level (argc > 4 ? strtoul (argv [4], NULL, 10) : 1);
+			if (Level < 1 || Level > KLevels.size ()) return 1;
+			return RunBotBench (argv [2], argc > 3 ? strtoul (argv [3], NULL, 10) : 100000, Level);
+		}
+		if (argc > 1 && string (argv [1]) == "--bench-scores")
+			return RunScoresBenchmark (argc > 2 ? strtoul (argv [2], NULL, 10) : 1000000);
+		if (argc > 1 && string (argv [1]) == "--time-attack")
+		{
+			const unsigned Level (argc > 2 ? strtoul (argv [2], NULL, 10) : 1);
+			if (Level < 1 || Level > KLevels.size ()) return 1;
+			return RunTimeAttack (KLevels [Level - 1], argc > 3 ? strtoul (argv [3], NULL, 10) : 60, true,
+								  argc > 4 ? strtoul (argv [4], NULL, 10) : 0);
+		}
 	#endif
+	#ifdef __linux__
+		if (argc > 2 && string (argv [1]) == "--server")
+			return RunServer (argv [2], argc > 3 ? strtoul (argv [3], NULL, 10) : 300);
+		if (argc > 2 && string (argv [1]) == "--loadgen")
+			return RunLoadGenerator (argv [2], argc > 3 ? strtoul (argv [3], NULL, 10) : 1000, argc > 4 ? strtoul (argv [4], NULL, 10) : 10);
+		if (argc > 2 && string (argv [1]) == "--sweep")
+			return RunSweep (argv [2], argc > 3 ? strtoull (argv [3], NULL, 10) : 100000, argc > 4 ? strtoul (argv [4], NULL, 10) : 64,
+							 argc > 5 ? strtoul (argv [5], NULL, 10) : 0, argc > 6 ? argv [6] : "greedy", argc > 7 ? argv [7] : "");
+	#endif
+
+	DisplayTitleScreen ();
+	WaitSplash ();
 
 	/** @brief An array containing the options chosen in the options menu */
 	array <unsigned, 2> OptionsChoices {0, 0}; // Dans l'ordre : mode de saisie, ordre de saisie ligne/colonne
 	/** @brief Message to display below the main menu */
     string ErrorMsg ("");
-	const unsigned ValeurChoixMax (5);
+	const unsigned ValeurChoixMax (7);
 	unsigned Choix (0);
 
 	do {
@@ -1243,13 +10187,16 @@ int main ()
 		switch (Choix)
 		{
 			case 1:
-				Game (OptionsChoices, false); // Lance le jeu
+				Game (OptionsChoices, false, FreeSlot ()); // Lance le jeu
 				break;
 			case 2:
-			    if (ExistingSave ())
-				    Game (OptionsChoices, true);
-			    else
-			        ErrorMsg = "Pas de sauvegarde disponible";
+				if (ExistingSave ())
+				{
+					const unsigned Slot (ChooseSave ());
+					if (Slot < KNbSlots) Game (OptionsChoices, true, Slot);
+				}
+				else
+					ErrorMsg = "Pas de sauvegarde disponible";
 				break;
 			case 3:
 				DisplayOptions (OptionsChoices);
@@ -1257,6 +10204,20 @@ int main ()
 			case 4:
 				DisplayCredits ();
 				break ;
+			case 5:
+				#ifndef _WIN32
+					DisplayBestScores ();
+				#else
+					ErrorMsg = "Tableau des scores non disponible sous Windows";
+				#endif
+				break ;
+			case 6:
+				#ifndef _WIN32
+					TimeAttack (OptionsChoices);
+				#else
+					ErrorMsg = "Contre la montre non disponible sous Windows";
+				#endif
+				break ;
 		}
 
 	} while (Choix != ValeurChoixMax); // Si Choix vaut la dernière option, on quitte
@@ -1266,3 +10227,5 @@ int main ()
     return 0;
 
 } // main ()
+
+#endif // KITTY_FUZZ